@@ -38,6 +38,4 @@
 # define hd_disable_threads()          0
 #endif
 
-void hd_mutex_enable (int setting);
-
 #endif
@@ -689,6 +689,12 @@ hd_home_view_container_allocate (ClutterActor          *self,
             if (CLUTTER_ACTOR_IS_VISIBLE(priv->views[i]))
               clutter_actor_hide(priv->views[i]);
           }
+
+        /* Views which are just passing by needn't paint their applets
+         * one by one. */
+        hd_home_view_set_applets_cached (HD_HOME_VIEW (priv->views[i]),
+                           CLUTTER_ACTOR_IS_VISIBLE (priv->views[i])
+                           && (i != priv->current_view || offset != 0));
       }
   }
   else
@@ -737,6 +743,12 @@ hd_home_view_container_allocate (ClutterActor          *self,
             if (CLUTTER_ACTOR_IS_VISIBLE(priv->views[i]))
               clutter_actor_hide(priv->views[i]);
           }
+
+        /* Views which are just passing by needn't paint their applets
+         * one by one. */
+        hd_home_view_set_applets_cached (HD_HOME_VIEW (priv->views[i]),
+                           CLUTTER_ACTOR_IS_VISIBLE (priv->views[i])
+                           && (i != priv->current_view || offset != 0));
       }
   }
 }
@@ -31,13 +31,16 @@
 #include "hd-comp-mgr.h"
 #include "hd-home.h"
 #include "hd-util.h"
+#include "hd-scheduler.h"
 #include "hd-home-applet.h"
 #include "hd-render-manager.h"
 #include "hd-clutter-cache.h"
 #include "hd-transition.h"
+#include "hd-wallpaper-cache.h"
 
 #include "hildon-desktop.h"
 #include "../tidy/tidy-sub-texture.h"
+#include "../tidy/tidy-cached-group.h"
 
 #include <clutter/clutter.h>
 #include <clutter/x11/clutter-x11.h>
@@ -85,14 +88,12 @@ struct _HdHomeViewPrivate
 
   ClutterActor             *background;
   TidySubTexture           *background_sub;
-  ClutterActor             *background_temp_portrait;
-  TidySubTexture           *background_sub_temp_portrait;
-  ClutterActor             *background_temp;
-  TidySubTexture           *background_sub_temp;
   MBWindowManagerClient    *live_bg;
 
   GHashTable               *applets;
 
+  /* Whether @background is the portrait wallpaper.  The wallpaper of
+   * the other orientation is only kept in the wallpaper cache. */
   gboolean                  is_portrait;
 
   gint                      applet_motion_start_x;
@@ -377,7 +378,13 @@ hd_home_view_constructed (GObject *object)
                            priv->background_container);
   clutter_container_add_actor (CLUTTER_CONTAINER (object), priv->background_container);
 
-  priv->applets_container = clutter_group_new ();
+  /* The applets are painted from a flattened image while the view is
+   * scrolled, see hd_home_view_set_applets_cached(). */
+  priv->applets_container = tidy_cached_group_new ();
+  tidy_cached_group_set_downsampling_factor (priv->applets_container, 1);
+  tidy_cached_group_set_use_alpha (priv->applets_container, TRUE);
+  tidy_cached_group_set_refresh_interval (priv->applets_container,
+       hd_transition_get_int ("home", "applets_cache_refresh", 250));
   clutter_actor_set_name (priv->applets_container, "HdHomeView::applets-container");
   clutter_actor_set_visibility_detect(priv->applets_container, FALSE);
   clutter_actor_set_position (priv->applets_container, 0, 0);
@@ -437,7 +444,7 @@ hd_home_view_dispose (GObject *object)
 
   /* Remove idle/timeout handlers */
   if (priv->load_background_source)
-    priv->load_background_source = (g_source_remove (priv->load_background_source), 0);
+    priv->load_background_source = (hd_scheduler_remove (priv->load_background_source), 0);
 
   if (priv->gconf_client)
     priv->gconf_client = (g_object_unref (priv->gconf_client), NULL);
@@ -506,29 +513,6 @@ set_background_common (HdHomeView *hview, ClutterActor *new_bg)
 
   clutter_actor_set_name (new_bg, "HdHomeView::background");
 
-  if(hd_home_is_portrait_wallpaper_enabled (priv->home))
-    {
-      if(priv->is_portrait)
-        { /* Remember wallpaper for portrait mode */
-          clutter_actor_destroy(priv->background_temp_portrait);
-          clutter_actor_destroy(CLUTTER_ACTOR(priv->background_sub_temp_portrait));
-          priv->background_temp_portrait = new_bg;
-          priv->background_sub_temp_portrait = new_bg_sub;
-        }
-      else
-        { /* Remember wallpaper for landscape mode and show it */
-          clutter_actor_destroy(priv->background_temp);
-          clutter_actor_destroy(CLUTTER_ACTOR(priv->background_sub_temp));
-          priv->background_temp = new_bg;
-          priv->background_sub_temp = new_bg_sub;
-        }
-    }
-
-    if( ((hd_comp_mgr_is_portrait () && !priv->is_portrait) 
-      || (!hd_comp_mgr_is_portrait () && priv->is_portrait)) 
-      && hd_home_is_portrait_wallpaper_enabled (priv->home))
-      return;
-
     /* Add new background to the background container */
     clutter_container_add_actor (
                 CLUTTER_CONTAINER (priv->background_container),
@@ -554,176 +538,93 @@ set_background_common (HdHomeView *hview, ClutterActor *new_bg)
     
 }
 
-static gboolean
-load_background_idle (gpointer data)
+/* Returns the wallpaper of @view for the given orientation or NULL. */
+static ClutterActor *
+hd_home_view_load_wallpaper (HdHomeView *view, gboolean portrait)
 {
-  HdHomeView *self = HD_HOME_VIEW (data);
-  HdHomeViewPrivate *priv = self->priv;
+  HdHomeViewPrivate *priv = view->priv;
   gchar *cached_background_image_file;
-  ClutterActor *new_bg = 0;
+  ClutterActor *new_bg;
   GError *error = NULL;
-  GError *error_portrait = NULL;
-  int i;
-  int max_value;
-
-  if (g_source_is_destroyed (g_main_current_source ()))
-    return FALSE;
 
-  if(hd_home_is_portrait_wallpaper_enabled (priv->home))
-    max_value = 2;
+  cached_background_image_file = g_strdup_printf (portrait
+                                   ? CACHED_BACKGROUND_IMAGE_FILE_PNG_PORTRAIT
+                                   : CACHED_BACKGROUND_IMAGE_FILE_PNG,
+                                   g_get_home_dir (), priv->id + 1);
+  if (g_file_test (cached_background_image_file, G_FILE_TEST_EXISTS))
+    /* We want it dithered to 16 bits, which is done only once
+     * per wallpaper change. */
+    new_bg = hd_wallpaper_cache_load (cached_background_image_file, &error);
   else
-    max_value = 1;
+    {
+      g_free (cached_background_image_file);
+      cached_background_image_file = g_strdup_printf (portrait
+                                   ? CACHED_BACKGROUND_IMAGE_FILE_PVR_PORTRAIT
+                                   : CACHED_BACKGROUND_IMAGE_FILE_PVR,
+                                   g_get_home_dir (), priv->id + 1);
+      new_bg = clutter_texture_new_from_file (cached_background_image_file,
+                                              &error);
+    }
 
-  for(i = 0; i < max_value; i++){
-    if(!i)
-      {
-        cached_background_image_file = g_strdup_printf (CACHED_BACKGROUND_IMAGE_FILE_PNG,
-                                                        g_get_home_dir (),
-                                                        priv->id + 1);
-        priv->is_portrait = FALSE;
-      }
-    else
-      {
-        cached_background_image_file = g_strdup_printf (CACHED_BACKGROUND_IMAGE_FILE_PNG_PORTRAIT,
-                                                        g_get_home_dir (),
-                                                        priv->id + 1);
-        priv->is_portrait = TRUE;
-      }
+  if (!new_bg)
+    {
+      g_warning ("Error loading cached %sbackground image %s. %s",
+                 portrait ? "portrait " : "",
+                 cached_background_image_file,
+                 error?error->message:"");
+      if (error)
+        g_error_free (error);
+    }
 
-    if (!g_file_test (cached_background_image_file,
-                      G_FILE_TEST_EXISTS))
-      {
-        g_free (cached_background_image_file);
-        if(!i) 
-          {
-            cached_background_image_file = g_strdup_printf (CACHED_BACKGROUND_IMAGE_FILE_PVR,
-                                                            g_get_home_dir (),
-                                                            priv->id + 1);
-
-            new_bg = clutter_texture_new_from_file (cached_background_image_file,
-                                                      &error);
-          }
-        else 
-          {
-            cached_background_image_file = g_strdup_printf (CACHED_BACKGROUND_IMAGE_FILE_PVR_PORTRAIT,
-                                                            g_get_home_dir (),
-                                                            priv->id + 1);
-
-            new_bg = clutter_texture_new_from_file (cached_background_image_file,
-                                                    &error_portrait);
-          }
-      }
-    else
-      {
-        GdkPixbuf        *pixbuf;
-
-        /* Load image directly. We actually want to dither it on the fly to
-         * 16 bit, and clutter doesn't do this for us so we implement a very
-         * quick dither here. */
-        if(!i) 
-          pixbuf = gdk_pixbuf_new_from_file (cached_background_image_file, &error);
-        else
-          pixbuf = gdk_pixbuf_new_from_file (cached_background_image_file, &error_portrait);
-          
-        if (pixbuf != NULL)
-          {
-            gint              width;
-            gint              height;
-            gint              rowstride;
-            gint              n_channels;
-            guchar           *pixels;
-            gushort          *out_pixels, *out;
-            guint             lfsr = 1;
-            gint x,y;
-
-            /* Get pixbuf properties */
-            width           = gdk_pixbuf_get_width (pixbuf);
-            height          = gdk_pixbuf_get_height (pixbuf);
-            rowstride       = gdk_pixbuf_get_rowstride (pixbuf);
-            n_channels      = gdk_pixbuf_get_n_channels (pixbuf);
-            pixels          = gdk_pixbuf_get_pixels (pixbuf);
-
-            if (gdk_pixbuf_get_bits_per_sample (pixbuf)==8 &&
-                (n_channels==3 || n_channels==4))
-              {
-                out_pixels = g_malloc(width*height*2);
-                out = out_pixels;
-                for (y=0;y<height;y++) {
-                  for (x=0;x<width;x++) {
-                    /* http://en.wikipedia.org/wiki/Linear_feedback_shift_register */
-                    lfsr = (lfsr >> 1) ^ (unsigned int)((0 - (lfsr & 1u)) & 0xd0000001u);
-  
-                    /* dither 565 - by adding random noise and then truncating
-                     * (r>>8)*0xFF makes sure our bottom 8 bits are 0xFF if we
-                     * overflow.
-                     */
-                    guint r,g,b;
-                    r = pixels[0] + (lfsr&7);
-                    r |= (r>>8)*0xFF;
-                    g = pixels[1] + ((lfsr>>3)&3);
-                    g |= (g>>8)*0xFF;
-                    b = pixels[2] + ((lfsr>>5)&7);
-                    b |= (b>>8)*0xFF;
-                    *out = ((r<<8)&0xF800) |
-                           ((g<<3)&0x07E0) |
-                           ((b>>3)&0x001F);
-
-                    pixels += n_channels;
-                    out++;
-                  }
-                  pixels += rowstride - width*n_channels;
-                }
-                new_bg = clutter_texture_new();
-
-                if(!i) 
-                  {
-                    clutter_texture_set_from_rgb_data(CLUTTER_TEXTURE(new_bg),
-                          (guchar*)out_pixels, FALSE,
-                          width, height, width*2, 2, CLUTTER_TEXTURE_FLAG_16_BIT, &error);
-                  }
-                else 
-                  {
-                    clutter_texture_set_from_rgb_data(CLUTTER_TEXTURE(new_bg),
-                          (guchar*)out_pixels, FALSE,
-                          width, height, width*2, 2, CLUTTER_TEXTURE_FLAG_16_BIT, &error_portrait);
-                  }
-
-                g_free(out_pixels);
-              }
-            g_object_unref (pixbuf);
-          }
-      }
+  g_free (cached_background_image_file);
+  return new_bg;
+}
 
-    if(!i) 
-      {
-        if (!new_bg)
-          {
-            g_warning ("Error loading cached background image %s. %s",
-                       cached_background_image_file,
-                       error?error->message:"");
-            if (error)
-              g_error_free (error);
-          }
-      }
-    else
-      {
-        if (!new_bg)
-          {
-            g_warning ("Error loading cached portrait background image %s. %s",
-                       cached_background_image_file,
-                       error_portrait?error_portrait->message:"");
-            if (error_portrait)
-              g_error_free (error_portrait);
-          }
-      }
-  
-    g_free (cached_background_image_file);
+/* Is the wallpaper for portrait mode what we should show now? */
+static gboolean
+hd_home_view_wants_portrait_wallpaper (HdHomeView *view)
+{
+  return hd_home_is_portrait_wallpaper_enabled (view->priv->home)
+    && STATE_IS_PORTRAIT (hd_render_manager_get_state ());
+}
 
-    set_background_common (self, new_bg);  
-    priv->load_background_source = 0;
-  }
+/* Converts the wallpaper @data for the cache, not to be in anyone's way. */
+static gboolean
+prepare_wallpaper_idle (gpointer data)
+{
+  hd_wallpaper_cache_prepare (data);
+  return FALSE;
+}
+
+static gboolean
+load_background_idle (gpointer data)
+{
+  HdHomeView *self = HD_HOME_VIEW (data);
+  HdHomeViewPrivate *priv = self->priv;
+  gchar *other;
+
+  if (g_source_is_destroyed (g_main_current_source ()))
+    return FALSE;
 
-  priv->is_portrait = FALSE;
+  /* Only upload the wallpaper of the current orientation. */
+  priv->is_portrait = hd_home_view_wants_portrait_wallpaper (self);
+  set_background_common (self,
+                         hd_home_view_load_wallpaper (self, priv->is_portrait));
+  priv->load_background_source = 0;
+
+  /* Have the other one ready in the cache for when we rotate. */
+  if (hd_home_is_portrait_wallpaper_enabled (priv->home))
+    {
+      other = g_strdup_printf (priv->is_portrait
+                                 ? CACHED_BACKGROUND_IMAGE_FILE_PNG
+                                 : CACHED_BACKGROUND_IMAGE_FILE_PNG_PORTRAIT,
+                               g_get_home_dir (), priv->id + 1);
+      if (g_file_test (other, G_FILE_TEST_EXISTS))
+        hd_scheduler_add (HD_SCHEDULE_BACKGROUND, "prepare_wallpaper",
+                          prepare_wallpaper_idle, other, g_free);
+      else
+        g_free (other);
+    }
 
   return FALSE;
 }
@@ -744,7 +645,7 @@ hd_home_view_set_live_bg (HdHomeView *view,
     {
       /* cancel ongoing background loading job unless we have transparent
        * live background */
-      g_source_remove (priv->load_background_source);
+      hd_scheduler_remove (priv->load_background_source);
       priv->load_background_source = 0;
     }
 
@@ -796,19 +697,21 @@ void
 hd_home_view_load_background (HdHomeView *view)
 {
   HdHomeViewPrivate *priv;
-  gint priority = G_PRIORITY_DEFAULT_IDLE;
+  HdScheduleKind kind = HD_SCHEDULE_BACKGROUND;
   g_return_if_fail (HD_IS_HOME_VIEW (view));
 
   priv = view->priv;
 
-  /* Check current home view and increase priority if this is the current one */
+  /* The current home view is needed soon, but decoding and uploading it
+   * mustn't hold up the frame being animated; the others can wait until
+   * there's time. */
   if (hd_home_view_container_get_current_view (priv->view_container) == priv->id)
-    priority = G_PRIORITY_HIGH_IDLE;
+    kind = HD_SCHEDULE_POST_PAINT;
 
-  priv->load_background_source = g_idle_add_full (priority,
-                                                  load_background_idle,
-                                                  view,
-                                                  NULL);
+  priv->load_background_source = hd_scheduler_add (kind, "load_background",
+                                                   load_background_idle,
+                                                   view,
+                                                   NULL);
 }
 
 static void
@@ -1571,6 +1474,18 @@ hd_home_view_add_applet (HdHomeView   *view,
   hd_home_view_restack_applets (view);
 }
 
+/* Paint the applets of @view from one cached image rather than one by
+ * one.  Changes to the applets are shown at most every
+ * [home] applets_cache_refresh ms while they're cached. */
+void
+hd_home_view_set_applets_cached (HdHomeView *view, gboolean cached)
+{
+  g_return_if_fail (HD_IS_HOME_VIEW (view));
+
+  tidy_cached_group_set_render_cache (view->priv->applets_container,
+                                      cached ? 1 : 0);
+}
+
 void
 hd_home_view_change_applets_position (HdHomeView *view)
 {
@@ -1879,55 +1794,27 @@ hd_home_view_resize_applets_container(ClutterActor *actor, GParamSpec *unused,
                          hd_comp_mgr_get_current_screen_height ());
 }
 
+/* Switches to the wallpaper of the current orientation. */
 void
 hd_home_view_change_wallpaper(HdHomeView *view)
 {
   HdHomeViewPrivate *priv = view->priv;
-  TidySubTexture *new_bg_sub = 0;
-  ClutterActor *new_bg;
-
-  if(priv->background_temp_portrait == NULL ||
-      priv->background_temp == NULL)
-      return;
-
-
-  if(STATE_IS_PORTRAIT(hd_render_manager_get_state ()))
-    {
-      new_bg = priv->background_temp_portrait;
-      new_bg_sub = priv->background_sub_temp_portrait;
-    }
-  else
-    {
-      new_bg = priv->background_temp;
-      new_bg_sub = priv->background_sub_temp;
-    }
-
-  clutter_actor_set_name (new_bg, "HdHomeView::background");
+  gboolean portrait;
 
-  g_object_ref(priv->background);
-  g_object_ref(priv->background_sub);
-
-  /* Remove old background and add new to the background container */
-  clutter_container_remove_actor (
-              CLUTTER_CONTAINER (priv->background_container),
-              priv->background);
-  if (priv->background_sub)
-    clutter_container_remove_actor (
-                CLUTTER_CONTAINER (priv->background_container),
-                CLUTTER_ACTOR(priv->background_sub));
-
-  clutter_container_add_actor (
-              CLUTTER_CONTAINER (priv->background_container),
-              new_bg);
-  if (new_bg_sub)
-    clutter_container_add_actor (
-                CLUTTER_CONTAINER (priv->background_container),
-                CLUTTER_ACTOR(new_bg_sub));
-
-  /* Only update blur if we're currently active */
-  if (hd_home_view_container_get_current_view(priv->view_container) == priv->id)
-    hd_render_manager_blurred_changed();
+  portrait = hd_home_view_wants_portrait_wallpaper (view);
+  if (portrait == priv->is_portrait)
+    return;
+  if (priv->load_background_source)
+    /* load_background_idle() will pick the right one. */
+    return;
+  if (priv->live_bg && priv->background
+      && clutter_actor_get_parent (priv->background)
+         == priv->background_container
+      && priv->background == mb_wm_comp_mgr_clutter_client_get_actor (
+                  MB_WM_COMP_MGR_CLUTTER_CLIENT (priv->live_bg->cm_client)))
+    /* The live background is the same in both orientations. */
+    return;
 
-  priv->background = new_bg;
-  priv->background_sub = new_bg_sub;
+  priv->is_portrait = portrait;
+  set_background_common (view, hd_home_view_load_wallpaper (view, portrait));
 }
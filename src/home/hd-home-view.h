@@ -90,6 +90,7 @@ void hd_home_view_load_background (HdHomeView *view);
 void hd_home_view_update_state (HdHomeView *view);
 
 void hd_home_view_change_applets_position (HdHomeView *view);
+void hd_home_view_set_applets_cached (HdHomeView *view, gboolean cached);
 void hd_home_view_change_wallpaper(HdHomeView *view);
 
 G_END_DECLS
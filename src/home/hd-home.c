@@ -42,6 +42,7 @@
 #include "hd-launcher-app.h"
 #include "hd-dbus.h"
 #include "hd-title-bar.h"
+#include "hd-screenshot.h"
 
 #include <clutter/clutter.h>
 #include <clutter/x11/clutter-x11.h>
@@ -62,7 +63,6 @@
 #include <X11/XKBlib.h>
 #include <gdk/gdkx.h>
 #include <gdk/gdkkeysyms.h>
-#include <libhildondesktop/hd-pvr-texture.h>
 
 #define HDH_EDIT_BUTTON_DURATION 200
 #define HDH_EDIT_BUTTON_TIMEOUT 3000
@@ -837,6 +837,26 @@ hd_home_desktop_key_press (XKeyEvent *xev, void *userdata)
           sprintf (s, "%i", keyval + 1024);
           hd_dbus_send_event (s);
         }
+      else
+        {
+          /* Search the launcher for what's typed. */
+          gdk_keymap_translate_keyboard_state (keymap,
+                                               keycode,
+                                               xev->state,
+                                               0,
+                                               &keyval,
+                                               NULL, NULL, NULL);
+          unicode = gdk_keyval_to_unicode (keyval);
+          if (keyval == GDK_BackSpace)
+            hd_launcher_type_search_backspace ();
+          else if (unicode && g_unichar_isprint (unicode))
+            {
+              char buffer[8] = {0,};
+
+              g_unichar_to_utf8 (unicode, buffer);
+              hd_launcher_type_search_append (buffer);
+            }
+        }
     }
 
   if (STATE_IS_TASK_NAV (hd_render_manager_get_state ()))
@@ -1124,26 +1144,48 @@ hd_home_reset_fn_state (HdHome *home)
   home->priv->ignore_next_shift_release = FALSE;
 }
 
+/* A reply to a loading screenshot request, sent when we're done. */
+typedef struct
+{
+  MBWindowManager *wm;
+  XEvent           reply;
+} HdHomeScreenshotReply;
+
+static void
+send_screenshot_reply (HdHomeScreenshotReply *r, gboolean isok)
+{
+  r->reply.xclient.data.l[1] = isok;
+  mb_wm_util_async_trap_x_errors (r->wm->xdpy);
+  XSendEvent (r->wm->xdpy, r->reply.xclient.window, False,
+              NoEventMask, &r->reply);
+  XFlush (r->wm->xdpy);
+  mb_wm_util_async_untrap_x_errors ();
+  g_slice_free (HdHomeScreenshotReply, r);
+}
+
+static void
+screenshot_saved (const gchar *filename, gboolean saved, gpointer r)
+{
+  send_screenshot_reply (r, saved);
+}
+
 /*
- * Create the loading screenshot of the application of @xwin which will
- * be put up the the application is started next or remove it.  If the
- * application already has a screenshot it's retained and we don't create
- * a new one.  If @take was requested returns whether a new screenshot
- * was taken, otherwise whether the screenshot was removed successfully.
- * Does nothing if @xwin doesn't have an application we know about.
+ * Returns the file of the loading screenshot of the application
+ * of @xwin, or NULL if @xwin doesn't have an application we know
+ * about.  *@clientp is set to the client of @xwin.
  */
-static gboolean
-take_screenshot (MBWindowManager *wm, Window xwin, gboolean take)
+static gchar *
+screenshot_filename (MBWindowManager *wm, Window xwin,
+                     MBWindowManagerClient **clientp)
 {
   MBWindowManagerClient *client;
   HdLauncherApp *launcher_app;
   const char *service_name;
   char *filename;
-  gboolean isok;
 
   client = mb_wm_managed_client_from_xwindow (wm, xwin);
   if (!client || !client->window)
-    return FALSE;
+    return NULL;
 
   launcher_app = hd_comp_mgr_client_get_launcher (
                                 HD_COMP_MGR_CLIENT (client->cm_client));
@@ -1151,7 +1193,7 @@ take_screenshot (MBWindowManager *wm, Window xwin, gboolean take)
     {
       g_warning ("Window 0x%lx did not have an application associated"
                  " with it", client->window->xwindow);
-      return FALSE;
+      return NULL;
     }
 
   service_name = hd_launcher_app_get_service (launcher_app);
@@ -1159,59 +1201,96 @@ take_screenshot (MBWindowManager *wm, Window xwin, gboolean take)
     {
       g_warning ("Window 0x%lx has no sane service name",
                  client->window->xwindow);
-      return FALSE; /* daft service name, don't get a loading pic */
+      return NULL; /* daft service name, don't get a loading pic */
     }
 
   filename = g_strdup_printf ("%s/.cache/launch", getenv("HOME"));
   g_mkdir_with_parents (filename, 0770);
   g_free (filename);
 
-  isok = FALSE;
-
+  *clientp = client;
   if (STATE_IS_PORTRAIT(hd_render_manager_get_state()))
-    filename = g_strdup_printf ("%s/.cache/launch/%s_portrait.pvr",
-                                getenv("HOME"), service_name);
+    return g_strdup_printf ("%s/.cache/launch/%s_portrait.pvr",
+                            getenv("HOME"), service_name);
   else
-    filename = g_strdup_printf ("%s/.cache/launch/%s.pvr",
-                                getenv("HOME"), service_name);
+    return g_strdup_printf ("%s/.cache/launch/%s.pvr",
+                            getenv("HOME"), service_name);
+}
 
-  if (take)
-  {
-    Pixmap                          pixmap;
-    GdkPixbuf                      *pixbuf;
-    guint                           depth;
-    guint                           width, height;
-    ClutterActor                   *actor, *texture;
+/*
+ * Create the loading screenshot of the application of @xwin which will
+ * be put up the the application is started next.  If the application
+ * already has a screenshot it's retained and we don't create a new one.
+ * The screenshot is grabbed right away but saved in the background,
+ * and @r is sent when it's done, telling whether a new screenshot was
+ * taken.  Does nothing if @xwin doesn't have an application we know
+ * about.
+ */
+static void
+take_screenshot (MBWindowManager *wm, Window xwin, HdHomeScreenshotReply *r)
+{
+  MBWindowManagerClient          *client;
+  char                           *filename;
+  Pixmap                          pixmap;
+  GdkPixbuf                      *pixbuf;
+  guint                           depth;
+  guint                           width, height;
+  ClutterActor                   *actor, *texture;
 
-    if (g_file_test (filename, G_FILE_TEST_EXISTS))
-      {
-        g_debug ("%s: not creating '%s', already exists",
-                 __func__, filename);
-        g_free (filename);
-        return FALSE;
-      }
+  if (!(filename = screenshot_filename (wm, xwin, &client)))
+    {
+      send_screenshot_reply (r, FALSE);
+      return;
+    }
 
-    actor = mb_wm_comp_mgr_clutter_client_get_actor (
-                     MB_WM_COMP_MGR_CLUTTER_CLIENT (client->cm_client));
-    texture = clutter_group_get_nth_child (CLUTTER_GROUP (actor), 0);
-    g_object_get (texture,
-                  "pixmap", &pixmap,
-                  "pixmap-depth", &depth,
-                  "pixmap-width", &width,
-                  "pixmap-height", &height,
-                  NULL);
-
-    /* We could call mb_wm_theme_get_decor_dimensions() here and take out
-     * the titlebar, etc, but in practice these aren't drawn on the loading
-     * image so we have to keep them on. */
-    pixbuf = gdk_pixbuf_xlib_get_from_drawable (NULL, pixmap,
-                             xlib_rgb_get_cmap(), xlib_rgb_get_visual(),
-                             0, 0, 0, 0, width, height);
-    isok = hd_pvr_texture_save (filename, pixbuf, NULL);
+  if (g_file_test (filename, G_FILE_TEST_EXISTS)
+      || hd_screenshot_is_saving (filename))
+    {
+      g_debug ("%s: not creating '%s', already exists",
+               __func__, filename);
+      send_screenshot_reply (r, FALSE);
+      g_free (filename);
+      return;
+    }
+
+  actor = mb_wm_comp_mgr_clutter_client_get_actor (
+                   MB_WM_COMP_MGR_CLUTTER_CLIENT (client->cm_client));
+  texture = clutter_group_get_nth_child (CLUTTER_GROUP (actor), 0);
+  g_object_get (texture,
+                "pixmap", &pixmap,
+                "pixmap-depth", &depth,
+                "pixmap-width", &width,
+                "pixmap-height", &height,
+                NULL);
+
+  /* We could call mb_wm_theme_get_decor_dimensions() here and take out
+   * the titlebar, etc, but in practice these aren't drawn on the loading
+   * image so we have to keep them on. */
+  pixbuf = gdk_pixbuf_xlib_get_from_drawable (NULL, pixmap,
+                           xlib_rgb_get_cmap(), xlib_rgb_get_visual(),
+                           0, 0, 0, 0, width, height);
+  if (!pixbuf
+      || !hd_screenshot_save (pixbuf, filename, HD_SCREENSHOT_PVR,
+                              screenshot_saved, r))
+    send_screenshot_reply (r, FALSE);
+
+  if (pixbuf)
     g_object_unref (pixbuf);
-  } else
-    isok = unlink (filename) == 0;
+  g_free (filename);
+}
+
+/* Removes the loading screenshot of the application of @xwin.
+ * Returns whether it was removed successfully. */
+static gboolean
+remove_screenshot (MBWindowManager *wm, Window xwin)
+{
+  MBWindowManagerClient *client;
+  char *filename;
+  gboolean isok;
 
+  if (!(filename = screenshot_filename (wm, xwin, &client)))
+    return FALSE;
+  isok = unlink (filename) == 0;
   g_free (filename);
   return isok;
 }
@@ -1245,23 +1324,22 @@ root_window_client_message (XClientMessageEvent *event, HdHome *home)
   if (event->message_type == hd_comp_mgr_get_atom (hmgr,
                                      HD_ATOM_HILDON_LOADING_SCREENSHOT))
     {
-      XEvent reply;
+      HdHomeScreenshotReply *r;
 
       /* Tell the client when the operation is complete. */
-      reply.xclient.type = ClientMessage;
-      reply.xclient.window = event->data.l[1];
-      reply.xclient.message_type = hd_comp_mgr_get_atom (hmgr,
+      r = g_slice_new0 (HdHomeScreenshotReply);
+      r->wm = wm;
+      r->reply.xclient.type = ClientMessage;
+      r->reply.xclient.window = event->data.l[1];
+      r->reply.xclient.message_type = hd_comp_mgr_get_atom (hmgr,
                                    HD_ATOM_HILDON_LOADING_SCREENSHOT);
-      reply.xclient.format = 32;
-      reply.xclient.data.l[0] = event->serial;
-      reply.xclient.data.l[1] = take_screenshot (wm, event->data.l[1],
-                                                 event->data.l[0] != 1);
-
-      mb_wm_util_async_trap_x_errors (wm->xdpy);
-      XSendEvent (wm->xdpy, reply.xclient.window, False,
-                  NoEventMask, &reply);
-      XFlush (wm->xdpy);
-      mb_wm_util_async_untrap_x_errors ();
+      r->reply.xclient.format = 32;
+      r->reply.xclient.data.l[0] = event->serial;
+
+      if (event->data.l[0] != 1)
+        take_screenshot (wm, event->data.l[1], r);
+      else
+        send_screenshot_reply (r, remove_screenshot (wm, event->data.l[1]));
     }
 }
 
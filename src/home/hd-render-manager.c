@@ -46,6 +46,9 @@
 #include "hd-app.h"
 #include "hd-dialog.h"
 #include "hd-app-menu.h"
+#include "hd-client-index.h"
+#include "hd-trace.h"
+#include "hd-scheduler.h"
 
 #include <matchbox/core/mb-wm.h>
 #include <matchbox/theme-engines/mb-wm-theme.h>
@@ -1387,6 +1390,7 @@ void hd_render_manager_set_state(HDRMStateEnum state)
   MBWMCompMgr          *cmgr;
   MBWindowManager      *wm;
   MBWindowManagerClient *c;
+  gint64 trace_start = 0;
 
   priv = render_manager->priv;
   cmgr = MB_WM_COMP_MGR (priv->comp_mgr);
@@ -1418,9 +1422,12 @@ void hd_render_manager_set_state(HDRMStateEnum state)
       {
         g_warning("%s: State change ignored as already in "
                   "hd_render_manager_set_state", __FUNCTION__);
+        hd_trace_instant (HD_TRACE_STATE, "ignored", state);
         return;
       }
   priv->in_set_state = TRUE;
+  if (hd_trace_enabled)
+    trace_start = hd_trace_now ();
 
   if (state != priv->state)
     {
@@ -1860,6 +1867,9 @@ out:
   if (hd_debug_mode_set)
     g_warning("Set state complete %s ",	hd_render_manager_state_str(priv->state));
 
+  /* Name the span after the state we ended up in. */
+  hd_trace_complete (HD_TRACE_STATE,
+                     hd_render_manager_state_str (priv->state), trace_start);
   priv->in_set_state = FALSE;
 }
 
@@ -2120,6 +2130,98 @@ hd_render_manager_get_geo_for_current_screen(ClutterActor *actor,
     *geo = rgeo;
 }
 
+/* Reorders the children of @group so that the ones in @wanted are on
+ * the top in that order, and the rest are below them in their current
+ * order.  Only the actors which are not part of the longest sequence
+ * already in the right order are moved, since every move is O(n) in
+ * a ClutterGroup.  Returns the number of moves. */
+static guint
+hd_render_manager_reorder (ClutterGroup *group, GQueue *wanted)
+{
+  GHashTable *is_wanted, *index;
+  GList *children, *li;
+  ClutterActor **order;
+  guint *pos, *tails, *prev;
+  gboolean *keep;
+  guint n, i, k, len, lo, hi, moves;
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (group));
+  n = g_list_length (children);
+
+  /* Where each child is now (+1, not to be NULL). */
+  is_wanted = g_hash_table_new (NULL, NULL);
+  for (li = wanted->head; li; li = li->next)
+    g_hash_table_insert (is_wanted, li->data, li->data);
+  index = g_hash_table_new (NULL, NULL);
+  for (i = 0, li = children; li; li = li->next, i++)
+    g_hash_table_insert (index, li->data, GUINT_TO_POINTER (i + 1));
+
+  /* How it should be: first what's not @wanted, then @wanted. */
+  order = g_new (ClutterActor *, n);
+  pos = g_new (guint, n);
+  k = 0;
+  for (li = children; li; li = li->next)
+    if (!g_hash_table_lookup (is_wanted, li->data))
+      order[k++] = li->data;
+  for (li = wanted->head; li && k < n; li = li->next)
+    if (g_hash_table_lookup (index, li->data))
+      order[k++] = li->data;
+  n = k;
+  for (k = 0; k < n; k++)
+    pos[k] = GPOINTER_TO_UINT (g_hash_table_lookup (index, order[k]));
+
+  /* Find the longest subsequence of @order which is increasing in @pos.
+   * @tails[l] is the element ending the increasing subsequence of
+   * length l+1 with the smallest @pos found so far. */
+  tails = g_new (guint, n);
+  prev = g_new (guint, n);
+  keep = g_new0 (gboolean, n);
+  len = 0;
+  for (k = 0; k < n; k++)
+    {
+      lo = 0;
+      hi = len;
+      while (lo < hi)
+        {
+          guint mid = (lo + hi) / 2;
+          if (pos[tails[mid]] < pos[k])
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+      prev[k] = lo > 0 ? tails[lo - 1] : G_MAXUINT;
+      tails[lo] = k;
+      if (lo == len)
+        len++;
+    }
+  for (k = len > 0 ? tails[len - 1] : G_MAXUINT; k != G_MAXUINT; k = prev[k])
+    keep[k] = TRUE;
+
+  /* Put the rest right above their predecessors.  Those before them
+   * are in the right order already by the time we get to them. */
+  moves = 0;
+  for (k = 0; k < n; k++)
+    if (!keep[k])
+      {
+        if (k == 0)
+          clutter_actor_lower_bottom (order[k]);
+        else
+          clutter_actor_raise (order[k], order[k - 1]);
+        moves++;
+      }
+
+  g_free (keep);
+  g_free (prev);
+  g_free (tails);
+  g_free (pos);
+  g_free (order);
+  g_hash_table_destroy (index);
+  g_hash_table_destroy (is_wanted);
+  g_list_free (children);
+
+  return moves;
+}
+
 /* Called to restack the windows in the way we use for rendering... */
 void hd_render_manager_restack()
 {
@@ -2128,22 +2230,24 @@ void hd_render_manager_restack()
   MBWindowManagerClient *c;
   gboolean past_desktop = FALSE;
   gboolean blur_changed = FALSE;
-  gint i;
   GList *previous_home_blur = 0;
   unsigned int screenw, screenh;
   int curr_view;
   ClutterActor *live_bg_actor = NULL;
-  ClutterActor *child;
+  GQueue wanted = G_QUEUE_INIT;
+  GList *children, *it;
 
+  hd_trace_begin (HD_TRACE_RESTACK, "hd_render_manager_restack");
   wm = MB_WM_COMP_MGR(priv->comp_mgr)->wm;
   /* Add all actors currently in the home_blur group */
 
-  for (i = 0,
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), 0);
-       child;
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), ++i))
-    if (CLUTTER_ACTOR_IS_VISIBLE(child))
-      previous_home_blur = g_list_prepend(previous_home_blur, child);
+  children = clutter_container_get_children(
+                                    CLUTTER_CONTAINER(priv->home_blur));
+  for (it = children; it; it = it->next)
+    if (CLUTTER_ACTOR_IS_VISIBLE(it->data))
+      previous_home_blur = g_list_prepend(previous_home_blur, it->data);
+  previous_home_blur = g_list_reverse(previous_home_blur);
+  g_list_free(children);
 
   screenw = hd_comp_mgr_get_current_screen_width ();
   screenh = hd_comp_mgr_get_current_screen_height ();
@@ -2237,11 +2341,24 @@ void hd_render_manager_restack()
                             clutter_actor_get_name(actor)?clutter_actor_get_name(actor):"?",
                             clutter_actor_get_name(parent)?clutter_actor_get_name(parent):"?");
 #endif /*STACKING_DEBUG*/
-                      clutter_actor_raise_top(actor);
+                      /* Actors in home_blur are put in order in one go
+                       * below. */
+                      if (clutter_actor_get_parent(actor)
+                          == CLUTTER_ACTOR(priv->home_blur))
+                        g_queue_push_tail(&wanted, actor);
+                      else
+                        clutter_actor_raise_top(actor);
                       if (live_bg_actor && c->desktop == curr_view &&
                           HD_WM_CLIENT_CLIENT_TYPE (c) == HdWmClientTypeHomeApplet)
                         {
-                          clutter_actor_raise_top (live_bg_actor);
+                          if (clutter_actor_get_parent(live_bg_actor)
+                              == CLUTTER_ACTOR(priv->home_blur))
+                            {
+                              g_queue_remove(&wanted, live_bg_actor);
+                              g_queue_push_tail(&wanted, live_bg_actor);
+                            }
+                          else
+                            clutter_actor_raise_top (live_bg_actor);
                         }
                     }
 #if STACKING_DEBUG
@@ -2261,6 +2378,11 @@ void hd_render_manager_restack()
         }
     }
 
+  /* Raise what's past the desktop to the top in the stacking order. */
+  if (hd_render_manager_reorder(CLUTTER_GROUP(priv->home_blur), &wanted))
+    clutter_actor_queue_redraw(CLUTTER_ACTOR(priv->home_blur));
+  g_queue_clear(&wanted);
+
   /* Now start at the top and put actors in the non-blurred group
    * until we find one that fills the screen. If we didn't find
    * any that filled the screen then add the window that does. */
@@ -2353,35 +2475,33 @@ void hd_render_manager_restack()
   /* now compare the contents of home_blur to see if the blur group has
    * actually changed... We only look at *visible* children, which is
    * why it is a little complicated. */
-  GList *it;
-  for (i = 0, it = g_list_last(previous_home_blur),
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), 0);
-       child && it;
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), ++i),
-       it=it->prev)
+  GList *li;
+  children = clutter_container_get_children(
+                                    CLUTTER_CONTAINER(priv->home_blur));
+  for (it = previous_home_blur, li = children; ; it = it->next, li = li->next)
     {
       /* search for next visible child */
-      while (child && !CLUTTER_ACTOR_IS_VISIBLE(child))
-        child=clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), ++i);
+      while (li && !CLUTTER_ACTOR_IS_VISIBLE(li->data))
+        li = li->next;
+      if (!it || !li)
+        break;
 
       /* now compare children */
-      if (CLUTTER_ACTOR(it->data) != child)
-        {
-          blur_changed = TRUE;
-          break;
-        }
+      if (it->data != li->data)
+        break;
     }
-  if (it || child)
+  if (it || li)
     {
       blur_changed = TRUE;
     }
+  g_list_free(children);
 #if BLUR_DEBUG
   if (blur_changed)
     {
-      int n_elements;
+      int i, n_elements;
       n_elements = clutter_group_get_n_children(CLUTTER_GROUP(priv->home_blur));
       g_debug("*** RE-BLURRING *** because home_blur  contents changed");
-      for (it=g_list_last(previous_home_blur);it;it=it->prev)
+      for (it=previous_home_blur;it;it=it->next)
         {
           ClutterActor *actor = CLUTTER_ACTOR(it->data);
           if (clutter_actor_get_name(actor))
@@ -2407,6 +2527,7 @@ void hd_render_manager_restack()
 
   /* ----------------------------- DEBUG PRINTING */
 #if STACKING_DEBUG
+  gint i;
   for (i = 0;i<clutter_group_get_n_children(CLUTTER_GROUP(priv->home_blur));i++)
     {
       ClutterActor *child =
@@ -2445,6 +2566,7 @@ void hd_render_manager_restack()
 
   /* update our fixed title bar at the top of the screen */
   hd_title_bar_update(priv->title_bar);
+  hd_trace_end (HD_TRACE_RESTACK, "hd_render_manager_restack");
 }
 
 void hd_render_manager_update_blur_state()
@@ -2674,26 +2796,16 @@ static
 MBWindowManagerClient*
 hd_render_manager_get_wm_client_from_actor(ClutterActor *actor)
 {
-  MBWindowManager *wm;
   MBWindowManagerClient *c;
+  MBWMCompMgrClient *cc;
 
-  /* first off, try and get the client from the data set in the actor */
-  MBWMCompMgrClient *cc = g_object_get_data (G_OBJECT (actor),
-                                             "HD-MBWMCompMgrClutterClient");
-  if (cc && cc->wm_client)
-    return cc->wm_client;
+  if ((c = hd_client_index_lookup (actor)) != NULL)
+    return c;
 
-  /*Or search... */
-  wm = MB_WM_COMP_MGR(render_manager->priv->comp_mgr)->wm;
-  /* Order and choose which window actors will be visible */
-  for (c = wm->stack_bottom; c; c = c->stacked_above)
-    if (c->cm_client) {
-      ClutterActor *cactor = mb_wm_comp_mgr_clutter_client_get_actor(
-                               MB_WM_COMP_MGR_CLUTTER_CLIENT(c->cm_client));
-      if (actor == cactor)
-        return c;
-    }
-  return 0;
+  /* Not indexed (yet, or anymore), see if the actor knows its client.
+   * Don't index it from here, the client may be gone already. */
+  cc = g_object_get_data (G_OBJECT (actor), "HD-MBWMCompMgrClutterClient");
+  return cc ? cc->wm_client : 0;
 }
 
 static
@@ -3195,12 +3307,11 @@ void hd_render_manager_remove_input_blocker() {
      gdk_region_destroy(priv->new_input_viewport);
    priv->new_input_viewport = region;
 
-   /* Add idle callback. This MUST be higher priority than Clutter timelines
-    * (D+30) or we won't set our input viewport correctly until any running
-    * transitions have stopped. */
+   /* This MUST be done before the next frame, or we won't set our input
+    * viewport correctly until any running transitions have stopped. */
    if (!priv->input_viewport_callback)
-     priv->input_viewport_callback = g_idle_add_full(
-         G_PRIORITY_DEFAULT+20,
+     priv->input_viewport_callback = hd_scheduler_add(
+         HD_SCHEDULE_PRE_PAINT, "input_viewport",
          hd_render_manager_set_compositor_input_viewport_idle,
          NULL, NULL);
  }
@@ -38,9 +38,7 @@
 
 /* Include files {{{ */
 #include <math.h>
-#include <errno.h>
 #include <string.h>
-#include <sys/stat.h>
 #include <sys/time.h>
 
 #include <gtk/gtk.h>
@@ -65,6 +63,10 @@
 #include "hd-transition.h"
 #include "hd-theme.h"
 #include "hd-util.h"
+#include "hd-scheduler.h"
+#include "hd-trace.h"
+#include "hd-task.h"
+#include "hd-file-watch.h"
 #include "hd-gtk-style.h"
 #include "hd-app-mgr.h"
 /* }}} */
@@ -273,6 +275,8 @@ typedef struct
 /* }}} */
 
 /* Thumbnail data structures {{{ */
+typedef struct _VideoLoad VideoLoad;
+
 /* Incoming event notification clients and thumbnails. {{{ */
 typedef struct
 {
@@ -457,14 +461,17 @@ typedef struct
        * -- @video_fname: Where to look for the last-frame video screenshot
        *                  for this application.  Deduced from some property
        *                  in the application's .desktop file.
-       * -- @video_mtime: The last modification time of the image loaded as
-       *                  .video.  Used to decide if it should be refreshed.
+       * -- @video_watch: Tells whether .video_fname has changed since
+       *                  it was last loaded, so it needs to be reloaded.
+       * -- @video_load:  The loading of .video_fname in the background
+       *                  if it's going on.
        * -- @video:       The downsampled texture of the image loaded from
        *                  .video_fname or %NULL.
        */
       ClutterActor        *video;
       const gchar         *video_fname;
-      time_t               video_mtime;
+      HdFileWatch         *video_watch;
+      VideoLoad           *video_load;
     };
 
     /* Currently we don't have notification-specific fields. */
@@ -484,7 +491,26 @@ typedef struct
    */
   gboolean portrait_supported;
 
+  /*
+   * -- @laid_out:        Whether layout_thumbs() has placed the thumbnail
+   *                      and set up its inners at least once.
+   * -- @xslot, @yslot:   Where it placed .thwin the last time.
+   */
+  gboolean laid_out;
+  guint xslot, yslot;
+
 } Thumbnail; /* }}} */
+
+/* A video screenshot being loaded in a worker thread.  @apthumb is
+ * %NULL if it's been freed meanwhile.  @fname, @width and @height are
+ * the arguments of load_image_pixbuf() and @pixbuf is its result. */
+struct _VideoLoad
+{
+  Thumbnail           *apthumb;
+  gchar               *fname;
+  guint                width, height;
+  GdkPixbuf           *pixbuf;
+};
 /* Thumbnail data structures }}} */
 
 /* Clutter effect data structures {{{ */
@@ -709,6 +735,23 @@ static const GtkRequisition *Thumbsize;
 /* Do we have notifications since we were last in task navigator? */
 static gboolean UnseenNotifications = FALSE;
 
+/*
+ * -- @Layout_cache:      What calc_layout() computed the last time and
+ *                        what from.  The layout only depends on these,
+ *                        so it's only recomputed when one of them changes.
+ * -- @Layout_pending:    The scheduler job of the layout() deferred until
+ *                        the next frame while we're not shown, or 0.
+ */
+static struct
+{
+  gboolean valid;
+  guint nthumbnails, width, height;
+  gboolean portrait;
+  gint tweak;
+  Layout lout;
+} Layout_cache;
+static guint Layout_pending;
+
 /*
  * Effect templates and their corresponding timelines.
  * -- @Fly_effect:  For moving thumbnails and notification windows around
@@ -780,25 +823,27 @@ damage_control: __attribute__((unused))
   return texture;
 }
 
-/* Loads @fname, resizing and cropping it as necessary to fit
- * in a @aw x @ah rectangle.  Returns %NULL on error. */
-static ClutterActor *
-load_image (char const * fname, guint aw, guint ah)
+/* Loads @fname, resizing and cropping it as necessary to fit in a
+ * @aw x @ah rectangle as image_from_pixbuf() expects.  Doesn't touch
+ * Clutter, so it can be called in a worker thread.  Returns %NULL on
+ * error, and doesn't complain if @fname doesn't exist. */
+static GdkPixbuf *
+load_image_pixbuf (char const * fname, guint aw, guint ah)
 {
   GError *err;
   GdkPixbuf *pixbuf;
   gint dx, dy;
   gdouble dsx, dsy, scale;
   guint vw, vh, sw, sh, dw, dh;
-  ClutterActor *final;
-  ClutterActor *texture;
 
   /* On error the caller sure has better recovery plan than an
    * empty rectangle.  (ie. showing the real application window). */
   err = NULL;
   if (!(pixbuf = gdk_pixbuf_new_from_file (fname, &err)))
     {
-      g_warning ("%s: %s", fname, err->message);
+      if (!g_error_matches (err, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        g_warning ("%s: %s", fname, err->message);
+      g_error_free (err);
       return NULL;
     }
 
@@ -867,6 +912,24 @@ load_image (char const * fname, guint aw, guint ah)
       pixbuf = tmp;
     }
 
+  return pixbuf;
+}
+
+/* Destroying @pixbuf loaded by load_image_pixbuf(), turns it into an
+ * actor which appears @aw x @ah large.  Returns %NULL on failure. */
+static ClutterActor *
+image_from_pixbuf (GdkPixbuf * pixbuf, guint aw, guint ah)
+{
+  guint vw, vh, dw, dh;
+  ClutterActor *final;
+  ClutterActor *texture;
+
+  /* See load_image_pixbuf(). */
+  vw = aw / 2;
+  vh = ah / 2;
+  dw = gdk_pixbuf_get_width (pixbuf);
+  dh = gdk_pixbuf_get_height (pixbuf);
+
   if (!(texture = pixbuf2texture (pixbuf)))
     return NULL;
 
@@ -1895,14 +1958,12 @@ layout_fun (gint total, gint term1, gint term2, gint factor)
   return (total - (term1*factor + term2*(factor - 1))) / 2;
 }
 
-/* Calculates the layout of the thumbnails and fills in @lout.
- * The layout depends on the number of thumbnails. */
+/* Calculates the layout of the thumbnails for the current @NThumbnails
+ * and orientation and fills in @lout. */
 static void
-calc_layout (Layout * lout)
+compute_layout (Layout * lout, int tweak_taskswitcher)
 {
   guint nrows_per_page;
-  int tweak_taskswitcher = hd_transition_get_int("thp_tweaks",
-                                                 "taskswitcher", 0);
 
   /* Figure out how many thumbnails to squeeze into one row
    * (not the last one, which may be different) and the maximum
@@ -1970,6 +2031,33 @@ calc_layout (Layout * lout)
   lout->vspace = lout->thumbsize->height + GRID_VERTICAL_GAP;
 }
 
+/* Fills in @lout with the layout of the thumbnails, which depends on
+ * their number, the orientation and the size of the screen. */
+static void
+calc_layout (Layout * lout)
+{
+  int tweak_taskswitcher = hd_transition_get_int("thp_tweaks",
+                                                 "taskswitcher", 0);
+
+  if (!Layout_cache.valid
+      || Layout_cache.nthumbnails != NThumbnails
+      || Layout_cache.portrait != IS_PORTRAIT
+      || Layout_cache.width != DESKTOP_WIDTH
+      || Layout_cache.height != DESKTOP_HEIGHT
+      || Layout_cache.tweak != tweak_taskswitcher)
+    {
+      compute_layout (&Layout_cache.lout, tweak_taskswitcher);
+      Layout_cache.nthumbnails = NThumbnails;
+      Layout_cache.portrait = IS_PORTRAIT;
+      Layout_cache.width = DESKTOP_WIDTH;
+      Layout_cache.height = DESKTOP_HEIGHT;
+      Layout_cache.tweak = tweak_taskswitcher;
+      Layout_cache.valid = TRUE;
+    }
+
+  *lout = Layout_cache.lout;
+}
+
 /* Depending on the current @Thumbsize places the frame graphics
  * elements of @thumb where they should be. */
 static void
@@ -2213,8 +2301,9 @@ layout_notwin (Thumbnail * thumb, const GtkRequisition * oldthsize,
 /*
  * Lays out @Thumbnails on @Grid, and their inner portions.  Makes actors fly
  * if it's appropriate.  @newborn is either a new thumbnail or notification
- * to be displayed; it won't be animated.  Returns the position of the bottom
- * of the lowest thumbnail.  Also sets @Thumbsize.
+ * to be displayed; it won't be animated.  Only the thumbnails whose place
+ * changed are moved.  Returns the position of the bottom of the lowest
+ * thumbnail.  Also sets @Thumbsize.
  */
 static guint
 layout_thumbs (ClutterActor * newborn)
@@ -2223,7 +2312,7 @@ layout_thumbs (ClutterActor * newborn)
   guint maxwtitle;
   const GList *li;
   Thumbnail *thumb;
-  guint xthumb, ythumb, i;
+  guint xthumb, ythumb, i, nmoved;
   const GtkRequisition *oldthsize;
   guint wprison, hprison;
   guint appwgw,appwgh;
@@ -2249,6 +2338,7 @@ layout_thumbs (ClutterActor * newborn)
   appwgw = IS_PORTRAIT?App_window_geometry_height+HD_COMP_MGR_TOP_MARGIN:App_window_geometry_width;
   appwgh = IS_PORTRAIT?App_window_geometry_width-HD_COMP_MGR_TOP_MARGIN:App_window_geometry_height;
 
+  nmoved = 0;
   for (li = Thumbnails, i = 0; li && (thumb = li->data); li = li->next, i++)
     {
       const Flyops *ops;
@@ -2272,13 +2362,22 @@ layout_thumbs (ClutterActor * newborn)
        * a new one to enter the navigator, don't, it's hidden anyway. */
       ops = thumb->thwin == newborn ? &Fly_at_once : &Fly_smoothly;
 
-      /* Place @thwin in any case. */
-      ops->move (thumb->thwin, xthumb, ythumb);
+      /* Place @thwin unless it's already there. */
+      if (!thumb->laid_out || thumb->thwin == newborn
+          || thumb->xslot != xthumb || thumb->yslot != ythumb)
+        {
+          ops->move (thumb->thwin, xthumb, ythumb);
+          thumb->xslot = xthumb;
+          thumb->yslot = ythumb;
+          nmoved++;
+        }
 
       /* If @Thumbnails are not changing size and this is not a newborn
        * the inners of @thumb are already setup. */
-      if (oldthsize == Thumbsize && thumb->thwin != newborn)
+      if (oldthsize == Thumbsize && thumb->thwin != newborn
+          && thumb->laid_out)
           goto skip_the_circus;
+      thumb->laid_out = TRUE;
 
       /* Set thumbnail's reaction area. */
       ops->resize (thumb->thwin, Thumbsize->width, Thumbsize->height);
@@ -2341,13 +2440,56 @@ skip_the_circus:
       xthumb += lout.hspace;
     }
 
+  hd_trace_instant (HD_TRACE_LAYOUT, "task_navigator_layout", nmoved);
   return ythumb + Thumbsize->height+(/* No idea why */ IS_PORTRAIT?(SCREEN_HEIGHT-SCREEN_WIDTH):0);
 }
 
+/* The scheduler job of a deferred layout(). */
+static gboolean
+layout_deferred (gpointer unused)
+{
+  Layout_pending = 0;
+  set_navigator_height (layout_thumbs (NULL));
+  return FALSE;
+}
+
+/* Does the layout() deferred until the next frame now if there's one,
+ * for those who need the thumbnails in place right away. */
+static void
+flush_layout (void)
+{
+  if (Layout_pending)
+    {
+      hd_scheduler_remove (Layout_pending);
+      layout_deferred (NULL);
+    }
+}
+
 /* Lays out the @Thumbnails in the @Grid. */
 static void
 layout (ClutterActor * newborn, gboolean newborn_is_notification)
 {
+  /*
+   * When we're not shown nothing is animated and nobody sees where
+   * the thumbnails are, so lay them out just once before the next frame,
+   * however many windows come and go until then.  @newborn needs no
+   * special treatment then, it's new to layout_thumbs() anyway.
+   */
+  if (!hd_task_navigator_is_active ())
+    {
+      Layout_pending = hd_scheduler_add (HD_SCHEDULE_PRE_PAINT,
+                                         "task_navigator_layout",
+                                         layout_deferred, NULL, NULL);
+      return;
+    }
+
+  /* We're about to lay out everything anyway. */
+  if (Layout_pending)
+    {
+      hd_scheduler_remove (Layout_pending);
+      Layout_pending = 0;
+    }
+
   /* This layout machinery is based on invariants, which basically
    * means we don't pay much attention to what caused the layout
    * update, but we rely on the current state of matters. */
@@ -2514,6 +2656,12 @@ free_thumb (Thumbnail * thumb, gboolean animate)
           thumb->dialogs = NULL;
         }
 
+      if (thumb->video_watch)
+        hd_file_watch_remove (thumb->video_watch);
+      if (thumb->video_load)
+        /* video_load_done() will see it's not needed anymore. */
+        thumb->video_load->apthumb = NULL;
+
       /* Releases thumb->win too. */
       if (thumb->win)
         mb_wm_object_signal_disconnect (MB_WM_OBJECT (thumb->win),
@@ -2530,57 +2678,90 @@ free_thumb (Thumbnail * thumb, gboolean animate)
 
 /* Application thumbnails {{{ */
 /* Child adoption {{{ */
-/* Returns whether the application represented by @apthumb has
- * a video screenshot and it should be loaded or reloaded.
- * If so it refreshes @apthumb->video_mtime. */
-static gboolean
-need_to_load_video (Thumbnail * apthumb)
+/* Shows @apthumb->video or the application windows, whichever we have. */
+static void
+show_video_or_windows (Thumbnail * apthumb)
 {
-  /* Already has a video loaded? */
-  if (apthumb->video)
-    {
-      struct stat sbuf;
-      gboolean clear_video, load_video;
+  if (!apthumb->video)
+    /* Needn't bother with show_all() the contents of .windows,
+     * they are shown anyway because of reparent(). */
+    clutter_actor_show (apthumb->windows);
+  else
+    /* Only show @apthumb->video. */
+    clutter_actor_hide (apthumb->windows);
+}
 
-      /* Refresh or unload it? */
-      load_video = clear_video = FALSE;
-      g_assert (apthumb->video_fname);
-      if (stat (apthumb->video_fname, &sbuf) < 0)
-        {
-          if (errno != ENOENT)
-            g_warning ("%s: %m", apthumb->video_fname);
-          clear_video = TRUE;
-        }
-      else if (sbuf.st_mtime > apthumb->video_mtime)
-        {
-          clear_video = load_video = TRUE;
-          apthumb->video_mtime = sbuf.st_mtime;
-        }
+/* Called in a worker thread. */
+static void
+video_load_run (VideoLoad * load)
+{
+  load->pixbuf = load_image_pixbuf (load->fname, load->width, load->height);
+}
 
-      if (clear_video)
+/* Replaces .video with what video_load_run() loaded. */
+static void
+video_load_done (VideoLoad * load)
+{
+  Thumbnail *apthumb;
+
+  if ((apthumb = load->apthumb) != NULL)
+    {
+      apthumb->video_load = NULL;
+
+      if (apthumb->video)
         {
           clutter_container_remove_actor (CLUTTER_CONTAINER (apthumb->prison),
                                           apthumb->video);
           apthumb->video = NULL;
         }
 
-      return load_video;
-    }
-  else if (apthumb->video_fname)
-    {
-      struct stat sbuf;
-
-      /* Do we need to load it? */
-      if (stat (apthumb->video_fname, &sbuf) == 0)
+      /* Make it appear as if .video were .apwin,
+       * having the same geometry. */
+      if (load->pixbuf
+          && (apthumb->video = image_from_pixbuf (load->pixbuf,
+                                                  load->width,
+                                                  load->height)) != NULL)
         {
-          apthumb->video_mtime = sbuf.st_mtime;
-          return TRUE;
+          clutter_actor_set_name (apthumb->video, "video");
+          clutter_actor_set_position (apthumb->video,
+				      App_window_geometry_x,
+				      App_window_geometry_y);
+          clutter_container_add_actor (CLUTTER_CONTAINER (apthumb->prison),
+                                       apthumb->video);
         }
-      else if (errno != ENOENT)
-        g_warning ("%s: %m", apthumb->video_fname);
+
+      /* Otherwise claim_win() will do it. */
+      if (hd_task_navigator_is_active ())
+        show_video_or_windows (apthumb);
     }
+  else if (load->pixbuf)
+    g_object_unref (load->pixbuf);
 
-  return FALSE;
+  g_free (load->fname);
+  g_slice_free (VideoLoad, load);
+}
+
+/* Reloads or unloads the video screenshot of @apthumb in the background
+ * if it's changed since it was loaded last time.  Until then whatever we
+ * had is shown. */
+static void
+update_video (Thumbnail * apthumb)
+{
+  VideoLoad *load;
+
+  if (!apthumb->video_watch || apthumb->video_load
+      || !hd_file_watch_take_changed (apthumb->video_watch))
+    return;
+
+  load = g_slice_new0 (VideoLoad);
+  load->apthumb = apthumb;
+  load->fname = g_strdup (apthumb->video_fname);
+  load->width = App_window_geometry_width;
+  load->height = App_window_geometry_height;
+  apthumb->video_load = load;
+
+  hd_task_submit ((HdTaskFunc)video_load_run,
+                  (HdTaskFunc)video_load_done, load);
 }
 
 /* Start managing @apthumb's application window and loads/reloads its
@@ -2616,33 +2797,9 @@ claim_win (Thumbnail * apthumb)
                          (GFunc)clutter_actor_reparent,
                          apthumb->windows);
 
-  /* Load the video screenshot and place its actor in the hierarchy. */
-  if (need_to_load_video (apthumb))
-    {
-      /* Make it appear as if .video were .apwin,
-       * having the same geometry. */
-      g_assert (!apthumb->video);
-      apthumb->video = load_image (apthumb->video_fname,
-				   App_window_geometry_width,
-				   App_window_geometry_height);
-      if (apthumb->video)
-        {
-          clutter_actor_set_name (apthumb->video, "video");
-          clutter_actor_set_position (apthumb->video,
-				      App_window_geometry_x,
-				      App_window_geometry_y);
-          clutter_container_add_actor (CLUTTER_CONTAINER (apthumb->prison),
-                                       apthumb->video);
-        }
-    }
-
-  if (!apthumb->video)
-    /* Needn't bother with show_all() the contents of .windows,
-     * they are shown anyway because of reparent(). */
-    clutter_actor_show (apthumb->windows);
-  else
-    /* Only show @apthumb->video. */
-    clutter_actor_hide (apthumb->windows);
+  /* (Re)load the video screenshot if it's changed. */
+  update_video (apthumb);
+  show_video_or_windows (apthumb);
 
   /* Restore the opacity/visibility of the actors that have been faded out
    * while zooming, so we won't have trouble if we happen to to need to enter
@@ -3226,6 +3383,8 @@ create_appthumb (ClutterActor * apwin)
   /* .video_fname */
   if ((app = hd_comp_mgr_client_get_launcher (HD_COMP_MGR_CLIENT (hmgrc))) != NULL)
     apthumb->video_fname = hd_launcher_app_get_switcher_icon (HD_LAUNCHER_APP (app));
+  if (apthumb->video_fname)
+    apthumb->video_watch = hd_file_watch_add (apthumb->video_fname);
 
   /* Now the actors: .apwin, .titlebar, .windows. */
   apthumb->apwin = g_object_ref (apwin);
@@ -3727,6 +3886,9 @@ tnote_changed (HdNote * hdnote, int unused1, TNote * tnote)
   gboolean is_more;
   const char *iname, *oname;
 
+  /* layout_notwin() goes by @Thumbsize, which the deferred layout sets. */
+  flush_layout ();
+
   for_each_thumbnail (li, thumb)
     if (thumb->tnote == tnote)
       break;
@@ -3992,6 +4154,7 @@ hd_task_navigator_add_notification (HdTaskNavigator * self,
             }
 
           /* Okay, found it. */
+          flush_layout ();
           adopt_notification (apthumb, tnote);
           layout_notwin (apthumb, NULL, NULL);
           return;
@@ -4138,6 +4301,9 @@ navigator_shown (ClutterActor * navigator, gpointer unused)
   clutter_actor_set_scale (Scroller, 1, 1);
   clutter_actor_set_position (Scroller, 0, 0);
 
+  /* We're going to show the thumbnails, they'd better be in place. */
+  flush_layout ();
+
   /* Take all application windows we know about into our care
    * because we are responsible for showing them now. */
   for_each_appthumb (li, thumb)
@@ -4637,6 +4803,7 @@ hd_task_navigator_update_win_orientation (Window xwindow, gboolean portrait)
       guint appwgw,appwgh;
       guint wprison, hprison;
 
+      flush_layout ();
       wprison = Thumbsize->width  - 2*FRAME_WIDTH;
       hprison = Thumbsize->height - (FRAME_TOP_HEIGHT+FRAME_BOTTOM_HEIGHT);
 
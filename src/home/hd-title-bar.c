@@ -38,6 +38,7 @@
 #include "hd-gtk-style.h"
 #include "hd-transition.h"
 #include "hd-util.h"
+#include "hd-scheduler.h"
 #include "hd-task-navigator.h"
 
 #include <matchbox/theme-engines/mb-wm-theme-png.h>
@@ -1248,10 +1249,10 @@ hd_title_bar_update(HdTitleBar *bar)
   HdTitleBarPrivate *priv = bar->priv;
 
   if (!priv->update_title_bar)
-    /* Add idle callback. This MUST be higher priority than Clutter timelines
-     * (D+30) or we won't set our title bar up correctly until after any running
-     * transitions have stopped. */
-    priv->update_title_bar = g_idle_add_full(G_PRIORITY_DEFAULT+20,
+    /* This MUST be done before the next frame, or we won't set our title
+     * bar up correctly until after any running transitions have stopped. */
+    priv->update_title_bar = hd_scheduler_add(HD_SCHEDULE_PRE_PAINT,
+                                  "update_title_bar",
                                   (GSourceFunc)hd_title_bar_update_idle,
                                   bar, NULL);
 }
@@ -1264,7 +1265,7 @@ hd_title_bar_update_now(HdTitleBar *bar)
 
   if (priv->update_title_bar)
     {
-      g_source_remove(priv->update_title_bar);
+      hd_scheduler_remove(priv->update_title_bar);
       priv->update_title_bar = 0;
     }
 
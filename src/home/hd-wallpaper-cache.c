@@ -0,0 +1,283 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-wallpaper-cache.h"
+
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define CACHE_DIR      "hildon-desktop", "wallpapers"
+#define CACHE_SUFFIX   ".565"
+#define CACHE_MAGIC    0x35366448 /* "Hd65" */
+#define CACHE_VERSION  1
+
+/* What's at the beginning of a cache file, followed by the pixels. */
+typedef struct
+{
+  guint32 magic;
+  guint32 version;
+  guint32 width, height;
+
+  /* Of the source image, to tell when it's changed. */
+  guint64 src_mtime, src_size;
+} HdWallpaperCacheHeader;
+
+static gchar *
+hd_wallpaper_cache_get_path (const gchar *source)
+{
+  gchar *basename, *fname, *path;
+
+  basename = g_path_get_basename (source);
+  fname = g_strconcat (basename, CACHE_SUFFIX, NULL);
+  path = g_build_filename (g_get_user_cache_dir (), CACHE_DIR, fname, NULL);
+  g_free (fname);
+  g_free (basename);
+
+  return path;
+}
+
+/* Is @hdr of a cache file @len bytes long made from a source with @st? */
+static gboolean
+hd_wallpaper_cache_is_fresh (const HdWallpaperCacheHeader *hdr, gsize len,
+                             const struct stat *st)
+{
+  return hdr->magic == CACHE_MAGIC && hdr->version == CACHE_VERSION
+    && hdr->src_mtime == (guint64)st->st_mtime
+    && hdr->src_size == (guint64)st->st_size
+    && len == sizeof (*hdr) + hdr->width * hdr->height * 2;
+}
+
+/* Returns the contents of the cache file of @source if it's up to date
+ * with @st, or NULL. */
+static gchar *
+hd_wallpaper_cache_read (const gchar *source, const struct stat *st)
+{
+  gchar *path, *blob;
+  gsize len;
+
+  path = hd_wallpaper_cache_get_path (source);
+  if (!g_file_get_contents (path, &blob, &len, NULL))
+    {
+      g_free (path);
+      return NULL;
+    }
+  g_free (path);
+
+  if (len < sizeof (HdWallpaperCacheHeader)
+      || !hd_wallpaper_cache_is_fresh ((HdWallpaperCacheHeader *)blob,
+                                       len, st))
+    {
+      g_free (blob);
+      return NULL;
+    }
+
+  return blob;
+}
+
+/* Dither @pixbuf to 16 bits into @out.  We do it ourselves because
+ * clutter doesn't, and a very quick one is enough. */
+static void
+hd_wallpaper_cache_dither (GdkPixbuf *pixbuf, gushort *out)
+{
+  gint              width;
+  gint              height;
+  gint              rowstride;
+  gint              n_channels;
+  guchar           *pixels;
+  guint             lfsr = 1;
+  gint x,y;
+
+  /* Get pixbuf properties */
+  width           = gdk_pixbuf_get_width (pixbuf);
+  height          = gdk_pixbuf_get_height (pixbuf);
+  rowstride       = gdk_pixbuf_get_rowstride (pixbuf);
+  n_channels      = gdk_pixbuf_get_n_channels (pixbuf);
+  pixels          = gdk_pixbuf_get_pixels (pixbuf);
+
+  for (y=0;y<height;y++) {
+    for (x=0;x<width;x++) {
+      /* http://en.wikipedia.org/wiki/Linear_feedback_shift_register */
+      lfsr = (lfsr >> 1) ^ (unsigned int)((0 - (lfsr & 1u)) & 0xd0000001u);
+
+      /* dither 565 - by adding random noise and then truncating
+       * (r>>8)*0xFF makes sure our bottom 8 bits are 0xFF if we
+       * overflow.
+       */
+      guint r,g,b;
+      r = pixels[0] + (lfsr&7);
+      r |= (r>>8)*0xFF;
+      g = pixels[1] + ((lfsr>>3)&3);
+      g |= (g>>8)*0xFF;
+      b = pixels[2] + ((lfsr>>5)&7);
+      b |= (b>>8)*0xFF;
+      *out = ((r<<8)&0xF800) |
+             ((g<<3)&0x07E0) |
+             ((b>>3)&0x001F);
+
+      pixels += n_channels;
+      out++;
+    }
+    pixels += rowstride - width*n_channels;
+  }
+}
+
+/* Decodes and dithers @source and writes it to the cache.  Returns what
+ * it has written or NULL. */
+static gchar *
+hd_wallpaper_cache_build (const gchar *source, const struct stat *st,
+                          GError **error)
+{
+  HdWallpaperCacheHeader *hdr;
+  GdkPixbuf *pixbuf;
+  gchar *blob, *path, *dir;
+  gsize len;
+  GError *write_error;
+
+  if (!(pixbuf = gdk_pixbuf_new_from_file (source, error)))
+    return NULL;
+  if (gdk_pixbuf_get_bits_per_sample (pixbuf) != 8
+      || (gdk_pixbuf_get_n_channels (pixbuf) != 3
+          && gdk_pixbuf_get_n_channels (pixbuf) != 4))
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR,
+                   GDK_PIXBUF_ERROR_UNKNOWN_TYPE,
+                   "unsupported pixel format");
+      g_object_unref (pixbuf);
+      return NULL;
+    }
+
+  len = sizeof (*hdr) + gdk_pixbuf_get_width (pixbuf)
+    * gdk_pixbuf_get_height (pixbuf) * 2;
+  blob = g_malloc (len);
+  hdr = (HdWallpaperCacheHeader *)blob;
+  hdr->magic = CACHE_MAGIC;
+  hdr->version = CACHE_VERSION;
+  hdr->width = gdk_pixbuf_get_width (pixbuf);
+  hdr->height = gdk_pixbuf_get_height (pixbuf);
+  hdr->src_mtime = st->st_mtime;
+  hdr->src_size = st->st_size;
+  hd_wallpaper_cache_dither (pixbuf, (gushort *)(hdr + 1));
+  g_object_unref (pixbuf);
+
+  /* Failing to write the cache doesn't prevent us from using the image. */
+  path = hd_wallpaper_cache_get_path (source);
+  dir = g_path_get_dirname (path);
+  write_error = NULL;
+  g_mkdir_with_parents (dir, 0755);
+  if (!g_file_set_contents (path, blob, len, &write_error))
+    {
+      g_warning ("%s: %s", __FUNCTION__, write_error->message);
+      g_error_free (write_error);
+    }
+  else
+    g_debug ("%s: cached %s in %s", __FUNCTION__, source, path);
+  g_free (dir);
+  g_free (path);
+
+  return blob;
+}
+
+static gboolean
+hd_wallpaper_cache_stat (const gchar *source, struct stat *st,
+                         GError **error)
+{
+  if (g_stat (source, st) == 0)
+    return TRUE;
+
+  g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+               "%s: %s", source, g_strerror (errno));
+  return FALSE;
+}
+
+/* Returns a 16-bit texture of the image in @source, which is decoded
+ * only if it has changed since the last time. */
+ClutterActor *
+hd_wallpaper_cache_load (const gchar *source, GError **error)
+{
+  const HdWallpaperCacheHeader *hdr;
+  ClutterActor *texture;
+  struct stat st;
+  gchar *blob;
+
+  if (!hd_wallpaper_cache_stat (source, &st, error))
+    return NULL;
+  if (!(blob = hd_wallpaper_cache_read (source, &st))
+      && !(blob = hd_wallpaper_cache_build (source, &st, error)))
+    return NULL;
+
+  hdr = (const HdWallpaperCacheHeader *)blob;
+  texture = clutter_texture_new ();
+  if (!clutter_texture_set_from_rgb_data (CLUTTER_TEXTURE (texture),
+                                          (guchar *)(hdr + 1), FALSE,
+                                          hdr->width, hdr->height,
+                                          hdr->width * 2, 2,
+                                          CLUTTER_TEXTURE_FLAG_16_BIT,
+                                          error))
+    {
+      clutter_actor_destroy (texture);
+      texture = NULL;
+    }
+
+  g_free (blob);
+  return texture;
+}
+
+/* Makes sure @source is in the cache, without loading it. */
+gboolean
+hd_wallpaper_cache_prepare (const gchar *source)
+{
+  HdWallpaperCacheHeader hdr;
+  struct stat st, cst;
+  gchar *path, *blob;
+  gboolean fresh;
+  FILE *cache;
+
+  if (!hd_wallpaper_cache_stat (source, &st, NULL))
+    return FALSE;
+
+  /* Only look at the header. */
+  fresh = FALSE;
+  path = hd_wallpaper_cache_get_path (source);
+  if ((cache = fopen (path, "rb")) != NULL)
+    {
+      fresh = fstat (fileno (cache), &cst) == 0
+        && fread (&hdr, sizeof (hdr), 1, cache) == 1
+        && hd_wallpaper_cache_is_fresh (&hdr, cst.st_size, &st);
+      fclose (cache);
+    }
+  g_free (path);
+  if (fresh)
+    return TRUE;
+
+  blob = hd_wallpaper_cache_build (source, &st, NULL);
+  fresh = blob != NULL;
+  g_free (blob);
+  return fresh;
+}
@@ -0,0 +1,41 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Keeps the wallpapers in the form they are uploaded in (dithered RGB 565)
+ * under $XDG_CACHE_HOME/hildon-desktop/wallpapers, so that they're only
+ * decoded and dithered once per wallpaper change.
+ */
+
+#ifndef __HD_WALLPAPER_CACHE_H__
+#define __HD_WALLPAPER_CACHE_H__
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+ClutterActor *hd_wallpaper_cache_load    (const gchar *source,
+                                          GError     **error);
+gboolean      hd_wallpaper_cache_prepare (const gchar *source);
+
+G_END_DECLS
+
+#endif /* __HD_WALLPAPER_CACHE_H__ */
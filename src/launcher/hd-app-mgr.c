@@ -30,6 +30,7 @@
 #include "hd-app-mgr-glue.h"
 #include <errno.h>
 #include <fcntl.h>
+#include <math.h>
 #include <signal.h>
 #include <string.h>
 #include <stdio.h>
@@ -46,6 +47,9 @@
 #include <mce/mode-names.h>
 #include "hd-launcher.h"
 #include "hd-launcher-tree.h"
+#include "hd-app-stats.h"
+#include "hd-mem-pressure.h"
+#include "hd-launch-helper.h"
 #include "home/hd-render-manager.h"
 #include "home/hd-home-view-container.h"
 #include "hd-transition.h"
@@ -108,9 +112,15 @@ struct _HdAppMgrPrivate
   /* Each one of these lists contain different HdRunningApps. */
   GQueue *queues[NUM_QUEUES];
 
+  /* Usage statistics, used to order the queues. */
+  HdAppStats *stats;
+
   /* Is the state check already looping? */
   gboolean state_check_looping;
 
+  /* Idle measuring the memory of hibernatable apps. */
+  guint pss_sample_id;
+
   /* Memory limits. */
   HdAppMgrPrestartMode prestart_mode;
   size_t prestart_required_pages;
@@ -119,6 +129,10 @@ struct _HdAppMgrPrivate
   size_t notify_high_pages;
   size_t nr_decay_pages;
 
+  /* Memory pressure as seen by the kernel, in addition to the
+   * lowmem/bgkill signals. */
+  HdMemPressure *pressure;
+
   /* Memory status and prestarting flags.*/
   gboolean bg_killing:1;
   gboolean lowmem:1;
@@ -158,17 +172,31 @@ G_DEFINE_TYPE (HdAppMgr, hd_app_mgr, G_TYPE_OBJECT);
 /* Memory usage */
 #define LOWMEM_PROC_ALLOWED     "/proc/sys/vm/lowmem_allowed_pages"
 #define LOWMEM_PROC_USED        "/proc/sys/vm/lowmem_used_pages"
-#define LOWMEM_PROC_FREE        "/proc/sys/vm/lowmem_free_pages"
 #define LOWMEM_PROC_NOTIFY_LOW  "/proc/sys/vm/lowmem_notify_low_pages"
 #define LOWMEM_PROC_NOTIFY_HIGH "/proc/sys/vm/lowmem_notify_high_pages"
 #define LOWMEM_PROC_NR_DECAY    "/proc/sys/vm/lowmem_nr_decay_pages"
 
+/* Hibernation victim selection. Apps we haven't measured are assumed
+ * to use PSS_UNKNOWN_KB; a pass stops after reclaiming VICTIM_TARGET_KB
+ * (twice that when the pressure is critical). */
+#define PSS_MAX_AGE               (30)
+#define PSS_UNKNOWN_KB            (10 * 1024)
+#define VICTIM_TARGET_KB          (16 * 1024)
+#define VICTIM_MAX_PER_PASS       (3)
+#define VICTIM_RECENCY_TAU        (10 * 60)
+#define VICTIM_RELAUNCH_WEIGHT    (0.5)
+
 #define LOADAVG_MAX               (1.0)
 #define STATE_CHECK_INTERVAL      (1)
 #define LOADING_TIMEOUT           (10)
 #define INIT_DONE_TIMEOUT         (5)
 
+/* Usage statistics, relative to g_get_user_data_dir(). */
+#define APP_STATS_FILE            "hildon-desktop/app-stats"
+
 #define PRESTART_ENV_VAR          "HILDON_DESKTOP_APPS_PRESTART"
+/* If set, the memory pressure trace is written there on exit. */
+#define PRESSURE_TRACE_ENV_VAR    "HILDON_DESKTOP_MEM_PRESSURE_TRACE"
 #define NSIZE                     ((size_t)(-1))
 #define PRESTART_ENV_AUTO         ((size_t)(-2))
 #define PRESTART_ENV_NEVER        ((size_t)(-3))
@@ -257,6 +285,12 @@ static void hd_app_mgr_move_queue (HdAppMgrQueue queue_from,
                                    HdRunningApp *app);
 
 static size_t   hd_app_mgr_read_lowmem (const gchar *filename);
+static void     hd_app_mgr_pressure_changed (HdMemPressureLevel level,
+                                             gpointer data);
+static gboolean hd_app_mgr_is_lowmem (void);
+static gboolean hd_app_mgr_is_bg_killing (void);
+static void     hd_app_mgr_sample_memory (void);
+static void     hd_app_mgr_hibernate_victims (void);
 static HdAppMgrPrestartMode
 hd_app_mgr_setup_prestart (size_t low_pages,
                            size_t nr_decay_pages,
@@ -297,6 +331,8 @@ static gboolean hd_app_mgr_init_done_timeout (HdAppMgr *self);
 
 static void hd_app_mgr_kill_all_prestarted (void);
 
+static gchar **_hd_app_mgr_exec_argv (const gchar *exec);
+
 /* The HdLauncher singleton */
 static HdAppMgr *the_app_mgr = NULL;
 
@@ -419,6 +455,11 @@ hd_app_mgr_init (HdAppMgr *self)
   for (int i = 0; i < NUM_QUEUES; i++)
     priv->queues[i] = g_queue_new ();
 
+  gchar *stats_file = g_build_filename (g_get_user_data_dir (),
+                                        APP_STATS_FILE, NULL);
+  priv->stats = hd_app_stats_new (stats_file);
+  g_free (stats_file);
+
   priv->tree = hd_launcher_tree_new ();
   hd_launcher_tree_ensure_user_menu ();
   g_signal_connect (priv->tree, "finished",
@@ -510,6 +551,12 @@ hd_app_mgr_init (HdAppMgr *self)
   hd_app_mgr_setup_launch (priv->notify_high_pages,
                            priv->nr_decay_pages,
                            &priv->launch_required_pages);
+  if (priv->prestart_mode != PRESTART_ALWAYS)
+    priv->pressure = hd_mem_pressure_new (priv->prestart_required_pages,
+                                          priv->launch_required_pages,
+                                          priv->notify_low_pages,
+                                          hd_app_mgr_pressure_changed,
+                                          self);
 
   /* Start dbus signal tracking. */
   DBusGConnection *connection;
@@ -637,6 +684,11 @@ hd_app_mgr_stop ()
     return;
 
   hd_app_mgr_kill_all_prestarted ();
+  hd_app_stats_save (the_app_mgr->priv->stats);
+
+  const gchar *trace = g_getenv (PRESSURE_TRACE_ENV_VAR);
+  if (trace && the_app_mgr->priv->pressure)
+    hd_mem_pressure_save_trace (the_app_mgr->priv->pressure, trace);
 }
 
 static void
@@ -681,6 +733,25 @@ hd_app_mgr_dispose (GObject *gobject)
       priv->gconf_client = NULL;
     }
 
+  if (priv->stats)
+    {
+      hd_app_stats_save (priv->stats);
+      hd_app_stats_free (priv->stats);
+      priv->stats = NULL;
+    }
+
+  if (priv->pressure)
+    {
+      hd_mem_pressure_free (priv->pressure);
+      priv->pressure = NULL;
+    }
+
+  if (priv->pss_sample_id)
+    {
+      g_source_remove (priv->pss_sample_id);
+      priv->pss_sample_id = 0;
+    }
+
   G_OBJECT_CLASS (hd_app_mgr_parent_class)->dispose (gobject);
 }
 
@@ -704,7 +775,20 @@ _hd_app_mgr_compare_app_priority (gconstpointer a,
   gint a_priority = hd_launcher_app_get_priority (a_launcher);
   gint b_priority = hd_launcher_app_get_priority (b_launcher);
 
-  return b_priority - a_priority;
+  if (a_priority != b_priority)
+    return b_priority - a_priority;
+
+  /* Same priority, prefer the one the user is more likely to use now. */
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+  time_t now = time (NULL);
+  gdouble a_score = hd_app_stats_get_score (priv->stats,
+                          hd_launcher_item_get_id (HD_LAUNCHER_ITEM (a_launcher)),
+                          now);
+  gdouble b_score = hd_app_stats_get_score (priv->stats,
+                          hd_launcher_item_get_id (HD_LAUNCHER_ITEM (b_launcher)),
+                          now);
+
+  return (a_score < b_score) - (a_score > b_score);
 }
 
 static void
@@ -784,7 +868,10 @@ void hd_app_mgr_hibernatable (HdRunningApp *app, gboolean hibernatable)
       hibernatable ? "really" : "not");
 
   if (hibernatable)
-    hd_app_mgr_add_to_queue (QUEUE_HIBERNATABLE, app);
+    {
+      hd_app_mgr_add_to_queue (QUEUE_HIBERNATABLE, app);
+      hd_app_mgr_sample_memory ();
+    }
   else
     hd_app_mgr_remove_from_queue (QUEUE_HIBERNATABLE, app);
 
@@ -863,14 +950,17 @@ hd_app_mgr_timeout_backoff_factor ()
 static gdouble
 hd_app_mgr_system_load_average (void)
 {
-  int fd = open ("/proc/loadavg", O_RDONLY);
+  /* Keep the file open, proc files can be re-read from the start. */
+  static int fd = -2;
+
+  if (fd == -2)
+    fd = open ("/proc/loadavg", O_RDONLY);
 
   if (fd >= 0)
     {
       char buffer[32];
-      int size = read (fd, buffer, sizeof(buffer) -1);
+      int size = pread (fd, buffer, sizeof(buffer) -1, 0);
 
-      close (fd);
       if (size > 0)
         {
           gdouble load;
@@ -884,6 +974,17 @@ hd_app_mgr_system_load_average (void)
   return -1.0;
 }
 
+/* Statistics are kept per launcher, apps we know nothing about
+ * aren't accounted. */
+static const gchar *
+_hd_app_mgr_stats_id (HdRunningApp *app)
+{
+  HdLauncherApp *launcher = hd_running_app_get_launcher_app (app);
+
+  return launcher ? hd_launcher_item_get_id (HD_LAUNCHER_ITEM (launcher))
+                  : NULL;
+}
+
 /* This function either:
  * - Relaunches an app if already running.
  * - Wakes up an app if it's hibernating.
@@ -926,6 +1027,10 @@ hd_app_mgr_activate (HdRunningApp *app)
   switch (result)
   {
     case LAUNCH_OK:
+      if (state != HD_APP_STATE_LOADING && state != HD_APP_STATE_WAKING)
+        hd_app_stats_record_launch (
+                          HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ())->stats,
+                          _hd_app_mgr_stats_id (app), time (NULL));
       if (timer)
           {
             /* Start a loading timer. */
@@ -966,6 +1071,46 @@ _hd_app_mgr_child_exit (GPid pid, gint status, HdRunningApp *app)
   g_object_unref (app);
 }
 
+/* The launch helper has started @app or failed to. */
+static void
+_hd_app_mgr_child_spawned (GPid pid, gint error, HdRunningApp *app)
+{
+  if (pid)
+    {
+      hd_running_app_set_pid (app, pid);
+      return;
+    }
+
+  g_warning ("%s: %s", __FUNCTION__, g_strerror (error));
+  g_signal_emit (hd_app_mgr_get (), app_mgr_signals[APP_LOADING_FAIL],
+                 0, hd_running_app_get_launcher_app (app), NULL);
+  hd_app_mgr_app_closed (app);
+  g_object_unref (app);
+}
+
+/* Has the launch helper start @app.  The pid comes later, and so does
+ * the failure if the program can't be executed.  The helper holds
+ * a reference on @app meanwhile. */
+static gboolean
+_hd_app_mgr_helper_execute (const gchar *exec, HdRunningApp *app)
+{
+  gboolean res;
+  gchar **argv;
+
+  if (!(argv = _hd_app_mgr_exec_argv (exec)))
+    return FALSE;
+
+  res = hd_launch_helper_spawn (argv, NULL,
+                                (HdLaunchHelperFunc)_hd_app_mgr_child_spawned,
+                                (HdLaunchHelperFunc)_hd_app_mgr_child_exit,
+                                g_object_ref (app));
+  if (!res)
+    g_object_unref (app);
+  g_strfreev (argv);
+
+  return res;
+}
+
 HdAppMgrLaunchResult
 hd_app_mgr_start (HdRunningApp *app)
 {
@@ -994,7 +1139,11 @@ hd_app_mgr_start (HdRunningApp *app)
   else
     {
       exec = hd_launcher_app_get_exec (launcher);
-      if (exec)
+      if (exec && hd_launch_helper_is_running ())
+        result = _hd_app_mgr_helper_execute (exec, app);
+
+      /* Without the launch helper or if it's just gone. */
+      if (exec && !result && !hd_launch_helper_is_running ())
         {
           GPid pid = 0;
           result = hd_app_mgr_execute (exec, &pid, FALSE);
@@ -1123,6 +1272,13 @@ hd_app_mgr_kill_all (void)
 void hd_app_mgr_app_opened (HdRunningApp *app)
 {
   HdLauncherApp *launcher = hd_running_app_get_launcher_app (app);
+  HdRunningAppState state = hd_running_app_get_state (app);
+
+  /* Remember how expensive it is to bring this app back. */
+  if (state == HD_APP_STATE_LOADING || state == HD_APP_STATE_WAKING)
+    hd_running_app_set_launch_cost (app,
+                  difftime (time (NULL), hd_running_app_get_last_launch (app)));
+
   hd_running_app_set_state (app, HD_APP_STATE_SHOWN);
 
   /* Signal that the app has appeared.
@@ -1189,6 +1345,20 @@ hd_app_mgr_app_closed (HdRunningApp *app)
     }
 }
 
+/* Called when @app becomes the current application. */
+void
+hd_app_mgr_app_switched_to (HdRunningApp *app)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+  time_t now = time (NULL);
+
+  /* The launch has already been accounted for. */
+  if (difftime (now, hd_running_app_get_last_launch (app)) < LOADING_TIMEOUT)
+    return;
+
+  hd_app_stats_record_switch (priv->stats, _hd_app_mgr_stats_id (app), now);
+}
+
 /* Called when an hibernating app is closed in the switcher. */
 void
 hd_app_mgr_app_stop_hibernation (HdRunningApp *app)
@@ -1197,6 +1367,12 @@ hd_app_mgr_app_stop_hibernation (HdRunningApp *app)
   hd_app_mgr_app_closed (app);
 }
 
+static gboolean
+_hd_app_mgr_stats_keep (const gchar *id, HdLauncherTree *tree)
+{
+  return hd_launcher_tree_find_item (tree, id) != NULL;
+}
+
 static void
 hd_app_mgr_populate_tree_finished (HdLauncherTree *tree, gpointer data)
 {
@@ -1273,6 +1449,13 @@ hd_app_mgr_populate_tree_finished (HdLauncherTree *tree, gpointer data)
     }
 
   g_list_free (items_to_free);
+
+  /* Forget about uninstalled applications, unless reading the menu
+   * failed altogether. */
+  if (hd_launcher_tree_get_items (tree))
+    hd_app_stats_prune (priv->stats,
+                        (HdAppStatsKeepFunc)_hd_app_mgr_stats_keep, tree);
+
   hd_app_mgr_state_check ();
 }
 
@@ -1419,10 +1602,20 @@ _hd_app_mgr_child_setup(gpointer user_data)
   }
 }
 
-gboolean
-hd_app_mgr_execute (const gchar *exec, GPid *pid, gboolean auto_reap)
+/* Starts the launch helper unless $HD_NOPREFORK is set.  To be called
+ * first thing in main(). */
+void
+hd_app_mgr_start_launch_helper (void)
+{
+  if (!getenv ("HD_NOPREFORK"))
+    hd_launch_helper_start (_hd_app_mgr_child_setup, NULL);
+}
+
+/* Returns the argv to execute the command line @exec with, with the full
+ * path of the program, or %NULL if it can't be. */
+static gchar **
+_hd_app_mgr_exec_argv (const gchar *exec)
 {
-  gboolean res = FALSE;
   gchar *space = strchr (exec, ' ');
   gchar *exec_cmd;
   gint argc;
@@ -1448,7 +1641,29 @@ hd_app_mgr_execute (const gchar *exec, GPid *pid, gboolean auto_reap)
     if (argv)
       g_strfreev (argv);
 
+    return NULL;
+  }
+
+  g_free (exec_cmd);
+  return argv;
+}
+
+/* If @auto_reap the launch helper may start @exec, and then *@pid is 0. */
+gboolean
+hd_app_mgr_execute (const gchar *exec, GPid *pid, gboolean auto_reap)
+{
+  gboolean res = FALSE;
+  gchar **argv;
+
+  if (!(argv = _hd_app_mgr_exec_argv (exec)))
     return FALSE;
+
+  if (auto_reap
+      && hd_launch_helper_spawn (argv, NULL, NULL, NULL, NULL))
+  {
+    *pid = 0;
+    g_strfreev (argv);
+    return TRUE;
   }
 
   res = g_spawn_async (NULL,
@@ -1457,10 +1672,7 @@ hd_app_mgr_execute (const gchar *exec, GPid *pid, gboolean auto_reap)
                        _hd_app_mgr_child_setup, NULL,
                        pid,
                        NULL);
-  g_free (exec_cmd);
-
-  if (argv)
-    g_strfreev (argv);
+  g_strfreev (argv);
 
   return res;
 }
@@ -1625,11 +1837,176 @@ static gboolean hd_app_mgr_can_prestart (HdLauncherApp *launcher)
   if (!hd_app_mgr_check_loadavg ())
     return FALSE;
 
-  size_t free_pages = hd_app_mgr_read_lowmem (LOWMEM_PROC_FREE);
-  if (free_pages == NSIZE)
-    return TRUE;
+  return hd_mem_pressure_sample (priv->pressure) == HD_MEM_PRESSURE_NONE;
+}
+
+static void
+hd_app_mgr_pressure_changed (HdMemPressureLevel level, gpointer data)
+{
+  hd_app_mgr_state_check ();
+}
+
+/* The kernel's lowmem signals or a critical pressure. */
+static gboolean
+hd_app_mgr_is_lowmem (void)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+
+  return priv->lowmem ||
+    hd_mem_pressure_get_level (priv->pressure) >= HD_MEM_PRESSURE_CRITICAL;
+}
+
+static gboolean
+hd_app_mgr_is_bg_killing (void)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+
+  return priv->bg_killing ||
+    hd_mem_pressure_get_level (priv->pressure) >= HD_MEM_PRESSURE_MEDIUM;
+}
+
+/* Returns the proportional set size of @pid in kB, or the resident set
+ * size if the kernel can't tell the former cheaply. */
+static gsize
+hd_app_mgr_read_pss (GPid pid)
+{
+  gchar *filename, *contents = NULL;
+  gsize pss = 0;
+
+  filename = g_strdup_printf ("/proc/%d/smaps_rollup", pid);
+  if (g_file_get_contents (filename, &contents, NULL, NULL))
+    {
+      const gchar *p = strstr (contents, "\nPss:");
+      if (p)
+        pss = strtoul (p + strlen ("\nPss:"), NULL, 10);
+    }
+  else
+    {
+      unsigned long size, resident;
+
+      g_free (filename);
+      filename = g_strdup_printf ("/proc/%d/statm", pid);
+      if (g_file_get_contents (filename, &contents, NULL, NULL) &&
+          sscanf (contents, "%lu %lu", &size, &resident) == 2)
+        pss = resident * (sysconf (_SC_PAGESIZE) / 1024);
+    }
+
+  g_free (contents);
+  g_free (filename);
+  return pss;
+}
+
+/* Measures one hibernatable app whose measurement is missing or stale
+ * per call, so the cost is spread over several idles. */
+static gboolean
+hd_app_mgr_sample_memory_idle (gpointer data)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+  time_t now = time (NULL);
+  GList *link;
+
+  for (link = priv->queues[QUEUE_HIBERNATABLE]->head; link; link = link->next)
+    {
+      HdRunningApp *app = HD_RUNNING_APP (link->data);
+      GPid pid = hd_running_app_get_pid (app);
+
+      if (pid > 0 &&
+          difftime (now, hd_running_app_get_pss_time (app)) >= PSS_MAX_AGE)
+        {
+          hd_running_app_set_pss (app, hd_app_mgr_read_pss (pid), now);
+          return TRUE;
+        }
+    }
+
+  priv->pss_sample_id = 0;
+  return FALSE;
+}
+
+static void
+hd_app_mgr_sample_memory (void)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+
+  if (!priv->pss_sample_id)
+    priv->pss_sample_id = g_idle_add_full (G_PRIORITY_LOW,
+                                           hd_app_mgr_sample_memory_idle,
+                                           NULL, NULL);
+}
 
-  return free_pages >= priv->prestart_required_pages;
+static gsize
+hd_app_mgr_app_pss (HdRunningApp *app)
+{
+  return hd_running_app_get_pss_time (app) ? hd_running_app_get_pss (app)
+                                           : PSS_UNKNOWN_KB;
+}
+
+/*
+ * How worthwhile it is to hibernate @app: the memory we get back, less
+ * if the app has been used recently, is cheap to relaunch or likely to
+ * be used again soon.
+ */
+static gdouble
+hd_app_mgr_victim_value (HdRunningApp *app, time_t now)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+  const gchar *id = _hd_app_mgr_stats_id (app);
+  time_t last_use;
+  gdouble recency;
+
+  last_use = MAX (hd_app_stats_get_last_use (priv->stats, id),
+                  hd_running_app_get_last_launch (app));
+  recency = last_use ? exp (-difftime (now, last_use) / VICTIM_RECENCY_TAU)
+                     : 0.0;
+
+  return hd_app_mgr_app_pss (app) * (1.0 - 0.8 * recency)
+    / (1.0 + VICTIM_RELAUNCH_WEIGHT * hd_running_app_get_launch_cost (app))
+    / (1.0 + hd_app_stats_get_score (priv->stats, id, now));
+}
+
+/* Hibernates the most worthwhile apps until enough memory is reclaimed
+ * for the current pressure. */
+static void
+hd_app_mgr_hibernate_victims (void)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+  GQueue *hibernatable = priv->queues[QUEUE_HIBERNATABLE];
+  time_t now = time (NULL);
+  gsize target, reclaimed = 0;
+
+  target = VICTIM_TARGET_KB;
+  if (hd_mem_pressure_get_level (priv->pressure) >= HD_MEM_PRESSURE_CRITICAL)
+    target *= 2;
+
+  for (guint n = 0; n < VICTIM_MAX_PER_PASS && reclaimed < target &&
+                    !g_queue_is_empty (hibernatable); n++)
+    {
+      HdRunningApp *victim = NULL;
+      gdouble best = -1.0;
+      gsize pss;
+      GList *link;
+
+      for (link = hibernatable->head; link; link = link->next)
+        {
+          gdouble value = hd_app_mgr_victim_value (link->data, now);
+          if (value > best)
+            {
+              best = value;
+              victim = link->data;
+            }
+        }
+
+      pss = hd_app_mgr_app_pss (victim);
+      g_debug ("%s: hibernating %s (%zu kB, value %.0f)", __FUNCTION__,
+               hd_running_app_get_id (victim), pss, best);
+      if (hd_app_mgr_hibernate (victim))
+        reclaimed += pss;
+      else
+        /* Make sure we don't pick it again. */
+        hd_app_mgr_remove_from_queue (QUEUE_HIBERNATABLE, victim);
+    }
+
+  /* What's left may need fresher numbers for the next pass. */
+  hd_app_mgr_sample_memory ();
 }
 
 static void
@@ -1680,8 +2057,12 @@ hd_app_mgr_state_check_loop (gpointer data)
   gboolean loop = FALSE;
   HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
 
+  /* Without PSI nobody tells us when the pressure rises. */
+  if (!hd_mem_pressure_is_event_driven (priv->pressure))
+    hd_mem_pressure_sample (priv->pressure);
+
   /* First check if we are really low on memory. */
-  if (priv->lowmem)
+  if (hd_app_mgr_is_lowmem ())
     {
       /* If there are prestarted apps, kill one of them. */
       if (!g_queue_is_empty (priv->queues[QUEUE_PRESTARTED]))
@@ -1691,16 +2072,24 @@ hd_app_mgr_state_check_loop (gpointer data)
           if (!g_queue_is_empty (priv->queues[QUEUE_PRESTARTED]))
             loop = TRUE;
         }
+
+      /* It's no better for the background apps, hibernate them too,
+       * more of them than when we're only running low. */
+      if (hd_app_mgr_is_bg_killing () &&
+          !g_queue_is_empty (priv->queues[QUEUE_HIBERNATABLE]))
+        {
+          hd_app_mgr_hibernate_victims ();
+          if (!g_queue_is_empty (priv->queues[QUEUE_HIBERNATABLE]))
+            loop = TRUE;
+        }
     }
 
   /* If we're running low, hibernate an app. */
-  else if (priv->bg_killing)
+  else if (hd_app_mgr_is_bg_killing ())
     {
-      /* TODO: Hibernate an app and loop. */
       if (!g_queue_is_empty (priv->queues[QUEUE_HIBERNATABLE]))
         {
-          HdRunningApp *app = g_queue_peek_tail (priv->queues[QUEUE_HIBERNATABLE]);
-          hd_app_mgr_hibernate (app);
+          hd_app_mgr_hibernate_victims ();
           if (!g_queue_is_empty (priv->queues[QUEUE_HIBERNATABLE]))
             loop = TRUE;
         }
@@ -1726,15 +2115,25 @@ hd_app_mgr_state_check_loop (gpointer data)
            !g_queue_is_empty (priv->queues[QUEUE_PRESTARTABLE])
       )
     {
+      gboolean under_pressure = FALSE;
+
       /* We make this tests here to loop even if we can't prestart right now.*/
       if (!priv->prestarting)
         {
+          g_queue_sort (priv->queues[QUEUE_PRESTARTABLE],
+                        _hd_app_mgr_compare_app_priority, NULL);
           HdRunningApp *app = g_queue_peek_head (priv->queues[QUEUE_PRESTARTABLE]);
           HdLauncherApp *launcher = hd_running_app_get_launcher_app (app);
           if (launcher && hd_app_mgr_can_prestart (launcher))
             hd_app_mgr_prestart (app);
+          else
+            under_pressure = hd_mem_pressure_get_level (priv->pressure)
+                             != HD_MEM_PRESSURE_NONE;
         }
-      if (!g_queue_is_empty (priv->queues[QUEUE_PRESTARTABLE]))
+      /* We'll be called back when the pressure is gone,
+       * no need to poll meanwhile. */
+      if (!g_queue_is_empty (priv->queues[QUEUE_PRESTARTABLE]) &&
+          !under_pressure)
         loop = TRUE;
     }
 
@@ -2528,11 +2927,12 @@ hd_app_mgr_dump_app_list (gboolean only_running)
 
       if (!only_running || hd_running_app_get_state (app) == HD_APP_STATE_SHOWN)
         {
-          g_debug("\tapp=%p, id=%s, pid=%d, state=%d\n",
+          g_debug("\tapp=%p, id=%s, pid=%d, state=%d, pss=%zu kB\n",
                   app,
                   hd_running_app_get_id (app),
                   hd_running_app_get_pid (app),
-                  hd_running_app_get_state (app));
+                  hd_running_app_get_state (app),
+                  hd_running_app_get_pss (app));
         }
     }
 }
@@ -2555,4 +2955,12 @@ hd_app_mgr_dump_tree ()
     }
 }
 
+void
+hd_app_mgr_dump_stats ()
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+
+  hd_app_stats_dump (priv->stats);
+}
+
 #endif /* G_DEBUG_DISABLE */
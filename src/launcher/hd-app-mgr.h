@@ -87,6 +87,7 @@ HdRunningApp *hd_app_mgr_match_window (const char *res_name,
                                        GPid pid);
 void hd_app_mgr_app_opened (HdRunningApp *app);
 void hd_app_mgr_app_closed (HdRunningApp *app);
+void hd_app_mgr_app_switched_to (HdRunningApp *app);
 
 /* Application list. */
 HdLauncherTree *hd_app_mgr_get_tree (void);
@@ -95,10 +96,12 @@ HdLauncherTree *hd_app_mgr_get_tree (void);
 #ifndef G_DEBUG_DISABLE
 void hd_app_mgr_dump_app_list (gboolean only_running);
 void hd_app_mgr_dump_tree     (void);
+void hd_app_mgr_dump_stats    (void);
 #endif /* G_DEBUG_DISABLE */
 
 void hd_app_mgr_set_render_manager (GObject *rendermgr);
 
+void     hd_app_mgr_start_launch_helper (void);
 gboolean hd_app_mgr_execute (const gchar *exec, GPid *pid, gboolean auto_reap);
 
 gboolean hd_app_mgr_check_show_callui(void);
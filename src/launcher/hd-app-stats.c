@@ -0,0 +1,443 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-app-stats.h"
+
+#include <math.h>
+#include <string.h>
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "hd-app-stats"
+
+/* On-disk format, all numbers little endian:
+ *
+ *   "HDST" version:u8 pad:u8[3] n_records:u32
+ *   n_records * { id_len:u8 id:char[id_len] last_use:u32
+ *                 launches:u32 switches:u32 weight:u32
+ *                 hours:u16[STATS_TOD_BUCKETS] }
+ *
+ * weight is fixed point with STATS_WEIGHT_ONE being 1.0 and is valid
+ * at last_use.
+ */
+#define STATS_MAGIC           "HDST"
+#define STATS_VERSION         1
+#define STATS_HEADER_SIZE     12
+#define STATS_RECORD_SIZE(l)  (1 + (l) + 4 * 4 + 2 * STATS_TOD_BUCKETS)
+
+/* The day is split in buckets of three hours. */
+#define STATS_TOD_BUCKETS     8
+#define STATS_TOD_MAX         G_MAXUINT16
+
+/* Every event's weight halves after a week. */
+#define STATS_HALF_LIFE       (7 * 24 * 60 * 60)
+#define STATS_WEIGHT_ONE      1024
+#define STATS_LAUNCH_WEIGHT   1.0
+#define STATS_SWITCH_WEIGHT   0.5
+
+/* Delay writing to flash so a burst of events costs one write. */
+#define STATS_SAVE_DELAY      60
+
+typedef struct
+{
+  time_t  last_use;
+  guint32 launches;
+  guint32 switches;
+  gdouble weight;
+  guint16 hours[STATS_TOD_BUCKETS];
+} HdAppStatsEntry;
+
+struct _HdAppStats
+{
+  gchar      *filename;
+  GHashTable *entries;
+  guint       save_id;
+  gboolean    dirty;
+};
+
+static guint
+hd_app_stats_tod_bucket (time_t t)
+{
+  struct tm tm;
+
+  if (!localtime_r (&t, &tm))
+    return 0;
+  return tm.tm_hour * STATS_TOD_BUCKETS / 24;
+}
+
+/* Returns @entry's weight decayed to @now. */
+static gdouble
+hd_app_stats_decayed_weight (const HdAppStatsEntry *entry, time_t now)
+{
+  gdouble age = difftime (now, entry->last_use);
+
+  if (age <= 0)
+    return entry->weight;
+  return entry->weight * pow (2.0, -age / STATS_HALF_LIFE);
+}
+
+static void
+hd_app_stats_add_hour (HdAppStatsEntry *entry, time_t now)
+{
+  guint bucket = hd_app_stats_tod_bucket (now);
+
+  if (entry->hours[bucket] == STATS_TOD_MAX)
+    { /* Keep the proportions but make room. */
+      for (guint i = 0; i < STATS_TOD_BUCKETS; i++)
+        entry->hours[i] /= 2;
+    }
+  entry->hours[bucket]++;
+}
+
+static gboolean
+hd_app_stats_save_timeout (HdAppStats *stats)
+{
+  stats->save_id = 0;
+  hd_app_stats_save (stats);
+  return FALSE;
+}
+
+static void
+hd_app_stats_changed (HdAppStats *stats)
+{
+  stats->dirty = TRUE;
+  if (!stats->save_id)
+    stats->save_id = g_timeout_add_seconds (STATS_SAVE_DELAY,
+                               (GSourceFunc)hd_app_stats_save_timeout,
+                               stats);
+}
+
+static HdAppStatsEntry *
+hd_app_stats_lookup (HdAppStats *stats, const gchar *id, gboolean create)
+{
+  HdAppStatsEntry *entry;
+
+  entry = g_hash_table_lookup (stats->entries, id);
+  if (!entry && create && strlen (id) <= G_MAXUINT8)
+    {
+      entry = g_slice_new0 (HdAppStatsEntry);
+      g_hash_table_insert (stats->entries, g_strdup (id), entry);
+    }
+
+  return entry;
+}
+
+static void
+hd_app_stats_entry_free (HdAppStatsEntry *entry)
+{
+  g_slice_free (HdAppStatsEntry, entry);
+}
+
+static guint32
+hd_app_stats_get_u32 (const guchar *p)
+{
+  guint32 v;
+  memcpy (&v, p, sizeof (v));
+  return GUINT32_FROM_LE (v);
+}
+
+static guint16
+hd_app_stats_get_u16 (const guchar *p)
+{
+  guint16 v;
+  memcpy (&v, p, sizeof (v));
+  return GUINT16_FROM_LE (v);
+}
+
+static void
+hd_app_stats_load (HdAppStats *stats)
+{
+  gchar *contents;
+  gsize length, offset;
+  guint32 n_records;
+  const guchar *data;
+
+  if (!g_file_get_contents (stats->filename, &contents, &length, NULL))
+    return;
+
+  data = (const guchar *)contents;
+  if (length < STATS_HEADER_SIZE
+      || memcmp (data, STATS_MAGIC, 4)
+      || data[4] != STATS_VERSION)
+    {
+      g_warning ("%s: ignoring invalid statistics file %s",
+                 __FUNCTION__, stats->filename);
+      g_free (contents);
+      return;
+    }
+
+  n_records = hd_app_stats_get_u32 (data + 8);
+  offset = STATS_HEADER_SIZE;
+  for (guint32 r = 0; r < n_records; r++)
+    {
+      HdAppStatsEntry *entry;
+      const guchar *p;
+      guint id_len;
+      gchar *id;
+
+      if (offset >= length)
+        break;
+      id_len = data[offset];
+      if (!id_len || offset + STATS_RECORD_SIZE (id_len) > length)
+        break;
+
+      p = data + offset + 1;
+      id = g_strndup ((const gchar *)p, id_len);
+      p += id_len;
+
+      entry = g_slice_new0 (HdAppStatsEntry);
+      entry->last_use = hd_app_stats_get_u32 (p);
+      entry->launches = hd_app_stats_get_u32 (p + 4);
+      entry->switches = hd_app_stats_get_u32 (p + 8);
+      entry->weight = (gdouble)hd_app_stats_get_u32 (p + 12)
+                      / STATS_WEIGHT_ONE;
+      p += 16;
+      for (guint i = 0; i < STATS_TOD_BUCKETS; i++, p += 2)
+        entry->hours[i] = hd_app_stats_get_u16 (p);
+
+      g_hash_table_replace (stats->entries, id, entry);
+      offset += STATS_RECORD_SIZE (id_len);
+    }
+
+  g_free (contents);
+}
+
+HdAppStats *
+hd_app_stats_new (const gchar *filename)
+{
+  HdAppStats *stats = g_new0 (HdAppStats, 1);
+
+  stats->filename = g_strdup (filename);
+  stats->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                              g_free,
+                              (GDestroyNotify)hd_app_stats_entry_free);
+  hd_app_stats_load (stats);
+
+  return stats;
+}
+
+void
+hd_app_stats_free (HdAppStats *stats)
+{
+  if (!stats)
+    return;
+
+  if (stats->save_id)
+    g_source_remove (stats->save_id);
+  g_hash_table_destroy (stats->entries);
+  g_free (stats->filename);
+  g_free (stats);
+}
+
+static void
+hd_app_stats_record (HdAppStats *stats, const gchar *id,
+                     time_t now, gdouble weight)
+{
+  HdAppStatsEntry *entry;
+
+  if (!stats || !id)
+    return;
+  if (!(entry = hd_app_stats_lookup (stats, id, TRUE)))
+    return;
+
+  entry->weight = hd_app_stats_decayed_weight (entry, now) + weight;
+  entry->last_use = now;
+  hd_app_stats_add_hour (entry, now);
+  hd_app_stats_changed (stats);
+}
+
+void
+hd_app_stats_record_launch (HdAppStats *stats, const gchar *id, time_t now)
+{
+  HdAppStatsEntry *entry;
+
+  hd_app_stats_record (stats, id, now, STATS_LAUNCH_WEIGHT);
+  if (stats && id && (entry = hd_app_stats_lookup (stats, id, FALSE)))
+    entry->launches++;
+}
+
+void
+hd_app_stats_record_switch (HdAppStats *stats, const gchar *id, time_t now)
+{
+  HdAppStatsEntry *entry;
+
+  hd_app_stats_record (stats, id, now, STATS_SWITCH_WEIGHT);
+  if (stats && id && (entry = hd_app_stats_lookup (stats, id, FALSE)))
+    entry->switches++;
+}
+
+void
+hd_app_stats_prune (HdAppStats *stats,
+                    HdAppStatsKeepFunc keep,
+                    gpointer data)
+{
+  GHashTableIter iter;
+  gpointer key;
+  gboolean changed = FALSE;
+
+  if (!stats)
+    return;
+
+  g_hash_table_iter_init (&iter, stats->entries);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    if (!keep (key, data))
+      {
+        g_hash_table_iter_remove (&iter);
+        changed = TRUE;
+      }
+
+  if (changed)
+    hd_app_stats_changed (stats);
+}
+
+/*
+ * The score is the exponentially decayed number of uses, scaled by how
+ * much more (or less) than average the application is used at this time
+ * of the day.  Unknown applications score 0.
+ */
+gdouble
+hd_app_stats_get_score (HdAppStats *stats, const gchar *id, time_t now)
+{
+  HdAppStatsEntry *entry;
+  guint total = 0;
+  gdouble tod;
+
+  if (!stats || !id || !(entry = hd_app_stats_lookup (stats, id, FALSE)))
+    return 0.0;
+
+  for (guint i = 0; i < STATS_TOD_BUCKETS; i++)
+    total += entry->hours[i];
+
+  /* Laplace smoothing keeps apps with little history near 1. */
+  tod = (entry->hours[hd_app_stats_tod_bucket (now)] + 1.0)
+        / ((gdouble)total / STATS_TOD_BUCKETS + 1.0);
+
+  return hd_app_stats_decayed_weight (entry, now) * tod;
+}
+
+time_t
+hd_app_stats_get_last_use (HdAppStats *stats, const gchar *id)
+{
+  HdAppStatsEntry *entry;
+
+  if (!stats || !id || !(entry = hd_app_stats_lookup (stats, id, FALSE)))
+    return 0;
+  return entry->last_use;
+}
+
+static void
+hd_app_stats_put_u32 (GByteArray *buf, guint32 v)
+{
+  v = GUINT32_TO_LE (v);
+  g_byte_array_append (buf, (const guint8 *)&v, sizeof (v));
+}
+
+static void
+hd_app_stats_put_u16 (GByteArray *buf, guint16 v)
+{
+  v = GUINT16_TO_LE (v);
+  g_byte_array_append (buf, (const guint8 *)&v, sizeof (v));
+}
+
+void
+hd_app_stats_save (HdAppStats *stats)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GByteArray *buf;
+  GError *error = NULL;
+  gchar *dirname;
+  guint8 header[STATS_HEADER_SIZE] = { 0 };
+  guint32 n_records;
+
+  if (!stats || !stats->dirty)
+    return;
+
+  if (stats->save_id)
+    {
+      g_source_remove (stats->save_id);
+      stats->save_id = 0;
+    }
+
+  buf = g_byte_array_new ();
+  memcpy (header, STATS_MAGIC, 4);
+  header[4] = STATS_VERSION;
+  n_records = GUINT32_TO_LE (g_hash_table_size (stats->entries));
+  memcpy (header + 8, &n_records, sizeof (n_records));
+  g_byte_array_append (buf, header, sizeof (header));
+
+  g_hash_table_iter_init (&iter, stats->entries);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      const HdAppStatsEntry *entry = value;
+      guint8 id_len = strlen (key);
+      gdouble weight = MIN (entry->weight * STATS_WEIGHT_ONE, G_MAXUINT32);
+
+      g_byte_array_append (buf, &id_len, 1);
+      g_byte_array_append (buf, key, id_len);
+      hd_app_stats_put_u32 (buf, entry->last_use);
+      hd_app_stats_put_u32 (buf, entry->launches);
+      hd_app_stats_put_u32 (buf, entry->switches);
+      hd_app_stats_put_u32 (buf, (guint32)weight);
+      for (guint i = 0; i < STATS_TOD_BUCKETS; i++)
+        hd_app_stats_put_u16 (buf, entry->hours[i]);
+    }
+
+  dirname = g_path_get_dirname (stats->filename);
+  g_mkdir_with_parents (dirname, 0755);
+  g_free (dirname);
+
+  /* g_file_set_contents() replaces the file atomically. */
+  if (g_file_set_contents (stats->filename, (const gchar *)buf->data,
+                           buf->len, &error))
+    stats->dirty = FALSE;
+  else
+    {
+      g_warning ("%s: %s", __FUNCTION__, error->message);
+      g_error_free (error);
+    }
+
+  g_byte_array_free (buf, TRUE);
+}
+
+#ifndef G_DEBUG_DISABLE
+void
+hd_app_stats_dump (HdAppStats *stats)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  time_t now = time (NULL);
+
+  g_debug ("%s:\n", __FUNCTION__);
+  g_hash_table_iter_init (&iter, stats->entries);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      const HdAppStatsEntry *entry = value;
+
+      g_debug ("\tid=%s, launches=%u, switches=%u, score=%.3f\n",
+               (const gchar *)key, entry->launches, entry->switches,
+               hd_app_stats_get_score (stats, key, now));
+    }
+}
+#endif /* G_DEBUG_DISABLE */
@@ -0,0 +1,71 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * HdAppStats collects usage statistics (launches, switches and the time
+ * of day they happen) of applications, keyed by their launcher id, and
+ * turns them into a score used by HdAppMgr to decide which applications
+ * are worth keeping in memory.
+ */
+
+#ifndef __HD_APP_STATS_H__
+#define __HD_APP_STATS_H__
+
+#include <glib.h>
+#include <time.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HdAppStats HdAppStats;
+
+HdAppStats *hd_app_stats_new  (const gchar *filename);
+void        hd_app_stats_free (HdAppStats *stats);
+
+void hd_app_stats_record_launch (HdAppStats *stats,
+                                 const gchar *id,
+                                 time_t now);
+void hd_app_stats_record_switch (HdAppStats *stats,
+                                 const gchar *id,
+                                 time_t now);
+
+/* Drops the statistics of every application for which @keep returns
+ * %FALSE, e.g. because it has been uninstalled. */
+typedef gboolean (*HdAppStatsKeepFunc) (const gchar *id, gpointer data);
+void hd_app_stats_prune         (HdAppStats *stats,
+                                 HdAppStatsKeepFunc keep,
+                                 gpointer data);
+
+gdouble hd_app_stats_get_score  (HdAppStats *stats,
+                                 const gchar *id,
+                                 time_t now);
+time_t  hd_app_stats_get_last_use (HdAppStats *stats,
+                                   const gchar *id);
+
+/* Writes the statistics to disk if they changed since the last save. */
+void hd_app_stats_save (HdAppStats *stats);
+
+#ifndef G_DEBUG_DISABLE
+void hd_app_stats_dump (HdAppStats *stats);
+#endif /* G_DEBUG_DISABLE */
+
+G_END_DECLS
+
+#endif /* __HD_APP_STATS_H__ */
@@ -0,0 +1,513 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-launch-helper.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+/* The largest request; the environment is the bulk of it. */
+#define REQUEST_SIZE  (64 * 1024)
+
+/* How often (in seconds) to look if the children of a lost helper
+ * have exited. */
+#define ORPHAN_POLL_INTERVAL  5
+
+/*
+ * A request is the header followed by the @nargv strings of argv and
+ * the @nenvp strings of the environment, each with its terminating NUL.
+ * It's a single SOCK_SEQPACKET message, and so is every reply.
+ */
+typedef struct
+{
+  guint32 nargv, nenvp;
+} HdLaunchRequest;
+
+enum
+{
+  REPLY_SPAWNED,        /* @pid is running */
+  REPLY_FAILED,         /* the last request failed with errno @status */
+  REPLY_EXITED,         /* @pid exited with wait status @status */
+};
+
+typedef struct
+{
+  gint32 type, pid, status;
+} HdLaunchReply;
+
+/* A request we're waiting for the reply of, or a child we're waiting for
+ * the exit of.  Requests are answered in order, so the ones without
+ * a @pid are in the order they were sent. */
+typedef struct
+{
+  GPid                pid;
+  HdLaunchHelperFunc  spawned, exited;
+  gpointer            data;
+} HdLaunchChild;
+
+extern char **environ;
+
+/* Our end of the socket or -1, and its watch. */
+static gint helper_fd = -1;
+static guint helper_watch;
+static GPid helper_pid;
+static GQueue children;
+
+/* The children of helpers we've lost, which we poll for. */
+static GQueue orphans;
+static guint orphan_poll;
+
+/* In the helper. */
+static gint sigchld_pipe[2];
+
+/* The helper {{{ */
+static void
+helper_sigchld (int unused)
+{
+  int saved_errno = errno;
+
+  if (write (sigchld_pipe[1], "", 1) < 0)
+    /* The pipe is full, we'll reap them anyway. */;
+  errno = saved_errno;
+}
+
+static void
+helper_reply (gint sock, gint type, pid_t pid, gint status)
+{
+  HdLaunchReply reply;
+
+  reply.type = type;
+  reply.pid = pid;
+  reply.status = status;
+  if (send (sock, &reply, sizeof (reply), MSG_NOSIGNAL) < 0)
+    /* We're alone now. */
+    _exit (0);
+}
+
+static void
+helper_reap (gint sock)
+{
+  pid_t pid;
+  int status;
+  char buf[16];
+
+  while (read (sigchld_pipe[0], buf, sizeof (buf)) > 0)
+    ;
+  while ((pid = waitpid (-1, &status, WNOHANG)) > 0)
+    helper_reply (sock, REPLY_EXITED, pid, status);
+}
+
+/* Splits @n strings from @*strs into a NULL-terminated array. */
+static char **
+helper_split (char **strs, const char *end, guint32 n)
+{
+  char **array;
+  guint32 i;
+
+  if (!(array = calloc (n + 1, sizeof (*array))))
+    return NULL;
+
+  for (i = 0; i < n; i++)
+    {
+      const char *nul;
+
+      if (!(nul = memchr (*strs, '\0', end - *strs)))
+        {
+          free (array);
+          return NULL;
+        }
+      array[i] = *strs;
+      *strs = (char *)nul + 1;
+    }
+
+  return array;
+}
+
+static void
+helper_spawn (gint sock, char *buf, gsize len,
+              GSpawnChildSetupFunc child_setup, gpointer data)
+{
+  HdLaunchRequest req;
+  char **argv, **envp, *strs;
+  int errpipe[2], err;
+  ssize_t n;
+  pid_t pid;
+
+  argv = envp = NULL;
+  if (len < sizeof (req))
+    goto invalid;
+  memcpy (&req, buf, sizeof (req));
+  strs = buf + sizeof (req);
+  if (!req.nargv
+      || !(argv = helper_split (&strs, buf + len, req.nargv))
+      || !(envp = helper_split (&strs, buf + len, req.nenvp)))
+    goto invalid;
+
+  /* The child tells through @errpipe if it couldn't exec(). */
+  if (pipe (errpipe) < 0)
+    {
+      err = errno;
+      goto failed;
+    }
+  fcntl (errpipe[1], F_SETFD, FD_CLOEXEC);
+
+  if ((pid = fork ()) < 0)
+    {
+      err = errno;
+      close (errpipe[0]);
+      close (errpipe[1]);
+      goto failed;
+    }
+
+  if (!pid)
+    {
+      close (sock);
+      close (errpipe[0]);
+      close (sigchld_pipe[0]);
+      close (sigchld_pipe[1]);
+      signal (SIGCHLD, SIG_DFL);
+
+      if (child_setup)
+        child_setup (data);
+      execve (argv[0], argv, envp);
+
+      err = errno;
+      if (write (errpipe[1], &err, sizeof (err)) < 0)
+        /* Nobody will know. */;
+      _exit (127);
+    }
+
+  close (errpipe[1]);
+  while ((n = read (errpipe[0], &err, sizeof (err))) < 0 && errno == EINTR)
+    ;
+  close (errpipe[0]);
+
+  if (n == sizeof (err))
+    { /* Reap it before helper_reap() could report it. */
+      waitpid (pid, NULL, 0);
+      goto failed;
+    }
+
+  helper_reply (sock, REPLY_SPAWNED, pid, 0);
+  free (argv);
+  free (envp);
+  return;
+
+invalid:
+  err = EINVAL;
+failed:
+  helper_reply (sock, REPLY_FAILED, 0, err);
+  free (argv);
+  free (envp);
+}
+
+/* The helper's main loop.  Doesn't return. */
+static void
+helper_run (gint sock, GSpawnChildSetupFunc child_setup, gpointer data)
+{
+  static char buf[REQUEST_SIZE];
+  struct pollfd fds[2];
+  ssize_t len;
+  int i;
+
+  /* Only keep the socket and stdio, and take the default action
+   * on all signals but SIGCHLD, like a new process would. */
+  for (i = getdtablesize () - 1; i > STDERR_FILENO; i--)
+    if (i != sock)
+      close (i);
+  for (i = 1; i < NSIG; i++)
+    signal (i, SIG_DFL);
+
+  if (pipe (sigchld_pipe) < 0)
+    _exit (1);
+  fcntl (sigchld_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl (sigchld_pipe[1], F_SETFL, O_NONBLOCK);
+  signal (SIGCHLD, helper_sigchld);
+
+  fds[0].fd = sock;
+  fds[0].events = POLLIN;
+  fds[1].fd = sigchld_pipe[0];
+  fds[1].events = POLLIN;
+  for (;;)
+    {
+      if (poll (fds, G_N_ELEMENTS (fds), -1) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          _exit (1);
+        }
+
+      if (fds[1].revents & POLLIN)
+        helper_reap (sock);
+
+      if (fds[0].revents & POLLIN)
+        {
+          if ((len = recv (sock, buf, sizeof (buf), 0)) <= 0)
+            /* We've exited. */
+            _exit (0);
+          if (len == sizeof (buf))
+            /* Probably truncated. */
+            helper_reply (sock, REPLY_FAILED, 0, E2BIG);
+          else
+            helper_spawn (sock, buf, len, child_setup, data);
+        }
+      else if (fds[0].revents & (POLLHUP | POLLERR))
+        _exit (0);
+    }
+}
+/* }}} */
+
+/* The client {{{ */
+/*
+ * Calls @exited for the @orphans which are gone.  They are init's
+ * children now so we can't wait() for them, and their exit status
+ * is lost; they get 0.
+ */
+static gboolean
+orphans_poll (gpointer unused)
+{
+  GList *li, *next;
+
+  for (li = orphans.head; li; li = next)
+    {
+      HdLaunchChild *child = li->data;
+
+      next = li->next;
+      if (kill (child->pid, 0) == 0 || errno != ESRCH)
+        continue;
+
+      g_queue_delete_link (&orphans, li);
+      child->exited (child->pid, 0, child->data);
+      g_slice_free (HdLaunchChild, child);
+    }
+
+  if (g_queue_is_empty (&orphans))
+    {
+      orphan_poll = 0;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+/* The helper's gone, nobody will tell about the @children anymore.
+ * The requests it hasn't answered fail, the running ones are polled. */
+static void
+helper_lost (void)
+{
+  HdLaunchChild *child;
+
+  g_warning ("%s: the launch helper is gone", __FUNCTION__);
+  g_source_remove (helper_watch);
+  close (helper_fd);
+  helper_fd = -1;
+
+  /* Make sure it's gone and doesn't stay a zombie. */
+  kill (helper_pid, SIGKILL);
+  while (waitpid (helper_pid, NULL, 0) < 0 && errno == EINTR)
+    ;
+  helper_pid = 0;
+
+  while ((child = g_queue_pop_head (&children)) != NULL)
+    {
+      if (child->pid)
+        {
+          g_queue_push_tail (&orphans, child);
+          continue;
+        }
+      if (child->spawned)
+        child->spawned (0, EPIPE, child->data);
+      g_slice_free (HdLaunchChild, child);
+    }
+
+  if (!g_queue_is_empty (&orphans) && !orphan_poll)
+    orphan_poll = g_timeout_add_seconds (ORPHAN_POLL_INTERVAL,
+                                         orphans_poll, NULL);
+}
+
+static HdLaunchChild *
+find_child (GPid pid)
+{
+  GList *li;
+
+  for (li = children.head; li; li = li->next)
+    if (((HdLaunchChild *)li->data)->pid == pid)
+      return li->data;
+  return NULL;
+}
+
+static gboolean
+helper_replied (GIOChannel *chnl, GIOCondition cond, gpointer unused)
+{
+  HdLaunchReply reply;
+  HdLaunchChild *child;
+  ssize_t len;
+
+  if ((len = recv (helper_fd, &reply, sizeof (reply), MSG_DONTWAIT)) < 0
+      && (errno == EAGAIN || errno == EINTR))
+    return TRUE;
+  if (len != sizeof (reply))
+    {
+      helper_lost ();
+      return FALSE;
+    }
+
+  switch (reply.type)
+    {
+      case REPLY_SPAWNED:
+      case REPLY_FAILED:
+        /* The oldest request without a pid. */
+        if (!(child = find_child (0)))
+          break;
+        if (child->spawned)
+          child->spawned (reply.pid, reply.status, child->data);
+        if (reply.type == REPLY_SPAWNED && child->exited)
+          child->pid = reply.pid;
+        else
+          {
+            g_queue_remove (&children, child);
+            g_slice_free (HdLaunchChild, child);
+          }
+        break;
+      case REPLY_EXITED:
+        if (!(child = find_child (reply.pid)))
+          break;
+        g_queue_remove (&children, child);
+        child->exited (reply.pid, reply.status, child->data);
+        g_slice_free (HdLaunchChild, child);
+        break;
+    }
+
+  return TRUE;
+}
+
+/* Forks the helper.  Returns whether it's running. */
+gboolean
+hd_launch_helper_start (GSpawnChildSetupFunc child_setup, gpointer data)
+{
+  GIOChannel *chnl;
+  gint fds[2];
+  pid_t pid;
+
+  g_return_val_if_fail (helper_fd < 0, TRUE);
+
+  if (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0)
+    {
+      g_warning ("%s: socketpair: %s", __FUNCTION__, strerror (errno));
+      return FALSE;
+    }
+
+  if ((pid = fork ()) < 0)
+    {
+      g_warning ("%s: fork: %s", __FUNCTION__, strerror (errno));
+      close (fds[0]);
+      close (fds[1]);
+      return FALSE;
+    }
+  else if (!pid)
+    {
+      close (fds[0]);
+      helper_run (fds[1], child_setup, data);
+    }
+
+  close (fds[1]);
+  helper_fd = fds[0];
+  helper_pid = pid;
+  fcntl (helper_fd, F_SETFD, FD_CLOEXEC);
+
+  chnl = g_io_channel_unix_new (helper_fd);
+  helper_watch = g_io_add_watch (chnl, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                 helper_replied, NULL);
+  g_io_channel_unref (chnl);
+
+  return TRUE;
+}
+
+gboolean
+hd_launch_helper_is_running (void)
+{
+  return helper_fd >= 0;
+}
+
+/* Asks the helper to execute @argv[0], which must be a full path, with
+ * @argv and @envp, or our environment if it's %NULL.  Either callback
+ * may be %NULL.  Returns %FALSE if the helper isn't running; otherwise
+ * @spawned is called when it's done. */
+gboolean
+hd_launch_helper_spawn (gchar **argv, gchar **envp,
+                        HdLaunchHelperFunc spawned,
+                        HdLaunchHelperFunc exited,
+                        gpointer data)
+{
+  HdLaunchRequest req;
+  HdLaunchChild *child;
+  GString *buf;
+  ssize_t len;
+  guint i;
+
+  g_return_val_if_fail (argv && argv[0], FALSE);
+  if (helper_fd < 0)
+    return FALSE;
+  if (!envp)
+    envp = environ;
+
+  req.nargv = g_strv_length (argv);
+  req.nenvp = g_strv_length (envp);
+  buf = g_string_new_len ((const gchar *)&req, sizeof (req));
+  for (i = 0; argv[i]; i++)
+    g_string_append_len (buf, argv[i], strlen (argv[i]) + 1);
+  for (i = 0; envp[i]; i++)
+    g_string_append_len (buf, envp[i], strlen (envp[i]) + 1);
+
+  while ((len = send (helper_fd, buf->str, buf->len, MSG_NOSIGNAL)) < 0
+         && errno == EINTR)
+    ;
+  g_string_free (buf, TRUE);
+  if (len < 0)
+    {
+      if (errno == EMSGSIZE)
+        {
+          g_warning ("%s: %s: %s", __FUNCTION__, argv[0], strerror (errno));
+          return FALSE;
+        }
+      helper_lost ();
+      return FALSE;
+    }
+
+  child = g_slice_new0 (HdLaunchChild);
+  child->spawned = spawned;
+  child->exited = exited;
+  child->data = data;
+  g_queue_push_tail (&children, child);
+
+  return TRUE;
+}
+/* }}} */
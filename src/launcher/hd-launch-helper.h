@@ -0,0 +1,60 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Starts processes from a small helper process forked before we grow big,
+ * so that we don't need to fork ourselves, which would copy our page
+ * tables and stall the main loop.  The helper gets the command lines and
+ * environments over a socket, forks and executes them, and reports their
+ * pids and, when they exit, their wait statuses back, which are passed to
+ * @spawned and @exited in the main loop.  If the program couldn't be
+ * executed @spawned gets 0 and the errno, and @exited is never called.
+ * If the helper dies the children it started are polled for, and @exited
+ * gets a 0 status for them since the real one is lost.
+ *
+ * hd_launch_helper_start() must be called before there are threads
+ * or anything else which doesn't survive fork() well, preferably first
+ * thing in main().  @child_setup is called in the children like with
+ * g_spawn_async().  If the helper isn't running the callers need to
+ * start processes themselves.
+ */
+
+#ifndef __HD_LAUNCH_HELPER_H__
+#define __HD_LAUNCH_HELPER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef void (*HdLaunchHelperFunc) (GPid pid, gint status, gpointer data);
+
+gboolean hd_launch_helper_start      (GSpawnChildSetupFunc  child_setup,
+                                      gpointer              data);
+gboolean hd_launch_helper_is_running (void);
+gboolean hd_launch_helper_spawn      (gchar               **argv,
+                                      gchar               **envp,
+                                      HdLaunchHelperFunc    spawned,
+                                      HdLaunchHelperFunc    exited,
+                                      gpointer              data);
+
+G_END_DECLS
+
+#endif /* __HD_LAUNCH_HELPER_H__ */
@@ -0,0 +1,116 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-launcher-grid-motion.h"
+#include "hd-comp-mgr.h"
+
+#include <math.h>
+
+/* Tiles this far from the top left corner start moving last in sequenced
+ * transitions, whichever way the screen is. */
+#define ORDER_SPAN (HD_COMP_MGR_LANDSCAPE_WIDTH + HD_COMP_MGR_LANDSCAPE_HEIGHT)
+
+/* How far from the centre of the movement a tile at distance 1 is. */
+#define DISTANCE_SPAN 1000.0f
+
+/* Works out what hd_launcher_grid_motion_tile() needs to know about
+ * a tile at @x, @y when the tiles move away from or towards
+ * @centre_x, @centre_y. */
+void
+hd_launcher_grid_motion_prepare_tile (HdLauncherGridMotionTile *tile,
+                                      float x, float y,
+                                      float centre_x, float centre_y)
+{
+  float dx, dy;
+
+  dx = x - centre_x;
+  dy = y - centre_y;
+  tile->distance = sqrt(dx*dx + dy*dy) / DISTANCE_SPAN;
+  if (tile->distance > 1)
+    tile->distance = 1;
+
+  tile->order = (x + y) / ORDER_SPAN;
+  if (tile->order > 1)
+    tile->order = 1;
+}
+
+static inline float
+clamp01 (float x)
+{
+  return x < 0 ? 0 : x > 1 ? 1 : x;
+}
+
+/* Sets @state to where @tile is when @motion is at @amount, 0..1. */
+void
+hd_launcher_grid_motion_tile (const HdLauncherGridMotion *motion,
+                              const HdLauncherGridMotionTile *tile,
+                              float amount,
+                              HdLauncherGridTileState *state)
+{
+  float order_amt, label_amt, icon_amt;
+
+  state->icon_opacity = state->label_opacity = -1;
+  switch (motion->type)
+    {
+      case HD_LAUNCHER_GRID_MOTION_IN:
+        state->depth = motion->depth * (1 - amount);
+        state->opacity = 255;
+        state->icon_opacity = state->label_opacity = (int)(amount*255);
+        break;
+      case HD_LAUNCHER_GRID_MOTION_IN_SEQUENCED:
+        order_amt = clamp01 (amount*2 - tile->order);
+        label_amt = clamp01 (hd_key_frame_interpolate (motion->keyframes_label,
+                                                       order_amt));
+        icon_amt = clamp01 (hd_key_frame_interpolate (motion->keyframes_icon,
+                                                      order_amt));
+        state->depth = motion->depth
+          * (1 - hd_key_frame_interpolate (motion->keyframes, order_amt));
+        state->opacity = 255;
+        state->icon_opacity = (int)(icon_amt*255);
+        state->label_opacity = (int)(label_amt*255);
+        break;
+      case HD_LAUNCHER_GRID_MOTION_OUT:
+        state->depth = motion->depth * amount;
+        state->opacity = 255 - (int)(amount*255);
+        break;
+      case HD_LAUNCHER_GRID_MOTION_LAUNCH:
+        state->depth = -motion->depth * clamp01 (amount*2 - tile->distance);
+        state->opacity = 255 - (int)(amount*255);
+        break;
+      case HD_LAUNCHER_GRID_MOTION_BACK:
+        state->depth = -motion->depth * amount;
+        state->opacity = 255 - (int)(amount*255);
+        break;
+      case HD_LAUNCHER_GRID_MOTION_FORWARD:
+        state->depth = -motion->depth * (1 - amount);
+        state->opacity = (int)(amount*255);
+        break;
+      case HD_LAUNCHER_GRID_MOTION_NONE:
+        /* Left where they are. */
+        state->depth = 0;
+        state->opacity = -1;
+        break;
+    }
+}
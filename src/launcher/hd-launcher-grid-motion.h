@@ -0,0 +1,89 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * The arithmetic of the HdLauncherGrid transitions.  What depends on
+ * where a tile is, how far it's from the centre of the movement and
+ * when it starts moving in a sequenced transition, is worked out once
+ * per transition by hd_launcher_grid_motion_prepare_tile(), so that
+ * every frame hd_launcher_grid_motion_tile() only has a few multiplies
+ * and keyframe lookups to do per tile.
+ */
+
+#ifndef __HD_LAUNCHER_GRID_MOTION_H__
+#define __HD_LAUNCHER_GRID_MOTION_H__
+
+#include <glib.h>
+
+#include "hd-key-frame.h"
+
+G_BEGIN_DECLS
+
+/* How the tiles move, whatever transition the page is doing. */
+typedef enum
+{
+  HD_LAUNCHER_GRID_MOTION_NONE = 0,
+  HD_LAUNCHER_GRID_MOTION_IN,
+  HD_LAUNCHER_GRID_MOTION_IN_SEQUENCED,
+  HD_LAUNCHER_GRID_MOTION_OUT,
+  HD_LAUNCHER_GRID_MOTION_LAUNCH,
+  HD_LAUNCHER_GRID_MOTION_BACK,
+  HD_LAUNCHER_GRID_MOTION_FORWARD,
+} HdLauncherGridMotionType;
+
+typedef struct
+{
+  HdLauncherGridMotionType type;
+  /* How far the tiles move. */
+  float depth;
+  /* Only for HD_LAUNCHER_GRID_MOTION_IN_SEQUENCED. */
+  HdKeyFrameList *keyframes, *keyframes_label, *keyframes_icon;
+} HdLauncherGridMotion;
+
+/* Per tile, from hd_launcher_grid_motion_prepare_tile(). */
+typedef struct
+{
+  /* When the tile starts moving, 0..1, top left first. */
+  float order;
+  /* How far it is from the centre of the movement, 0..1. */
+  float distance;
+} HdLauncherGridMotionTile;
+
+/* Where a tile is at some point of the transition.  Opacities
+ * which are left alone are -1. */
+typedef struct
+{
+  float depth;
+  gint  opacity;
+  gint  icon_opacity, label_opacity;
+} HdLauncherGridTileState;
+
+void hd_launcher_grid_motion_prepare_tile (HdLauncherGridMotionTile *tile,
+                                           float x, float y,
+                                           float centre_x, float centre_y);
+void hd_launcher_grid_motion_tile (const HdLauncherGridMotion *motion,
+                                   const HdLauncherGridMotionTile *tile,
+                                   float amount,
+                                   HdLauncherGridTileState *state);
+
+G_END_DECLS
+
+#endif /* __HD_LAUNCHER_GRID_MOTION_H__ */
@@ -0,0 +1,107 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-launcher-grid-range.h"
+
+/*
+ * Sets @range to the rows of a grid of @n_rows rows, the first one at
+ * @first_row_y and every next one @row_pitch lower, which are visible
+ * between @view_y and @view_y + @view_height, plus @margin rows above
+ * and below them.  @view_y may be negative or past the end of the grid
+ * when the view is overshooting.
+ */
+void
+hd_launcher_grid_range_for_view (HdLauncherGridRange *range,
+                                 guint n_rows,
+                                 gint first_row_y, guint row_pitch,
+                                 gint view_y, guint view_height,
+                                 guint margin)
+{
+  gint top, bottom, first, last;
+
+  g_assert (row_pitch > 0);
+
+  top = view_y - first_row_y;
+  bottom = top + (gint)view_height;
+
+  /* Rounding towards minus infinity. */
+  first = top >= 0 ? top / (gint)row_pitch
+    : -((-top + (gint)row_pitch - 1) / (gint)row_pitch);
+  last = bottom > 0 ? (bottom + (gint)row_pitch - 1) / (gint)row_pitch
+    : -(-bottom / (gint)row_pitch);
+
+  first -= margin;
+  last += margin;
+
+  range->first = CLAMP (first, 0, (gint)n_rows);
+  range->last = CLAMP (last, (gint)range->first, (gint)n_rows);
+}
+
+/*
+ * Makes the rows in @wanted live and lets go of the rows in @live
+ * which are more than @keep rows away from @wanted, then updates @live.
+ * @func is called for every row whose state changes; rows which
+ * stop being live are reported before the new ones.  The live rows
+ * are always contiguous: if what's left of the old ones wouldn't touch
+ * @wanted, they're all let go.
+ */
+void
+hd_launcher_grid_range_update (HdLauncherGridRange *live,
+                               const HdLauncherGridRange *wanted,
+                               guint keep,
+                               HdLauncherGridRowFunc func,
+                               gpointer data)
+{
+  guint keep_first, keep_last, first, last, row;
+
+  keep_first = wanted->first > keep ? wanted->first - keep : 0;
+  keep_last = wanted->last + keep;
+
+  /* What's left of @live. */
+  first = MAX (live->first, keep_first);
+  last = MIN (live->last, keep_last);
+
+  if (wanted->first == wanted->last
+      || first >= last || last < wanted->first || first > wanted->last)
+    {
+      first = wanted->first;
+      last = wanted->last;
+    }
+  else
+    {
+      first = MIN (first, wanted->first);
+      last = MAX (last, wanted->last);
+    }
+
+  for (row = live->first; row < live->last; row++)
+    if (row < first || row >= last)
+      func (row, FALSE, data);
+  for (row = first; row < last; row++)
+    if (row < live->first || row >= live->last)
+      func (row, TRUE, data);
+
+  live->first = first;
+  live->last = last;
+}
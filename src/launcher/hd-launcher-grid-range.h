@@ -0,0 +1,64 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Which rows of a HdLauncherGrid have their tiles on the stage.
+ * hd_launcher_grid_range_for_view() works out the rows near what's
+ * on the screen, and hd_launcher_grid_range_update() moves the live
+ * rows there, telling the grid which rows to load and which ones
+ * to let go.  Rows which have just scrolled out are kept for a while,
+ * so scrolling back and forth around a row boundary doesn't reload
+ * the same icons over and over.
+ *
+ * There's nothing Clutter here, so it can be tested on its own.
+ */
+
+#ifndef __HD_LAUNCHER_GRID_RANGE_H__
+#define __HD_LAUNCHER_GRID_RANGE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Rows @first..@last-1; empty if @first == @last. */
+typedef struct
+{
+  guint first, last;
+} HdLauncherGridRange;
+
+/* Called for every row which becomes @live or stops being so. */
+typedef void (*HdLauncherGridRowFunc) (guint row, gboolean live,
+                                       gpointer data);
+
+void hd_launcher_grid_range_for_view (HdLauncherGridRange *range,
+                                      guint n_rows,
+                                      gint first_row_y, guint row_pitch,
+                                      gint view_y, guint view_height,
+                                      guint margin);
+void hd_launcher_grid_range_update (HdLauncherGridRange *live,
+                                    const HdLauncherGridRange *wanted,
+                                    guint keep,
+                                    HdLauncherGridRowFunc func,
+                                    gpointer data);
+
+G_END_DECLS
+
+#endif /* __HD_LAUNCHER_GRID_RANGE_H__ */
@@ -38,10 +38,10 @@
 #include <tidy/tidy-interval.h>
 #include <tidy/tidy-scrollable.h>
 
-#include <math.h>
-
 #include "hd-launcher.h"
 #include "hd-launcher-item.h"
+#include "hd-launcher-grid-range.h"
+#include "hd-launcher-grid-motion.h"
 #include "hd-comp-mgr.h"
 #include "hd-util.h"
 #include "hd-transition.h"
@@ -63,10 +63,22 @@
 
 #define HD_LAUNCHER_GRID_GET_PRIVATE(obj)       (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HD_TYPE_LAUNCHER_GRID, HdLauncherGridPrivate))
 
+/* How many rows above and below the screen have their tiles loaded,
+ * and how many more are kept loaded after scrolling away from them. */
+#define HD_LAUNCHER_GRID_MARGIN_ROWS 1
+#define HD_LAUNCHER_GRID_KEEP_ROWS   1
+
 struct _HdLauncherGridPrivate
 {
-  /* list of actors */
-  GList *tiles;
+  /* All our HdLauncherTile:s, in order, whether they're on the stage
+   * or not.  Only the tiles in the rows of @live are our children and
+   * are loaded; the rest are just their icon names and texts, so that
+   * hundreds of apps don't cost hundreds of textures. */
+  GPtrArray *tiles;
+  HdLauncherGridRange live;
+  /* Set while we're adding or removing tiles in the rows of @live,
+   * so that actor_added() and actor_removed() leave @tiles alone. */
+  gboolean updating_live;
   /* list of 'blocker' actors that block presses
    * on the empty rows of pixels between the icons */
   GList *blockers;
@@ -77,14 +89,12 @@ struct _HdLauncherGridPrivate
   TidyAdjustment *h_adjustment;
   TidyAdjustment *v_adjustment;
 
-  /* How far the transition will move the icons */
-  gint transition_depth;
-  /* Do we move the icons all together or in sequence? for launcher_in transitions */
-  gboolean transition_sequenced;
-  /* List of keyframes used on transitions like _IN and _IN_SUB */
-  HdKeyFrameList *transition_keyframes; // ramp for tile movement
-  HdKeyFrameList *transition_keyframes_label; // ramp for label alpha values
-  HdKeyFrameList *transition_keyframes_icon; // ramp for icon alpha values
+  /* How the current transition moves the tiles, and what it needs
+   * to know about each of them, in the order of @tiles. */
+  HdLauncherGridMotion motion;
+  ClutterVertex motion_centre;
+  HdLauncherGridMotionTile *motion_tiles;
+  guint n_motion_tiles;
 
   /* an internal status indicating how to relayout the grid (which usually is
    * the same of the real device orientation, but may not be in sync with it) */
@@ -115,6 +125,8 @@ static gboolean _hd_launcher_grid_blocker_release_cb (ClutterActor *actor,
                                         gpointer *data);
 
 static gboolean      hd_launcher_grid_is_portrait (HdLauncherGrid *self);
+static void          hd_launcher_grid_update_live (HdLauncherGrid *grid);
+static void          hd_launcher_grid_prepare_motion (HdLauncherGrid *grid);
 #define HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE 5
 #define HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT 3
 
@@ -239,6 +251,7 @@ adjustment_value_notify (GObject    *gobject,
   clutter_actor_set_anchor_point(grid,
                              0,
                              tidy_adjustment_get_value(priv->v_adjustment));
+  hd_launcher_grid_update_live (HD_LAUNCHER_GRID (grid));
 }
 
 static void
@@ -350,9 +363,11 @@ hd_launcher_grid_actor_added (ClutterContainer *container,
 
   g_object_ref (actor);
 
-  if (HD_IS_LAUNCHER_TILE(actor))
+  if (HD_IS_LAUNCHER_TILE(actor) && !priv->updating_live)
     {
-      priv->tiles = g_list_append (priv->tiles, g_object_ref(actor));
+      /* It's loaded by the next hd_launcher_grid_layout()
+       * if it's near the screen. */
+      g_ptr_array_add (priv->tiles, g_object_ref(actor));
 
       /* relayout moved to the traversal code */
     }
@@ -368,10 +383,10 @@ hd_launcher_grid_actor_removed (ClutterContainer *container,
 
   g_object_ref (actor);
 
-  if (HD_IS_LAUNCHER_TILE(actor))
+  if (HD_IS_LAUNCHER_TILE(actor) && !priv->updating_live)
     {
-      priv->tiles = g_list_remove (priv->tiles, actor);
-      g_object_unref(actor);
+      if (g_ptr_array_remove (priv->tiles, actor))
+        g_object_unref(actor);
 
       /* relayout moved to the traversal code */
     }
@@ -385,12 +400,12 @@ _hd_launcher_grid_count_children_and_rows (HdLauncherGrid *grid,
                                            guint *rows)
 {
   HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID_GET_PRIVATE (grid);
-  GList *l;
+  guint i;
 
   *children = 0;
-  for (l = priv->tiles; l != NULL; l = l->next)
+  for (i = 0; i < priv->tiles->len; i++)
     {
-      ClutterActor *child = l->data;
+      ClutterActor *child = g_ptr_array_index (priv->tiles, i);
 
       if (CLUTTER_ACTOR_IS_VISIBLE (child))
         {
@@ -416,19 +431,19 @@ _hd_launcher_grid_count_children_and_rows (HdLauncherGrid *grid,
 
 /**
  * Allocates a number of tiles in a row, starting at cur_y.
- * Returns the remaining children list (ie still to allocate).
+ * Returns the index of the first tile still to allocate.
  *
  * @grid: the HdLauncherGrid instance
- * @l: list of tiles still to be inserted in the layout
+ * @i: index of the first tile of the row in priv->tiles
  * @remaining is a memory address containing a pointer to the number of
  * children still to insert into the grid.
  * @cur_y: the current y position of the grid, from where to begin placing
  * tiles
  * @h_spacing is the icon horizonal spacing.
  */
-static GList *
+static guint
 _hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
-                                GList *l,
+                                guint i,
                                 guint *remaining,
                                 guint cur_y,
                                 guint h_spacing)
@@ -436,6 +451,7 @@ _hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
   ClutterActor *child;
   guint allocated;
   guint cur_x;
+  guint n;
 
   /* Figure out the starting X position needed to centre the icons */
   if (hd_launcher_grid_is_portrait (grid))
@@ -456,17 +472,150 @@ _hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
     }
 
   /* for each icon in the row... */
-  for (int i = 0; i < allocated; i++)
+  for (n = 0; n < allocated; n++)
     {
-      child = l->data;
+      child = g_ptr_array_index (grid->priv->tiles, i);
 
       clutter_actor_set_position(child, cur_x, cur_y);
       cur_x += HD_LAUNCHER_TILE_WIDTH + h_spacing;
 
-      l = l->next;
+      i++;
     }
   *remaining -= allocated;
-  return l;
+  return i;
+}
+
+static guint
+hd_launcher_grid_columns (HdLauncherGrid *grid)
+{
+  return hd_launcher_grid_is_portrait (grid)
+    ? HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT
+    : HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE;
+}
+
+/* Puts @tile on or off the stage. */
+static void
+hd_launcher_grid_set_tile_live (HdLauncherGrid *grid, HdLauncherTile *tile,
+                                gboolean live)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  ClutterActor *actor = CLUTTER_ACTOR (tile);
+  gboolean is_child;
+
+  /* Tiles which have just been added are our children already,
+   * but they aren't loaded yet. */
+  is_child = clutter_actor_get_parent (actor) == CLUTTER_ACTOR (grid);
+
+  priv->updating_live = TRUE;
+  if (live)
+    {
+      hd_launcher_tile_load (tile);
+      if (!is_child)
+        {
+          /* Undo whatever the last transition left it with while it was
+           * away; if there's one going on, its next frame sets it right. */
+          clutter_actor_set_depth (actor, 0);
+          clutter_actor_set_opacity (actor, 255);
+          if (hd_launcher_tile_get_icon (tile))
+            clutter_actor_set_opacity (hd_launcher_tile_get_icon (tile), 255);
+          if (hd_launcher_tile_get_label (tile))
+            clutter_actor_set_opacity (hd_launcher_tile_get_label (tile),
+                                       255);
+
+          clutter_container_add_actor (CLUTTER_CONTAINER (grid), actor);
+        }
+    }
+  else
+    {
+      /* We still have our reference in @tiles. */
+      if (is_child)
+        clutter_container_remove_actor (CLUTTER_CONTAINER (grid), actor);
+      hd_launcher_tile_unload (tile);
+    }
+  priv->updating_live = FALSE;
+}
+
+static void
+hd_launcher_grid_set_row_live (guint row, gboolean live, gpointer data)
+{
+  HdLauncherGrid *grid = data;
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns, i;
+
+  columns = hd_launcher_grid_columns (grid);
+  for (i = row * columns; i < (row + 1) * columns && i < priv->tiles->len; i++)
+    hd_launcher_grid_set_tile_live (grid, g_ptr_array_index (priv->tiles, i),
+                                    live);
+}
+
+/* Which rows should be live when the grid is scrolled where it is. */
+static void
+hd_launcher_grid_get_wanted_rows (HdLauncherGrid *grid,
+                                  HdLauncherGridRange *wanted)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns, n_rows, screen_height;
+  gint first_row_y, view_y;
+
+  columns = hd_launcher_grid_columns (grid);
+  n_rows = (priv->tiles->len + columns - 1) / columns;
+
+  if (hd_launcher_grid_is_portrait (grid))
+    {
+      first_row_y = HD_LAUNCHER_PAGE_XMARGIN;
+      screen_height = HD_COMP_MGR_PORTRAIT_HEIGHT;
+    }
+  else
+    {
+      first_row_y = HD_LAUNCHER_PAGE_YMARGIN;
+      screen_height = HD_COMP_MGR_LANDSCAPE_HEIGHT;
+    }
+
+  /* The grid is never taller on the screen than the screen, and the
+   * margin rows make up for it starting somewhat below the top. */
+  view_y = priv->v_adjustment
+    ? (gint)tidy_adjustment_get_value (priv->v_adjustment) : 0;
+
+  hd_launcher_grid_range_for_view (wanted, n_rows,
+                                   first_row_y,
+                                   HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing,
+                                   view_y, screen_height,
+                                   HD_LAUNCHER_GRID_MARGIN_ROWS);
+}
+
+/* Loads the rows which have scrolled near the screen and lets go
+ * of the ones which have scrolled far enough from it. */
+static void
+hd_launcher_grid_update_live (HdLauncherGrid *grid)
+{
+  HdLauncherGridRange wanted;
+
+  /* We're being disposed of. */
+  if (!grid->priv->tiles)
+    return;
+
+  hd_launcher_grid_get_wanted_rows (grid, &wanted);
+  hd_launcher_grid_range_update (&grid->priv->live, &wanted,
+                                 HD_LAUNCHER_GRID_KEEP_ROWS,
+                                 hd_launcher_grid_set_row_live, grid);
+}
+
+/* Like hd_launcher_grid_update_live(), but doesn't assume the tiles
+ * are where they were the last time, because they have been added,
+ * removed or moved to a different number of columns. */
+static void
+hd_launcher_grid_reset_live (HdLauncherGrid *grid)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns, i;
+
+  hd_launcher_grid_get_wanted_rows (grid, &priv->live);
+
+  columns = hd_launcher_grid_columns (grid);
+  for (i = 0; i < priv->tiles->len; i++)
+    hd_launcher_grid_set_tile_live (grid, g_ptr_array_index (priv->tiles, i),
+                                    priv->live.first <= i / columns
+                                    && i / columns < priv->live.last);
 }
 
 /* hd_launcher_grid_layout:
@@ -486,7 +635,7 @@ _hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
 void hd_launcher_grid_layout (HdLauncherGrid *grid)
 {
   HdLauncherGridPrivate *priv = grid->priv;
-  GList *l;
+  guint i;
   guint cur_height, n_visible_launchers, n_rows;
 
   /* Free our list of 'blocker' actors that we use to block mouse clicks.
@@ -505,12 +654,12 @@ void hd_launcher_grid_layout (HdLauncherGrid *grid)
   else
     cur_height = HD_LAUNCHER_PAGE_YMARGIN;
 
-  l = priv->tiles;
-  while (l) {
+  i = 0;
+  while (i < priv->tiles->len) {
     /* Allocate all icons on this row */
-    l = _hd_launcher_grid_layout_row(grid, l, &n_visible_launchers,
+    i = _hd_launcher_grid_layout_row(grid, i, &n_visible_launchers,
                                        cur_height, priv->h_spacing);
-    if (l)
+    if (i < priv->tiles->len)
       {
         /* If there is another row, we must create an actor that
          * goes between the two rows that will grab the clicks that
@@ -567,6 +716,12 @@ void hd_launcher_grid_layout (HdLauncherGrid *grid)
 
   if (priv->v_adjustment)
     hd_launcher_grid_refresh_v_adjustment (grid);
+
+  hd_launcher_grid_reset_live (grid);
+
+  /* The tiles have moved under a transition. */
+  if (priv->motion_tiles)
+    hd_launcher_grid_prepare_motion (grid);
 }
 
 static void
@@ -574,15 +729,27 @@ hd_launcher_grid_dispose (GObject *gobject)
 {
   HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID (gobject)->priv;
 
-  g_list_foreach (priv->tiles,
-                  (GFunc) clutter_actor_destroy,
-                  NULL);
-  g_list_free (priv->tiles);
-  priv->tiles = NULL;
+  if (priv->tiles)
+    {
+      GPtrArray *tiles = priv->tiles;
+      guint i;
+
+      /* Don't let actor_removed() touch them while they go. */
+      priv->tiles = NULL;
+      priv->updating_live = TRUE;
+      for (i = 0; i < tiles->len; i++)
+        {
+          clutter_actor_destroy (g_ptr_array_index (tiles, i));
+          g_object_unref (g_ptr_array_index (tiles, i));
+        }
+      g_ptr_array_free (tiles, TRUE);
+    }
 
   g_list_free(priv->blockers);
   priv->blockers = NULL;
 
+  hd_launcher_grid_transition_end (HD_LAUNCHER_GRID (gobject));
+
   G_OBJECT_CLASS (hd_launcher_grid_parent_class)->dispose (gobject);
 }
 
@@ -725,6 +892,7 @@ hd_launcher_grid_init (HdLauncherGrid *launcher)
   HdLauncherGridPrivate *priv;
 
   launcher->priv = priv = HD_LAUNCHER_GRID_GET_PRIVATE (launcher);
+  priv->tiles = g_ptr_array_new ();
 
   /* set grid's orientation and h/v_spacing values to landscape by default */
   hd_launcher_grid_set_portrait (launcher, FALSE);
@@ -747,21 +915,26 @@ void
 hd_launcher_grid_clear (HdLauncherGrid *grid)
 {
   HdLauncherGridPrivate *priv;
-  GList *l;
+  guint i;
 
   g_return_if_fail (HD_IS_LAUNCHER_GRID (grid));
 
   priv = grid->priv;
 
-  l = priv->tiles;
-  while (l)
+  /* Only the live ones are our children. */
+  priv->updating_live = TRUE;
+  for (i = 0; i < priv->tiles->len; i++)
     {
-      ClutterActor *child = l->data;
-
-      l = l->next;
+      ClutterActor *child = g_ptr_array_index (priv->tiles, i);
 
-      clutter_container_remove_actor (CLUTTER_CONTAINER (grid), child);
+      if (clutter_actor_get_parent (child) == CLUTTER_ACTOR (grid))
+        clutter_container_remove_actor (CLUTTER_CONTAINER (grid), child);
+      g_object_unref (child);
     }
+  priv->updating_live = FALSE;
+
+  g_ptr_array_set_size (priv->tiles, 0);
+  priv->live.first = priv->live.last = 0;
 }
 
 /* Reset the grid before it is shown */
@@ -769,89 +942,140 @@ void
 hd_launcher_grid_reset(HdLauncherGrid *grid, gboolean hard)
 {
   HdLauncherGridPrivate *priv;
-  GList *l;
+  guint i;
 
   g_return_if_fail (HD_IS_LAUNCHER_GRID (grid));
 
   priv = grid->priv;
-  l = priv->tiles;
 
-  while (l)
+  for (i = 0; i < priv->tiles->len; i++)
     {
-      HdLauncherTile *tile = l->data;
+      HdLauncherTile *tile = g_ptr_array_index (priv->tiles, i);
 
       hd_launcher_tile_reset(tile, hard);
-      l = l->next;
     }
 }
 
 
+/* Works out where every tile is relative to the movement, so that
+ * hd_launcher_grid_transition() doesn't have to every frame. */
+static void
+hd_launcher_grid_prepare_motion (HdLauncherGrid *grid)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint i;
+
+  g_free (priv->motion_tiles);
+  priv->n_motion_tiles = priv->tiles->len;
+  priv->motion_tiles = g_new (HdLauncherGridMotionTile, priv->n_motion_tiles);
+
+  for (i = 0; i < priv->n_motion_tiles; i++)
+    {
+      ClutterVertex pos = {0,0,0};
+
+      /* Even tiles which aren't on the stage have their positions. */
+      clutter_actor_get_positionu (g_ptr_array_index (priv->tiles, i),
+                                   &pos.x, &pos.y);
+      hd_launcher_grid_motion_prepare_tile (&priv->motion_tiles[i],
+                            CLUTTER_UNITS_TO_FLOAT (pos.x),
+                            CLUTTER_UNITS_TO_FLOAT (pos.y),
+                            CLUTTER_UNITS_TO_FLOAT (priv->motion_centre.x),
+                            CLUTTER_UNITS_TO_FLOAT (priv->motion_centre.y));
+    }
+}
+
 void
 hd_launcher_grid_transition_begin(HdLauncherGrid *grid,
+                                  HdLauncherPage *page,
                                   HdLauncherPageTransition trans_type)
 {
   HdLauncherGridPrivate *priv = grid->priv;
+  const gchar *trans_name;
 
-  priv->transition_depth =
-      hd_transition_get_int(
-                hd_launcher_page_get_transition_string(trans_type),
-                "depth",
-                100 /* default value */);
-  priv->transition_sequenced = 0;
-  if (trans_type == HD_LAUNCHER_PAGE_TRANSITION_IN ||
-      trans_type == HD_LAUNCHER_PAGE_TRANSITION_IN_SUB)
-    {
-      priv->transition_sequenced =
-            hd_transition_get_int(
-                      hd_launcher_page_get_transition_string(trans_type),
-                      "sequenced",
-                      0);
-      if (priv->transition_sequenced)
-        {
-          grid->priv->transition_keyframes =
-            hd_transition_get_keyframes(
-                      hd_launcher_page_get_transition_string(trans_type),
-                      "keyframes", "0,1");
-          grid->priv->transition_keyframes_label =
-            hd_transition_get_keyframes(
-                      hd_launcher_page_get_transition_string(trans_type),
-                      "keyframes_label", "0,1");
-          grid->priv->transition_keyframes_icon =
-                 hd_transition_get_keyframes(
-                      hd_launcher_page_get_transition_string(trans_type),
-                      "keyframes_icon", "0,1");
-        }
+  /* In case the last one didn't end. */
+  hd_launcher_grid_transition_end (grid);
 
-      /* Reset adjustments so the view is always back to 0,0 */
-      if (priv->h_adjustment)
-        tidy_adjustment_set_valuex (priv->h_adjustment, 0);
+  trans_name = hd_launcher_page_get_transition_string(trans_type);
+  priv->motion.depth = hd_transition_get_int(trans_name,
+                                             "depth",
+                                             100 /* default value */);
+  priv->motion_centre.x = priv->motion_centre.y = 0;
 
-      if (priv->v_adjustment)
-        tidy_adjustment_set_valuex (priv->v_adjustment, 0);
+  switch (trans_type)
+    {
+      case HD_LAUNCHER_PAGE_TRANSITION_IN:
+      case HD_LAUNCHER_PAGE_TRANSITION_IN_SUB:
+        /* Do we move the icons all together or in sequence? */
+        if (hd_transition_get_int(trans_name, "sequenced", 0))
+          {
+            priv->motion.type = HD_LAUNCHER_GRID_MOTION_IN_SEQUENCED;
+            /* ramp for tile movement */
+            priv->motion.keyframes =
+              hd_transition_get_keyframes(trans_name, "keyframes", "0,1");
+            /* ramp for label alpha values */
+            priv->motion.keyframes_label =
+              hd_transition_get_keyframes(trans_name, "keyframes_label", "0,1");
+            /* ramp for icon alpha values */
+            priv->motion.keyframes_icon =
+              hd_transition_get_keyframes(trans_name, "keyframes_icon", "0,1");
+          }
+        else
+          priv->motion.type = HD_LAUNCHER_GRID_MOTION_IN;
+
+        /* Reset adjustments so the view is always back to 0,0 */
+        if (priv->h_adjustment)
+          tidy_adjustment_set_valuex (priv->h_adjustment, 0);
+
+        if (priv->v_adjustment)
+          tidy_adjustment_set_valuex (priv->v_adjustment, 0);
+        break;
+      case HD_LAUNCHER_PAGE_TRANSITION_OUT:
+      case HD_LAUNCHER_PAGE_TRANSITION_OUT_SUB:
+        priv->motion.type = HD_LAUNCHER_GRID_MOTION_OUT;
+        break;
+      case HD_LAUNCHER_PAGE_TRANSITION_LAUNCH:
+        priv->motion.type = HD_LAUNCHER_GRID_MOTION_LAUNCH;
+        clutter_actor_get_sizeu(CLUTTER_ACTOR(page),
+                                &priv->motion_centre.x,
+                                &priv->motion_centre.y);
+        break;
+      case HD_LAUNCHER_PAGE_TRANSITION_BACK:
+        priv->motion.type = HD_LAUNCHER_GRID_MOTION_BACK;
+        break;
+      case HD_LAUNCHER_PAGE_TRANSITION_FORWARD:
+        priv->motion.type = HD_LAUNCHER_GRID_MOTION_FORWARD;
+        break;
+      case HD_LAUNCHER_PAGE_TRANSITION_OUT_BACK:
+        /* We don't do anything for these now because we just use blur on
+         * the whole group */
+        priv->motion.type = HD_LAUNCHER_GRID_MOTION_NONE;
+        break;
     }
+
+  hd_launcher_grid_prepare_motion (grid);
 }
 
 void
 hd_launcher_grid_transition_end(HdLauncherGrid *grid)
 {
+  HdLauncherGridPrivate *priv = grid->priv;
+
   /* Free anything we may have allocated for the transition here */
-  if (grid->priv->transition_keyframes)
-    {
-      hd_key_frame_list_free(grid->priv->transition_keyframes);
-      grid->priv->transition_keyframes = 0;
-    }
-  if (grid->priv->transition_keyframes_label)
-    {
-      hd_key_frame_list_free(grid->priv->transition_keyframes_label);
-      grid->priv->transition_keyframes_label = 0;
-    }
-  if (grid->priv->transition_keyframes_icon)
-    {
-      hd_key_frame_list_free(grid->priv->transition_keyframes_icon);
-      grid->priv->transition_keyframes_icon = 0;
-    }
+  hd_key_frame_list_free(priv->motion.keyframes);
+  hd_key_frame_list_free(priv->motion.keyframes_label);
+  hd_key_frame_list_free(priv->motion.keyframes_icon);
+  priv->motion.keyframes = NULL;
+  priv->motion.keyframes_label = NULL;
+  priv->motion.keyframes_icon = NULL;
+  priv->motion.type = HD_LAUNCHER_GRID_MOTION_NONE;
+
+  g_free (priv->motion_tiles);
+  priv->motion_tiles = NULL;
+  priv->n_motion_tiles = 0;
 }
 
+/* Moves the tiles on the stage to where the transition begun by
+ * hd_launcher_grid_transition_begin() has them at @amount. */
 void
 hd_launcher_grid_transition(HdLauncherGrid *grid,
                             HdLauncherPage *page,
@@ -859,135 +1083,36 @@ hd_launcher_grid_transition(HdLauncherGrid *grid,
                             float amount)
 {
   HdLauncherGridPrivate *priv;
-  GList *l;
-  ClutterVertex movement_centre = {0,0,0};
-
-  switch (trans_type)
-   {
-     case HD_LAUNCHER_PAGE_TRANSITION_IN:
-       movement_centre.x = 0;
-       movement_centre.y = 0;
-       break;
-     case HD_LAUNCHER_PAGE_TRANSITION_LAUNCH:
-       clutter_actor_get_sizeu(CLUTTER_ACTOR(page),
-                               &movement_centre.x, &movement_centre.y);
-       break;
-     default:
-       break;
-   }
+  guint i, first, last;
 
   g_return_if_fail (HD_IS_LAUNCHER_GRID (grid));
 
   priv = grid->priv;
+  if (priv->motion.type == HD_LAUNCHER_GRID_MOTION_NONE)
+    return;
 
-  l = priv->tiles;
-  while (l)
+  /* The rest aren't on the stage. */
+  first = priv->live.first * hd_launcher_grid_columns (grid);
+  last = MIN (priv->live.last * hd_launcher_grid_columns (grid),
+              priv->n_motion_tiles);
+  for (i = first; i < last; i++)
     {
-      ClutterActor *child = l->data;
-      l = l->next;
-      if (HD_IS_LAUNCHER_TILE(child))
-      {
-        HdLauncherTile *tile = HD_LAUNCHER_TILE(child);
-        ClutterActor *tile_icon = 0;
-        ClutterActor *tile_label = 0;
-        ClutterVertex pos = {0,0,0};
-        float d, dx, dy;
-        float order_diff;
-        float order_amt; /* amount as if ordered */
-        ClutterUnit depth;
-
-        tile_icon = hd_launcher_tile_get_icon(tile);
-        tile_label = hd_launcher_tile_get_label(tile);
-
-        clutter_actor_get_positionu(CLUTTER_ACTOR(tile), &pos.x, &pos.y);
-        dx = CLUTTER_UNITS_TO_FLOAT(pos.x - movement_centre.x);
-        dy = CLUTTER_UNITS_TO_FLOAT(pos.y - movement_centre.y);
-        /* We always want d to be 0 <=d <= 1 */
-        d = sqrt(dx*dx + dy*dy) / 1000.0f;
-        if (d>1) d=1;
-
-        order_diff = (CLUTTER_UNITS_TO_FLOAT(pos.x) +
-                     (CLUTTER_UNITS_TO_FLOAT(pos.y))) /
-                       (HD_COMP_MGR_LANDSCAPE_WIDTH +
-                        HD_COMP_MGR_LANDSCAPE_HEIGHT);
-        if (order_diff>1) order_diff = 1;
-        order_amt = amount*2 - order_diff;
-        if (order_amt<0) order_amt = 0;
-        if (order_amt>1) order_amt = 1;
-
-        switch (trans_type)
-          {
-            case HD_LAUNCHER_PAGE_TRANSITION_IN:
-            case HD_LAUNCHER_PAGE_TRANSITION_IN_SUB:
-              {
-                float label_amt, icon_amt;
-
-                if (priv->transition_sequenced)
-                  {
-                    label_amt = hd_key_frame_interpolate(
-                          priv->transition_keyframes_label, order_amt);
-                    icon_amt = hd_key_frame_interpolate(
-                          priv->transition_keyframes_icon, order_amt);
-
-                    if (label_amt<0) label_amt=0;
-                    if (label_amt>1) label_amt=1;
-                    if (icon_amt<0) icon_amt = 0;
-                    if (icon_amt>1) icon_amt = 1;
-                    depth = CLUTTER_UNITS_FROM_FLOAT(
-                       priv->transition_depth *
-                       (1 - hd_key_frame_interpolate(priv->transition_keyframes,
-                                                     order_amt)));
-                  }
-                else
-                  {
-                    depth = CLUTTER_UNITS_FROM_FLOAT(
-                                        priv->transition_depth * (1 - amount));
-                    label_amt = amount;
-                    icon_amt = amount;
-                  }
-
-                clutter_actor_set_depthu(CLUTTER_ACTOR(tile), depth);
-                clutter_actor_set_opacity(CLUTTER_ACTOR(tile), 255);
-                if (tile_icon)
-                  clutter_actor_set_opacity(tile_icon, (int)(icon_amt*255));
-                if (tile_label)
-                  clutter_actor_set_opacity(tile_label, (int)(label_amt*255));
-                break;
-              }
-            case HD_LAUNCHER_PAGE_TRANSITION_OUT:
-            case HD_LAUNCHER_PAGE_TRANSITION_OUT_SUB:
-              {
-                depth = CLUTTER_UNITS_FROM_FLOAT(priv->transition_depth*amount);
-                clutter_actor_set_depthu(CLUTTER_ACTOR(tile), depth);
-                clutter_actor_set_opacity(CLUTTER_ACTOR(tile), 255 - (int)(amount*255));
-                break;
-              }
-            case HD_LAUNCHER_PAGE_TRANSITION_LAUNCH:
-              {
-                float tile_amt = amount*2 - d;
-                if (tile_amt<0) tile_amt = 0;
-                if (tile_amt>1) tile_amt = 1;
-                depth = CLUTTER_UNITS_FROM_FLOAT(-priv->transition_depth*tile_amt);
-                clutter_actor_set_depthu(CLUTTER_ACTOR(tile), depth);
-                clutter_actor_set_opacity(CLUTTER_ACTOR(tile), 255 - (int)(amount*255));
-                break;
-              }
-            /* We do't do anything for these now because we just use blur on
-             * the whole group */
-            case HD_LAUNCHER_PAGE_TRANSITION_BACK:
-                depth = CLUTTER_UNITS_FROM_FLOAT(-priv->transition_depth*amount);
-                clutter_actor_set_depthu(CLUTTER_ACTOR(tile), depth);
-                clutter_actor_set_opacity(CLUTTER_ACTOR(tile), 255 - (int)(amount*255));
-                break;
-            case HD_LAUNCHER_PAGE_TRANSITION_FORWARD:
-                depth = CLUTTER_UNITS_FROM_FLOAT(-priv->transition_depth*(1-amount));
-                clutter_actor_set_depthu(CLUTTER_ACTOR(tile), depth);
-                clutter_actor_set_opacity(CLUTTER_ACTOR(tile), (int)(amount*255));
-                break;
-            case HD_LAUNCHER_PAGE_TRANSITION_OUT_BACK:
-                break;
-          }
-      }
+      HdLauncherTile *tile = g_ptr_array_index (priv->tiles, i);
+      HdLauncherGridTileState state;
+      ClutterActor *tile_icon, *tile_label;
+
+      hd_launcher_grid_motion_tile (&priv->motion, &priv->motion_tiles[i],
+                                    amount, &state);
+
+      clutter_actor_set_depthu(CLUTTER_ACTOR(tile),
+                               CLUTTER_UNITS_FROM_FLOAT(state.depth));
+      clutter_actor_set_opacity(CLUTTER_ACTOR(tile), state.opacity);
+      if (state.icon_opacity >= 0
+          && (tile_icon = hd_launcher_tile_get_icon(tile)) != NULL)
+        clutter_actor_set_opacity(tile_icon, state.icon_opacity);
+      if (state.label_opacity >= 0
+          && (tile_label = hd_launcher_tile_get_label(tile)) != NULL)
+        clutter_actor_set_opacity(tile_label, state.label_opacity);
     }
 }
 
@@ -1002,14 +1127,7 @@ _hd_launcher_grid_blocker_release_cb (ClutterActor *actor,
 void hd_launcher_grid_activate(ClutterActor *actor, int p)
 {
   HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID_GET_PRIVATE (actor);
-  GList *l = priv->tiles;
-
-  while ((p > 0) && l)
-    {
-      l=l->next;
-      p--;
-    }
 
-  if (l && !p)
-    hd_launcher_tile_activate (l->data);
+  if (p >= 0 && p < priv->tiles->len)
+    hd_launcher_tile_activate (g_ptr_array_index (priv->tiles, p));
 }
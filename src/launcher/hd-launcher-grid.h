@@ -68,6 +68,7 @@ void          hd_launcher_grid_clear    (HdLauncherGrid *grid);
 void          hd_launcher_grid_reset_v_adjustment (HdLauncherGrid *grid);
 
 void          hd_launcher_grid_transition_begin(HdLauncherGrid *grid,
+                                  HdLauncherPage *page,
                                   HdLauncherPageTransition trans_type);
 void          hd_launcher_grid_transition_end(HdLauncherGrid *grid);
 void          hd_launcher_grid_transition(HdLauncherGrid *grid,
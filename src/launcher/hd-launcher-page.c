@@ -396,7 +396,8 @@ void hd_launcher_page_transition(HdLauncherPage *page, HdLauncherPageTransition
          break;
   }
 
-  hd_launcher_grid_transition_begin(HD_LAUNCHER_GRID(priv->grid), trans_type);
+  hd_launcher_grid_transition_begin(HD_LAUNCHER_GRID(priv->grid),
+                                    page, trans_type);
 
   priv->transition = clutter_timeline_new_for_duration(
       hd_transition_get_int(
@@ -0,0 +1,379 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-launcher-search.h"
+
+#include <string.h>
+
+/* The longest substrings indexed, in characters. */
+#define GRAM_CHARS    3
+
+typedef struct
+{
+  gpointer item;
+
+  /* As given, to tell whether an update changes anything. */
+  gchar *name, *exec;
+
+  /* Casefolded, and the collation key of @name to sort by. */
+  gchar *name_key, *exec_key, *collate_key;
+
+  gboolean removed;
+} Entry;
+
+struct _HdLauncherSearch
+{
+  /* item -> Entry */
+  GHashTable *entries;
+
+  /* gram -> GPtrArray of the Entries it occurs in, in no order */
+  GHashTable *grams;
+
+  /* Removed Entries still in the lists of @grams. */
+  GPtrArray *removed;
+};
+
+/* Returns the casefolded and normalized @str, or NULL if it's not
+ * UTF-8. */
+static gchar *
+fold (const gchar *str)
+{
+  gchar *normal, *folded;
+
+  if (!(normal = g_utf8_normalize (str, -1, G_NORMALIZE_ALL)))
+    return NULL;
+  folded = g_utf8_casefold (normal, -1);
+  g_free (normal);
+
+  return folded;
+}
+
+/* Returns the name of the program @exec starts, casefolded. */
+static gchar *
+fold_exec (const gchar *exec)
+{
+  gchar *path, *base, *folded;
+  const gchar *end;
+
+  while (*exec == ' ' || *exec == '\t')
+    exec++;
+  for (end = exec; *end && *end != ' ' && *end != '\t'; end++)
+    ;
+  if (end == exec)
+    return NULL;
+
+  path = g_strndup (exec, end - exec);
+  base = g_path_get_basename (path);
+  folded = fold (base);
+  g_free (base);
+  g_free (path);
+
+  return folded;
+}
+
+static void
+entry_free (Entry *entry)
+{
+  g_free (entry->name);
+  g_free (entry->exec);
+  g_free (entry->name_key);
+  g_free (entry->exec_key);
+  g_free (entry->collate_key);
+  g_free (entry);
+}
+
+/* Adds @entry to the lists of all the grams of @key. */
+static void
+index_key (HdLauncherSearch *search, Entry *entry, const gchar *key)
+{
+  gchar gram[GRAM_CHARS * 6 + 1];
+  const gchar *start, *end;
+  GPtrArray *list;
+  guint n;
+
+  for (start = key; *start; start = g_utf8_next_char (start))
+    for (end = start, n = 0; *end && n < GRAM_CHARS; n++)
+      {
+        end = g_utf8_next_char (end);
+        memcpy (gram, start, end - start);
+        gram[end - start] = '\0';
+
+        if (!(list = g_hash_table_lookup (search->grams, gram)))
+          {
+            list = g_ptr_array_new ();
+            g_hash_table_insert (search->grams, g_strdup (gram), list);
+          }
+
+        /* Only this entry is being added, so if it's in the list
+         * it's the last one. */
+        if (!list->len || g_ptr_array_index (list, list->len - 1) != entry)
+          g_ptr_array_add (list, entry);
+      }
+}
+
+static void
+compact_list (gpointer gram, gpointer value, gpointer unused)
+{
+  GPtrArray *list = value;
+  guint i;
+
+  for (i = 0; i < list->len; )
+    if (((Entry *)g_ptr_array_index (list, i))->removed)
+      g_ptr_array_remove_index_fast (list, i);
+    else
+      i++;
+}
+
+static gboolean
+list_is_empty (gpointer gram, gpointer value, gpointer unused)
+{
+  return !((GPtrArray *)value)->len;
+}
+
+/* Drops the removed entries from the lists once there are more of them
+ * than live ones, so removing stays cheap and the lists stay short. */
+static void
+compact (HdLauncherSearch *search)
+{
+  if (search->removed->len <= g_hash_table_size (search->entries))
+    return;
+
+  g_hash_table_foreach (search->grams, compact_list, NULL);
+  g_hash_table_foreach_remove (search->grams, list_is_empty, NULL);
+  g_ptr_array_foreach (search->removed, (GFunc)entry_free, NULL);
+  g_ptr_array_set_size (search->removed, 0);
+}
+
+static void
+free_list (gpointer list)
+{
+  g_ptr_array_free (list, TRUE);
+}
+
+HdLauncherSearch *
+hd_launcher_search_new (void)
+{
+  HdLauncherSearch *search;
+
+  search = g_new0 (HdLauncherSearch, 1);
+  search->entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+  search->grams = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, free_list);
+  search->removed = g_ptr_array_new ();
+
+  return search;
+}
+
+static void
+free_entry (gpointer item, gpointer entry, gpointer unused)
+{
+  entry_free (entry);
+}
+
+void
+hd_launcher_search_free (HdLauncherSearch *search)
+{
+  g_hash_table_foreach (search->entries, free_entry, NULL);
+  g_hash_table_destroy (search->entries);
+  g_hash_table_destroy (search->grams);
+  g_ptr_array_foreach (search->removed, (GFunc)entry_free, NULL);
+  g_ptr_array_free (search->removed, TRUE);
+  g_free (search);
+}
+
+/* Indexes @item by @name and by the program @exec runs.
+ * Either can be NULL. */
+void
+hd_launcher_search_add (HdLauncherSearch *search, gpointer item,
+                        const gchar *name, const gchar *exec)
+{
+  Entry *entry;
+
+  hd_launcher_search_remove (search, item);
+
+  entry = g_new0 (Entry, 1);
+  entry->item = item;
+  entry->name = g_strdup (name);
+  entry->exec = g_strdup (exec);
+  entry->name_key = name ? fold (name) : NULL;
+  entry->exec_key = exec ? fold_exec (exec) : NULL;
+  entry->collate_key = g_utf8_collate_key (entry->name_key
+                                           ? entry->name_key : "", -1);
+
+  if (entry->name_key)
+    index_key (search, entry, entry->name_key);
+  if (entry->exec_key)
+    index_key (search, entry, entry->exec_key);
+
+  g_hash_table_insert (search->entries, item, entry);
+}
+
+void
+hd_launcher_search_remove (HdLauncherSearch *search, gpointer item)
+{
+  Entry *entry;
+
+  if (!(entry = g_hash_table_lookup (search->entries, item)))
+    return;
+
+  g_hash_table_remove (search->entries, item);
+  entry->removed = TRUE;
+  g_ptr_array_add (search->removed, entry);
+  compact (search);
+}
+
+/*
+ * @new_item replaces @old_item, which may be NULL.  If its names are
+ * the same the entry is just handed over to @new_item without indexing
+ * anything, which is the usual case when the tree is reloaded.
+ */
+void
+hd_launcher_search_update (HdLauncherSearch *search,
+                           gpointer old_item, gpointer new_item,
+                           const gchar *name, const gchar *exec)
+{
+  Entry *entry;
+
+  entry = old_item ? g_hash_table_lookup (search->entries, old_item) : NULL;
+  if (entry && old_item != new_item
+      && !g_hash_table_lookup (search->entries, new_item)
+      && !g_strcmp0 (entry->name, name) && !g_strcmp0 (entry->exec, exec))
+    {
+      g_hash_table_remove (search->entries, old_item);
+      entry->item = new_item;
+      g_hash_table_insert (search->entries, new_item, entry);
+      return;
+    }
+
+  if (old_item)
+    hd_launcher_search_remove (search, old_item);
+  hd_launcher_search_add (search, new_item, name, exec);
+}
+
+guint
+hd_launcher_search_size (HdLauncherSearch *search)
+{
+  return g_hash_table_size (search->entries);
+}
+
+static gboolean
+entry_has_prefix (const Entry *entry, const gchar *key)
+{
+  return (entry->name_key && g_str_has_prefix (entry->name_key, key))
+    || (entry->exec_key && g_str_has_prefix (entry->exec_key, key));
+}
+
+static gint
+entry_cmp (gconstpointer a, gconstpointer b)
+{
+  const Entry *ea = *(const Entry **)a, *eb = *(const Entry **)b;
+  gint cmp;
+
+  if ((cmp = strcmp (ea->collate_key, eb->collate_key)) != 0)
+    return cmp;
+
+  /* Keep the order stable among namesakes. */
+  return ea->item < eb->item ? -1 : ea->item > eb->item;
+}
+
+/*
+ * Returns the items whose name or program contains @text, ignoring case,
+ * those starting with it first, then by their names.  The array is the
+ * caller's, the items aren't.
+ */
+GPtrArray *
+hd_launcher_search_query (HdLauncherSearch *search, const gchar *text)
+{
+  GPtrArray *found, *rest, *list, *shortest;
+  gchar gram[GRAM_CHARS * 6 + 1];
+  const gchar *start, *end;
+  gboolean verify;
+  gchar *key;
+  guint i, n;
+
+  found = g_ptr_array_new ();
+  rest = g_ptr_array_new ();
+  key = text ? fold (text) : NULL;
+  if (!key || !*key)
+    goto out;
+
+  verify = g_utf8_strlen (key, -1) > GRAM_CHARS;
+  if (!verify)
+    {
+      /* The key is a gram itself, and its list is the answer. */
+      shortest = g_hash_table_lookup (search->grams, key);
+    }
+  else
+    {
+      /* Find the trigram of the key in the fewest entries. */
+      shortest = NULL;
+      for (start = key; ; start = g_utf8_next_char (start))
+        {
+          for (end = start, n = 0; *end && n < GRAM_CHARS; n++)
+            end = g_utf8_next_char (end);
+          if (n < GRAM_CHARS)
+            break;
+
+          memcpy (gram, start, end - start);
+          gram[end - start] = '\0';
+          if (!(list = g_hash_table_lookup (search->grams, gram)))
+            {
+              shortest = NULL;
+              break;
+            }
+          if (!shortest || list->len < shortest->len)
+            shortest = list;
+        }
+    }
+
+  if (!shortest)
+    goto out;
+
+  for (i = 0; i < shortest->len; i++)
+    {
+      Entry *entry = g_ptr_array_index (shortest, i);
+
+      if (entry->removed)
+        continue;
+      if (verify
+          && !(entry->name_key && strstr (entry->name_key, key))
+          && !(entry->exec_key && strstr (entry->exec_key, key)))
+        continue;
+
+      g_ptr_array_add (entry_has_prefix (entry, key) ? found : rest, entry);
+    }
+
+  g_ptr_array_sort (found, entry_cmp);
+  g_ptr_array_sort (rest, entry_cmp);
+  for (i = 0; i < rest->len; i++)
+    g_ptr_array_add (found, g_ptr_array_index (rest, i));
+  for (i = 0; i < found->len; i++)
+    found->pdata[i] = ((Entry *)g_ptr_array_index (found, i))->item;
+
+out:
+  g_ptr_array_free (rest, TRUE);
+  g_free (key);
+  return found;
+}
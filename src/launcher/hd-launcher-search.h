@@ -0,0 +1,67 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * An index of the launcher items by their names and the names of the
+ * programs they run, to look them up as the user types.  Every 1, 2 and
+ * 3 character long substring of the names, casefolded, has the list of
+ * entries it occurs in, so a query of up to 3 characters is a single
+ * lookup, and a longer one only needs to check the entries in the
+ * shortest list of its trigrams.  The results come back sorted, names
+ * starting with the text first.
+ *
+ * Entries are removed lazily and the lists are compacted when they're
+ * mostly dead, so updating the index when a few items change is cheap.
+ *
+ * The items are opaque here, so it can be tested on its own.
+ */
+
+#ifndef __HD_LAUNCHER_SEARCH_H__
+#define __HD_LAUNCHER_SEARCH_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HdLauncherSearch HdLauncherSearch;
+
+HdLauncherSearch *hd_launcher_search_new    (void);
+void              hd_launcher_search_free   (HdLauncherSearch *search);
+
+void              hd_launcher_search_add    (HdLauncherSearch *search,
+                                             gpointer item,
+                                             const gchar *name,
+                                             const gchar *exec);
+void              hd_launcher_search_remove (HdLauncherSearch *search,
+                                             gpointer item);
+void              hd_launcher_search_update (HdLauncherSearch *search,
+                                             gpointer old_item,
+                                             gpointer new_item,
+                                             const gchar *name,
+                                             const gchar *exec);
+guint             hd_launcher_search_size   (HdLauncherSearch *search);
+
+GPtrArray        *hd_launcher_search_query  (HdLauncherSearch *search,
+                                             const gchar *text);
+
+G_END_DECLS
+
+#endif /* __HD_LAUNCHER_SEARCH_H__ */
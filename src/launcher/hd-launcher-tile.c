@@ -66,6 +66,10 @@ struct _HdLauncherTilePrivate
   /* We need to know if there's been scrolling. */
   guint    press_timeout;
   gboolean is_pressed;
+
+  /* Whether @icon, @icon_glow, @label and @glow_timeline exist.
+   * See hd_launcher_tile_load(). */
+  gboolean loaded;
 };
 
 enum
@@ -200,10 +204,6 @@ hd_launcher_tile_init (HdLauncherTile *tile)
                            G_CALLBACK (hd_launcher_tile_button_press), tile);
   g_signal_connect_swapped(priv->click_area, "button-release-event",
                            G_CALLBACK (hd_launcher_tile_button_release), tile);
-
-  tile->priv->glow_timeline = clutter_timeline_new_for_duration(200);
-  g_signal_connect(tile->priv->glow_timeline, "new-frame",
-                   G_CALLBACK (hd_launcher_on_glow_frame), tile);
 }
 
 HdLauncherTile *
@@ -274,9 +274,8 @@ hd_launcher_tile_get_label (HdLauncherTile *tile)
   return priv->label;
 }
 
-void
-hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
-                                const gchar *icon_name)
+static void
+hd_launcher_tile_create_icon (HdLauncherTile *tile)
 {
   HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
   GtkIconTheme *icon_theme;
@@ -284,16 +283,8 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
   GtkIconInfo *info = NULL;
   const gchar *fname;
 
-  if (priv->icon_name)
-    {
-      g_free (priv->icon_name);
-    }
-  if (icon_name)
-    priv->icon_name = g_strdup (icon_name);
-  else
-    /* Set the default if none was passed. */
-    priv->icon_name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
-
+  if (!priv->icon_name)
+    return;
   fname = priv->icon_name;
 
   /* Recreate the icon actor */
@@ -418,12 +409,33 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
 
   clutter_actor_hide(CLUTTER_ACTOR(priv->icon_glow));
 
-  gtk_icon_info_free(info);
+  if (info)
+    gtk_icon_info_free(info);
 }
 
 void
-hd_launcher_tile_set_text (HdLauncherTile *tile,
-                           const gchar *text)
+hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
+                                const gchar *icon_name)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  if (priv->icon_name)
+    {
+      g_free (priv->icon_name);
+    }
+  if (icon_name)
+    priv->icon_name = g_strdup (icon_name);
+  else
+    /* Set the default if none was passed. */
+    priv->icon_name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
+
+  /* Otherwise the icon is looked up when we're loaded. */
+  if (priv->loaded)
+    hd_launcher_tile_create_icon (tile);
+}
+
+static void
+hd_launcher_tile_create_label (HdLauncherTile *tile)
 {
   ClutterColor text_color = {0xFF, 0xFF, 0xFF, 0xFF};
   HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
@@ -431,15 +443,9 @@ hd_launcher_tile_set_text (HdLauncherTile *tile,
   guint label_height, label_width_px;
   gchar *tile_font = NULL;
 
-  if (!text)
+  if (!priv->text)
     return;
 
-  if (priv->text)
-    {
-      g_free (priv->text);
-    }
-  priv->text = g_strdup (text);
-
   /* Recreate the label actor */
   if (priv->label)
     {
@@ -482,6 +488,90 @@ hd_launcher_tile_set_text (HdLauncherTile *tile,
                   HD_LAUNCHER_TILE_WIDTH, label_height);
 }
 
+void
+hd_launcher_tile_set_text (HdLauncherTile *tile,
+                           const gchar *text)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  if (!text)
+    return;
+
+  if (priv->text)
+    {
+      g_free (priv->text);
+    }
+  priv->text = g_strdup (text);
+
+  if (priv->loaded)
+    hd_launcher_tile_create_label (tile);
+}
+
+/*
+ * Creates the actors showing the tile: the icon, its glow and the label.
+ * Until then a tile is just its icon name, text and click area, so
+ * a grid of hundreds of apps only needs textures for the tiles near
+ * the screen.  Does nothing if the tile is loaded already.
+ */
+void
+hd_launcher_tile_load (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  if (priv->loaded)
+    return;
+  priv->loaded = TRUE;
+
+  hd_launcher_tile_create_icon (tile);
+  hd_launcher_tile_create_label (tile);
+
+  priv->glow_timeline = clutter_timeline_new_for_duration(200);
+  g_signal_connect(priv->glow_timeline, "new-frame",
+                   G_CALLBACK (hd_launcher_on_glow_frame), tile);
+}
+
+/* Destroys what hd_launcher_tile_load() created, leaving the tile
+ * as it was before. */
+void
+hd_launcher_tile_unload (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  if (!priv->loaded)
+    return;
+
+  hd_launcher_tile_reset (tile, TRUE);
+  priv->loaded = FALSE;
+
+  if (priv->glow_timeline)
+    {
+      g_object_unref (priv->glow_timeline);
+      priv->glow_timeline = NULL;
+    }
+  if (priv->label)
+    {
+      clutter_actor_destroy (priv->label);
+      priv->label = NULL;
+    }
+  if (priv->icon_glow)
+    {
+      clutter_actor_destroy (CLUTTER_ACTOR (priv->icon_glow));
+      priv->icon_glow = NULL;
+    }
+  if (priv->icon)
+    {
+      clutter_actor_destroy (priv->icon);
+      priv->icon = NULL;
+    }
+  priv->glow_amount = 0;
+}
+
+gboolean
+hd_launcher_tile_is_loaded (HdLauncherTile *tile)
+{
+  return HD_LAUNCHER_TILE_GET_PRIVATE (tile)->loaded;
+}
+
 static void
 hd_launcher_tile_set_property (GObject      *gobject,
                                guint         prop_id,
@@ -535,6 +625,9 @@ hd_launcher_tile_set_glow(HdLauncherTile *tile, gboolean glow, gboolean hard)
   float glow_brightness;
   gint n_frames;
 
+  /* Nothing to glow before we're loaded. */
+  if (!priv->glow_timeline)
+    return;
   clutter_timeline_stop(priv->glow_timeline);
 
   /* If we're already there, skip */
@@ -74,6 +74,10 @@ void hd_launcher_tile_set_text      (HdLauncherTile *tile,
 ClutterActor *hd_launcher_tile_get_icon (HdLauncherTile *tile);
 ClutterActor *hd_launcher_tile_get_label (HdLauncherTile *tile);
 
+void     hd_launcher_tile_load      (HdLauncherTile *tile);
+void     hd_launcher_tile_unload    (HdLauncherTile *tile);
+gboolean hd_launcher_tile_is_loaded (HdLauncherTile *tile);
+
 void hd_launcher_tile_reset(HdLauncherTile *tile, gboolean hard);
 
 void hd_launcher_tile_activate(ClutterActor       *actor);
@@ -4,8 +4,10 @@
 
 #include "hildon-desktop.h"
 #include "hd-launcher-tree.h"
+#include "hd-launcher-search.h"
 
 #include "hd-gtk-style.h"
+#include "hd-task.h"
 
 #include <sys/stat.h>
 #include <unistd.h>
@@ -28,6 +30,9 @@ typedef struct
   /* The items we have created so far. */
   GList *items;
 
+  /* The index of @items, if the tree had none when we started. */
+  HdLauncherSearch *search;
+
   /* accessed by both threads */
   volatile gboolean cancelled : 1;
 } WalkThreadData;
@@ -47,6 +52,9 @@ struct _HdLauncherTreePrivate
 
   WalkThreadData *active_walk;
 
+  /* The applications of @items_list by name. */
+  HdLauncherSearch *search;
+
   gboolean theme_changed_signal_connected : 1;
 };
 
@@ -93,11 +101,66 @@ walk_thread_data_new_level (WalkThreadData *parent, GMenuTreeDirectory *dir)
 static void
 walk_thread_data_free (WalkThreadData *data)
 {
+  if (data->search)
+    hd_launcher_search_free (data->search);
   g_object_unref (data->tree);
 
   g_free (data);
 }
 
+/* Indexes @item in place of @old, which may be NULL. */
+static void
+hd_launcher_tree_index_item (HdLauncherSearch *search,
+                             HdLauncherItem *old, HdLauncherItem *item)
+{
+  if (hd_launcher_item_get_item_type (item) == HD_APPLICATION_LAUNCHER)
+    hd_launcher_search_update (search, old, item,
+                      hd_launcher_item_get_local_name (item),
+                      hd_launcher_app_get_exec (HD_LAUNCHER_APP (item)));
+  else if (old)
+    hd_launcher_search_remove (search, old);
+}
+
+/* Moves the index from @old_items over to @new_items.  Items which
+ * are the same as before are only handed over, not indexed again. */
+static void
+hd_launcher_tree_update_search (HdLauncherSearch *search,
+                                GList *old_items, GList *new_items)
+{
+  GHashTable *old_by_id;
+  GHashTableIter iter;
+  gpointer old;
+  GList *l;
+
+  old_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+  for (l = old_items; l; l = l->next)
+    {
+      const gchar *id = hd_launcher_item_get_id (l->data);
+
+      /* Only one of namesakes can be handed over. */
+      if ((old = g_hash_table_lookup (old_by_id, id)) != NULL)
+        hd_launcher_search_remove (search, old);
+      g_hash_table_insert (old_by_id, (gpointer)id, l->data);
+    }
+
+  for (l = new_items; l; l = l->next)
+    {
+      const gchar *id = hd_launcher_item_get_id (l->data);
+
+      old = g_hash_table_lookup (old_by_id, id);
+      if (old)
+        g_hash_table_remove (old_by_id, id);
+      hd_launcher_tree_index_item (search, old, l->data);
+    }
+
+  /* Those left are gone. */
+  g_hash_table_iter_init (&iter, old_by_id);
+  while (g_hash_table_iter_next (&iter, NULL, &old))
+    hd_launcher_search_remove (search, old);
+
+  g_hash_table_destroy (old_by_id);
+}
+
 /**
  * TODO: When we get here, we have two lists of items, the old one
  * and the new one.
@@ -106,15 +169,25 @@ walk_thread_data_free (WalkThreadData *data)
  * old items contain run-time information we can't discard.
  * We also send signals for new and removed items.
  */
-static gboolean
-walk_thread_done_idle (gpointer user_data)
+static void
+walk_thread_done (gpointer user_data)
 {
   WalkThreadData *data = user_data;
   HdLauncherTreePrivate *priv = HD_LAUNCHER_TREE_GET_PRIVATE (data->tree);
 
   if ((priv->active_walk == data) && !data->cancelled)
     {
-      /* This is the correct walking. */
+      /* This is the correct walking.  Build the index the first time,
+       * and update it afterwards, while the old items are still there. */
+      if (!priv->search)
+        {
+          priv->search = data->search;
+          data->search = NULL;
+        }
+      else
+        hd_launcher_tree_update_search (priv->search,
+                                        priv->items_list, data->items);
+
       g_list_foreach (priv->items_list, (GFunc) g_object_unref, NULL);
       g_list_free (priv->items_list);
       priv->items_list = data->items;
@@ -133,8 +206,6 @@ walk_thread_done_idle (gpointer user_data)
         }
 
       walk_thread_data_free (data);
-
-      hd_mutex_enable (FALSE);
     }
   else
     {
@@ -143,15 +214,14 @@ walk_thread_done_idle (gpointer user_data)
       gmenu_tree_item_unref (data->root);
       walk_thread_data_free (data);
     }
-
-  return FALSE;
 }
 
 /**
- * This function, in a separate thread, builds up a list of items
- * reading their .desktop files.
+ * This function, in a worker thread, builds up a list of items
+ * reading their .desktop files.  walk_thread_done() is called with
+ * the result in the main loop.
  */
-static gpointer
+static void
 walk_thread_func (gpointer user_data)
 {
   WalkThreadData *data = user_data;
@@ -198,7 +268,7 @@ walk_thread_func (gpointer user_data)
           /* Iterate. */
           WalkThreadData *subdata = walk_thread_data_new_level (data, entry_dir);
           subdata->root = entry_dir;
-          walk_thread_func ((gpointer)subdata);
+          walk_thread_func (subdata);
           data->items = g_list_concat (data->items, subdata->items);
           walk_thread_data_free (subdata);
           gmenu_tree_item_unref (entry_dir);
@@ -246,12 +316,13 @@ walk_thread_func (gpointer user_data)
 
   if (data->level == 0)
     {
-      data->items = g_list_reverse (data->items);
+      GList *l;
 
-      clutter_threads_add_idle (walk_thread_done_idle, data);
+      data->items = g_list_reverse (data->items);
+      if (data->search)
+        for (l = data->items; l; l = l->next)
+          hd_launcher_tree_index_item (data->search, NULL, l->data);
     }
-
-  return NULL;
 }
 
 static void
@@ -266,6 +337,12 @@ hd_launcher_tree_finalize (GObject *gobject)
       priv->active_walk = NULL;
     }
 
+  if (priv->search)
+    {
+      hd_launcher_search_free (priv->search);
+      priv->search = NULL;
+    }
+
   g_list_foreach (priv->items_list, (GFunc) g_object_unref, NULL);
   g_list_free (priv->items_list);
   priv->items_list = NULL;
@@ -367,15 +444,12 @@ hd_launcher_tree_handle_tree_changed (GMenuTree *menu_tree,
 
   data = walk_thread_data_new (self);
   data->root = root;
+  if (!priv->search)
+    /* Index the items in the thread as well. */
+    data->search = hd_launcher_search_new ();
 
   priv->active_walk = data;
-  if (hd_disable_threads ())
-    walk_thread_func (data);
-  else
-    {
-      hd_mutex_enable (TRUE);
-      g_thread_new (NULL, walk_thread_func, data);
-    }
+  hd_task_submit (walk_thread_func, walk_thread_done, data);
 }
 
 /* When there's a theme change, tell clients to completely rebuild the
@@ -397,7 +471,7 @@ hd_launcher_tree_handle_theme_changed (HdLauncherTree *tree)
  * @tree: a #HdLauncherTree
  *
  * Populates the @tree with the launchers by walking
- * the applications directory using an helper thread
+ * the applications directory in a worker thread
  * to avoid blocking.
  *
  * Emits the #HdLauncherTree::finished
@@ -459,6 +533,26 @@ hd_launcher_tree_get_size (HdLauncherTree *tree)
   return g_list_length (tree->priv->items_list);
 }
 
+/**
+ * hd_launcher_tree_search:
+ * @tree: a #HdLauncherTree
+ * @text: what the user typed
+ *
+ * Finds the applications whose name or program contains @text,
+ * ignoring case, those starting with it first.  Free the array with
+ * g_ptr_array_free(); the items in it belong to @tree
+ * and go away when it's #HdLauncherTree::finished again.
+ */
+GPtrArray *
+hd_launcher_tree_search (HdLauncherTree *tree, const gchar *text)
+{
+  g_return_val_if_fail (HD_IS_LAUNCHER_TREE (tree), NULL);
+
+  if (!tree->priv->search)
+    return g_ptr_array_new ();
+  return hd_launcher_search_query (tree->priv->search, text);
+}
+
 static gint
 _compare_item_id (gconstpointer a, gconstpointer b)
 {
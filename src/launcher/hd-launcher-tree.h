@@ -71,6 +71,8 @@ HdLauncherItem *hd_launcher_tree_find_item   (HdLauncherTree *tree,
 HdLauncherApp  *hd_launcher_tree_find_app_by_service (
                                               HdLauncherTree *tree,
                                               const gchar *service);
+GPtrArray      *hd_launcher_tree_search      (HdLauncherTree *tree,
+                                              const gchar *text);
 
 /* Utility functions. */
 void hd_launcher_tree_ensure_user_menu (void);
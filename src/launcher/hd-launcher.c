@@ -52,6 +52,7 @@
 #include "hd-title-bar.h"
 #include "hd-transition.h"
 #include "hd-util.h"
+#include "hd-scheduler.h"
 #include "tidy/tidy-sub-texture.h"
 
 #include <hildon/hildon-banner.h>
@@ -69,6 +70,11 @@
 
 #define GCONF_KEY_DISABLE_MENU_EDIT "/apps/osso/hildon-desktop/menu_edit_disabled"
 
+/* The page of what's found by typing.  It has this many tiles at most,
+ * so a keystroke fits in a frame however much it finds. */
+#define HD_LAUNCHER_SEARCH_PAGE       "hd-launcher-search"
+#define HD_LAUNCHER_SEARCH_MAX_TILES  60
+
 typedef struct
 {
   GList *items;
@@ -98,6 +104,11 @@ struct _HdLauncherPrivate
 
   gboolean portraited;
   gboolean is_editor_in_landscape;
+
+  /* What's been typed to search, and the refresh of the search page
+   * waiting for the next frame. */
+  GString *search_text;
+  guint search_pending;
 };
 
 #define HD_LAUNCHER_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
@@ -142,6 +153,7 @@ static void hd_launcher_populate_tree_starting (HdLauncherTree *tree,
 static void hd_launcher_populate_tree_finished (HdLauncherTree *tree,
                                                 gpointer data);
 static void hd_launcher_lazy_traverse_cleanup  (gpointer data);
+static void hd_launcher_type_search_reset (HdLauncherPrivate *priv);
 static void hd_launcher_transition_new_frame(ClutterTimeline *timeline,
                                              gint frame_num, gpointer data);
 
@@ -215,6 +227,7 @@ hd_launcher_init (HdLauncher *self)
 
   self->priv = priv = HD_LAUNCHER_GET_PRIVATE (self);
   priv->gconf_client = gconf_client_get_default ();
+  priv->search_text = g_string_new ("");
   g_datalist_init (&priv->pages);
 }
 
@@ -275,6 +288,13 @@ hd_launcher_dispose (GObject *gobject)
       priv->gconf_client = NULL;
     }
 
+  if (priv->search_text)
+    {
+      hd_launcher_type_search_reset (priv);
+      g_string_free (priv->search_text, TRUE);
+      priv->search_text = NULL;
+    }
+
   g_datalist_clear (&priv->pages);
 
   G_OBJECT_CLASS (hd_launcher_parent_class)->dispose (gobject);
@@ -396,6 +416,7 @@ hd_launcher_hide (void)
 {
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
 
+  hd_launcher_type_search_reset (priv);
   if (priv->active_page)
     {
       ClutterActor *top_page = g_datalist_get_data (&priv->pages,
@@ -436,6 +457,7 @@ hd_launcher_back_button_clicked ()
   if (!STATE_IS_LAUNCHER (hd_render_manager_get_state()))
     return FALSE;
 
+  hd_launcher_type_search_reset (priv);
   if (priv->active_page == top_page)
     g_signal_emit (hd_launcher_get (), launcher_signals[HIDDEN], 0);
   else
@@ -678,6 +700,7 @@ hd_launcher_populate_tree_starting (HdLauncherTree *tree, gpointer data)
     }
 
   priv->active_page = NULL;
+  hd_launcher_type_search_reset (priv);
 
   if (priv->current_traversal)
     {
@@ -837,6 +860,7 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
   HdLauncher *launcher = HD_LAUNCHER (data);
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (launcher);
   HdLauncherTraverseData *tdata = g_new0 (HdLauncherTraverseData, 1);
+  ClutterActor *search_page;
 
   /* As we'll be adding these in an idle loop, we need to ensure that they
    * won't disappear while we do this, so we copy the list and ref all the
@@ -871,13 +895,22 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
   priv->active_page = NULL;
   g_datalist_set_data_full (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY, top_page, (GDestroyNotify) clutter_actor_destroy);
 
+  /* The search page is filled as the user types. */
+  hd_launcher_type_search_reset (priv);
+  search_page = hd_launcher_page_new ();
+  clutter_container_add_actor (CLUTTER_CONTAINER (launcher), search_page);
+  clutter_actor_hide (search_page);
+  g_datalist_set_data_full (&priv->pages, HD_LAUNCHER_SEARCH_PAGE,
+                            search_page,
+                            (GDestroyNotify) clutter_actor_destroy);
+
   g_list_foreach (tdata->items, (GFunc) hd_launcher_create_page, NULL);
 
-  /* Then we add the tiles to them in a idle callback. */
-  clutter_threads_add_idle_full (CLUTTER_PRIORITY_REDRAW + 20,
-                                 hd_launcher_lazy_traverse_tree,
-                                 tdata,
-                                 hd_launcher_lazy_traverse_cleanup);
+  /* Then we add the tiles to them between frames. */
+  hd_scheduler_add (HD_SCHEDULE_BACKGROUND, "launcher_traverse",
+                    hd_launcher_lazy_traverse_tree,
+                    tdata,
+                    hd_launcher_lazy_traverse_cleanup);
 }
 
 /* handle clicks to the fake launch image. If we've been up this long the
@@ -1301,6 +1334,146 @@ hd_launcher_activate (int p)
   hd_launcher_page_activate(priv->active_page, p);
 }
 
+/*
+ * Type-to-search
+ */
+
+static void
+hd_launcher_type_search_reset (HdLauncherPrivate *priv)
+{
+  g_string_truncate (priv->search_text, 0);
+  if (priv->search_pending)
+    {
+      hd_scheduler_remove (priv->search_pending);
+      priv->search_pending = 0;
+    }
+}
+
+/* Fills the search page with the tiles of what's found for the text
+ * typed so far and brings it up, or leaves it if nothing's typed. */
+static gboolean
+hd_launcher_type_search_refresh (gpointer unused)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  ClutterActor *page, *top_page;
+  HdLauncherGrid *grid;
+  GPtrArray *found;
+  guint i;
+
+  priv->search_pending = 0;
+  if (!STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
+    return FALSE;
+
+  page = g_datalist_get_data (&priv->pages, HD_LAUNCHER_SEARCH_PAGE);
+  top_page = g_datalist_get_data (&priv->pages,
+                                  HD_LAUNCHER_ITEM_TOP_CATEGORY);
+  if (!page || !top_page)
+    return FALSE;
+
+  if (!priv->search_text->len)
+    {
+      if (priv->active_page == page)
+        hd_launcher_back_button_clicked ();
+      return FALSE;
+    }
+
+  grid = HD_LAUNCHER_GRID (hd_launcher_page_get_grid (HD_LAUNCHER_PAGE (page)));
+  hd_launcher_grid_clear (grid);
+
+  found = hd_launcher_tree_search (priv->tree, priv->search_text->str);
+  for (i = 0; i < found->len && i < HD_LAUNCHER_SEARCH_MAX_TILES; i++)
+    {
+      HdLauncherItem *item = g_ptr_array_index (found, i);
+      HdLauncherTile *tile;
+
+      tile = hd_launcher_tile_new (hd_launcher_item_get_icon_name (item),
+                                   hd_launcher_item_get_local_name (item));
+      hd_launcher_page_add_tile (HD_LAUNCHER_PAGE (page), tile);
+      g_signal_connect (tile, "clicked",
+                        G_CALLBACK (hd_launcher_application_tile_clicked),
+                        item);
+      g_signal_connect (tile, "long-clicked",
+                        G_CALLBACK (hd_launcher_application_tile_long_clicked),
+                        item);
+    }
+  g_ptr_array_free (found, TRUE);
+
+  /* Only the tiles near the top are loaded. */
+  hd_launcher_grid_set_portrait (grid, priv->portraited);
+  hd_launcher_grid_reset_v_adjustment (grid);
+  hd_launcher_grid_layout (grid);
+
+  if (priv->active_page != page)
+    {
+      /* Like going into a category; from one, leave it for the search. */
+      if (priv->active_page == top_page)
+        hd_launcher_page_transition (HD_LAUNCHER_PAGE (top_page),
+                                     HD_LAUNCHER_PAGE_TRANSITION_BACK);
+      else if (priv->active_page)
+        hd_launcher_page_transition (HD_LAUNCHER_PAGE (priv->active_page),
+                                     HD_LAUNCHER_PAGE_TRANSITION_OUT_SUB);
+      hd_launcher_page_transition (HD_LAUNCHER_PAGE (page),
+                                   HD_LAUNCHER_PAGE_TRANSITION_IN_SUB);
+      priv->active_page = page;
+      g_signal_emit (hd_launcher_get (), launcher_signals[CAT_LAUNCHED],
+                     0, NULL);
+    }
+
+  return FALSE;
+}
+
+static void
+hd_launcher_type_search_schedule (HdLauncherPrivate *priv)
+{
+  /* However fast the user types, search once a frame. */
+  priv->search_pending = hd_scheduler_add (HD_SCHEDULE_PRE_PAINT,
+                                           "launcher_search",
+                                           hd_launcher_type_search_refresh,
+                                           NULL, NULL);
+}
+
+/* Adds @text to what's searched for in the launcher. */
+void
+hd_launcher_type_search_append (const gchar *text)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+
+  if (!STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
+    return;
+
+  /* Nothing is found by leading spaces. */
+  if (!priv->search_text->len && g_unichar_isspace (g_utf8_get_char (text)))
+    return;
+
+  g_string_append (priv->search_text, text);
+  hd_launcher_type_search_schedule (priv);
+}
+
+/* Takes back the last character typed, or goes up a level
+ * if nothing is typed. */
+void
+hd_launcher_type_search_backspace (void)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  gchar *last;
+
+  if (!STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
+    return;
+
+  if (!priv->search_text->len)
+    {
+      hd_launcher_back_button_clicked ();
+      return;
+    }
+
+  last = g_utf8_find_prev_char (priv->search_text->str,
+                                priv->search_text->str
+                                + priv->search_text->len);
+  g_string_truncate (priv->search_text,
+                     last ? last - priv->search_text->str : 0);
+  hd_launcher_type_search_schedule (priv);
+}
+
 gboolean
 hd_launcher_is_editor_in_landscape (void)
 {
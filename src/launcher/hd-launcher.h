@@ -92,6 +92,10 @@ gboolean hd_launcher_transition_app_start (HdLauncherApp *item);
 void hd_launcher_stop_loading_transition (void);
 
 void hd_launcher_activate(int p);
+
+/* Type-to-search, with what the user types in the launcher. */
+void hd_launcher_type_search_append (const gchar *text);
+void hd_launcher_type_search_backspace (void);
 void hd_launcher_update_orientation (gboolean portraited);
 
 gboolean hd_launcher_is_editor_in_landscape (void);
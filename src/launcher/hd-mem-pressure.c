@@ -0,0 +1,403 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-mem-pressure.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "hd-mem-pressure"
+
+#define PSI_MEMORY_FILE        "/proc/pressure/memory"
+/* Wake us up when tasks stall for 150ms in a 2s window.  Unprivileged
+ * processes may only use windows which are multiples of 2s. */
+#define PSI_TRIGGER            "some 150000 2000000"
+#define PSI_TRIGGER_PERCENT    (7.5)
+
+#define LOWMEM_PROC_FREE       "/proc/sys/vm/lowmem_free_pages"
+#define NSIZE                  ((size_t)(-1))
+
+/* While there is pressure, resample this often to notice when it's gone,
+ * PSI only tells us about stalls and nobody tells us about lowmem. */
+#define RESAMPLE_INTERVAL      (2)
+
+/* Exponential smoothing of the samples and hysteresis when going down
+ * a level, so we don't flap between prestarting and killing. */
+#define SMOOTHING_ALPHA        (0.5)
+#define HYSTERESIS             (0.7)
+
+#define TRACE_SIZE             256
+
+/* Percentages of stalled time at which each level is entered. */
+static const gdouble default_thresholds[HD_MEM_PRESSURE_NUM_LEVELS] =
+  { 0.0, 5.0, 15.0, 40.0 };
+
+typedef struct
+{
+  gint64  time;   /* Monotonic, in microseconds. */
+  gfloat  raw;
+  guint8  level;
+} HdMemPressureSample;
+
+struct _HdMemPressure
+{
+  /* Either the PSI trigger or the lowmem fallback. */
+  int         psi_fd;
+  GIOChannel *psi_channel;
+  guint       psi_watch;
+  int         lowmem_fd;
+
+  size_t prestart_required_pages;
+  size_t launch_required_pages;
+  size_t notify_low_pages;
+
+  gdouble            smoothed;
+  HdMemPressureLevel level;
+  guint              resample_id;
+
+  HdMemPressureFunc func;
+  gpointer          data;
+
+  HdMemPressureSample trace[TRACE_SIZE];
+  guint               trace_next;
+  gboolean            trace_full;
+};
+
+static gint64
+hd_mem_pressure_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+/* Reads a small proc file through an already open descriptor. */
+static gssize
+hd_mem_pressure_pread (int fd, gchar *buf, gsize size)
+{
+  gssize len;
+
+  do
+    len = pread (fd, buf, size - 1, 0);
+  while (len < 0 && errno == EINTR);
+
+  buf[len > 0 ? len : 0] = '\0';
+  return len;
+}
+
+static HdMemPressureLevel
+hd_mem_pressure_classify (gdouble smoothed,
+                          HdMemPressureLevel current,
+                          const gdouble *thresholds)
+{
+  HdMemPressureLevel level = HD_MEM_PRESSURE_NONE;
+
+  for (gint i = HD_MEM_PRESSURE_NUM_LEVELS - 1; i > HD_MEM_PRESSURE_NONE; i--)
+    if (smoothed >= thresholds[i])
+      {
+        level = i;
+        break;
+      }
+
+  /* Only go down if we're well below the current level's threshold,
+   * and then all the way down to where nothing is done about it: the
+   * pressure is going away, it's no time to start hibernating. */
+  if (level < current)
+    {
+      if (smoothed >= thresholds[current] * HYSTERESIS)
+        level = current;
+      else
+        level = MIN (level, HD_MEM_PRESSURE_LOW);
+    }
+
+  return level;
+}
+
+/* Returns the percentage of time tasks were stalled on memory. */
+static gdouble
+hd_mem_pressure_read_psi (HdMemPressure *pressure)
+{
+  gchar buf[256];
+  const gchar *p;
+  gdouble some = 0, full = 0;
+
+  if (hd_mem_pressure_pread (pressure->psi_fd, buf, sizeof (buf)) <= 0)
+    return 0;
+
+  if ((p = strstr (buf, "some avg10=")) != NULL)
+    some = g_ascii_strtod (p + strlen ("some avg10="), NULL);
+  if ((p = strstr (buf, "full avg10=")) != NULL)
+    full = g_ascii_strtod (p + strlen ("full avg10="), NULL);
+
+  /* When everyone is stalled it's much worse than when someone is. */
+  return MAX (some, 2 * full);
+}
+
+/* Maps the free lowmem pages to the same scale as PSI. */
+static gdouble
+hd_mem_pressure_read_lowmem (HdMemPressure *pressure)
+{
+  gchar buf[32];
+  size_t free_pages;
+
+  if (hd_mem_pressure_pread (pressure->lowmem_fd, buf, sizeof (buf)) <= 0)
+    return 0;
+  free_pages = (size_t)strtol (buf, NULL, 10);
+
+  /* However short we are, that only stops prestarting, killing and
+   * hibernating is up to the kernel's lowmem signals. */
+  if ((pressure->notify_low_pages != NSIZE
+       && free_pages < pressure->notify_low_pages)
+      || (pressure->launch_required_pages != NSIZE
+          && free_pages < pressure->launch_required_pages)
+      || (pressure->prestart_required_pages != NSIZE
+          && free_pages < pressure->prestart_required_pages))
+    return default_thresholds[HD_MEM_PRESSURE_LOW];
+  return 0;
+}
+
+/* Reads whichever source we have. */
+static gdouble
+hd_mem_pressure_read (HdMemPressure *pressure)
+{
+  if (pressure->psi_fd >= 0)
+    return hd_mem_pressure_read_psi (pressure);
+  if (pressure->lowmem_fd >= 0)
+    return hd_mem_pressure_read_lowmem (pressure);
+  return 0;
+}
+
+static gboolean hd_mem_pressure_resample (HdMemPressure *pressure);
+
+static void
+hd_mem_pressure_update (HdMemPressure *pressure, gdouble raw)
+{
+  HdMemPressureSample *sample;
+  HdMemPressureLevel old_level = pressure->level;
+
+  /* Rising pressure is taken at face value, only the way down is
+   * smoothed. */
+  if (raw > pressure->smoothed)
+    pressure->smoothed = raw;
+  else
+    pressure->smoothed += SMOOTHING_ALPHA * (raw - pressure->smoothed);
+
+  pressure->level = hd_mem_pressure_classify (pressure->smoothed,
+                                              pressure->level,
+                                              default_thresholds);
+
+  sample = &pressure->trace[pressure->trace_next];
+  sample->time = hd_mem_pressure_now ();
+  sample->raw = raw;
+  sample->level = pressure->level;
+  if (++pressure->trace_next == TRACE_SIZE)
+    {
+      pressure->trace_next = 0;
+      pressure->trace_full = TRUE;
+    }
+
+  /* Nobody will tell us when the pressure is over. */
+  if (pressure->level != HD_MEM_PRESSURE_NONE && !pressure->resample_id)
+    pressure->resample_id = g_timeout_add_seconds (RESAMPLE_INTERVAL,
+                              (GSourceFunc)hd_mem_pressure_resample,
+                              pressure);
+
+  if (pressure->level != old_level)
+    {
+      g_debug ("%s: level %d -> %d (%.1f%%)", __FUNCTION__,
+               old_level, pressure->level, pressure->smoothed);
+      if (pressure->func)
+        pressure->func (pressure->level, pressure->data);
+    }
+}
+
+static gboolean
+hd_mem_pressure_resample (HdMemPressure *pressure)
+{
+  pressure->resample_id = 0;
+  hd_mem_pressure_update (pressure, hd_mem_pressure_read (pressure));
+
+  /* hd_mem_pressure_update() has added a new timeout if needed. */
+  return FALSE;
+}
+
+static gboolean
+hd_mem_pressure_psi_event (GIOChannel *source,
+                           GIOCondition condition,
+                           HdMemPressure *pressure)
+{
+  if (condition & G_IO_ERR)
+    {
+      g_warning ("%s: PSI trigger went away", __FUNCTION__);
+      pressure->psi_watch = 0;
+      return FALSE;
+    }
+
+  /* The trigger itself means at least this much stalling. */
+  hd_mem_pressure_update (pressure,
+                          MAX (hd_mem_pressure_read_psi (pressure),
+                               PSI_TRIGGER_PERCENT));
+  return TRUE;
+}
+
+static gboolean
+hd_mem_pressure_setup_psi (HdMemPressure *pressure)
+{
+  int fd;
+
+  fd = open (PSI_MEMORY_FILE, O_RDWR | O_NONBLOCK);
+  if (fd < 0)
+    return FALSE;
+
+  if (write (fd, PSI_TRIGGER, strlen (PSI_TRIGGER) + 1) < 0)
+    {
+      g_debug ("%s: couldn't set PSI trigger: %s", __FUNCTION__,
+               strerror (errno));
+      close (fd);
+      return FALSE;
+    }
+
+  pressure->psi_fd = fd;
+  pressure->psi_channel = g_io_channel_unix_new (fd);
+  pressure->psi_watch = g_io_add_watch (pressure->psi_channel,
+                                        G_IO_PRI | G_IO_ERR,
+                                        (GIOFunc)hd_mem_pressure_psi_event,
+                                        pressure);
+  return TRUE;
+}
+
+HdMemPressure *
+hd_mem_pressure_new (size_t prestart_required_pages,
+                     size_t launch_required_pages,
+                     size_t notify_low_pages,
+                     HdMemPressureFunc func,
+                     gpointer data)
+{
+  HdMemPressure *pressure = g_new0 (HdMemPressure, 1);
+
+  pressure->psi_fd = pressure->lowmem_fd = -1;
+  pressure->prestart_required_pages = prestart_required_pages;
+  pressure->launch_required_pages = launch_required_pages;
+  pressure->notify_low_pages = notify_low_pages;
+  pressure->func = func;
+  pressure->data = data;
+
+  if (hd_mem_pressure_setup_psi (pressure))
+    g_debug ("%s: using PSI triggers", __FUNCTION__);
+  else if ((pressure->lowmem_fd = open (LOWMEM_PROC_FREE, O_RDONLY)) >= 0)
+    g_debug ("%s: using %s", __FUNCTION__, LOWMEM_PROC_FREE);
+  else
+    g_debug ("%s: no memory limits", __FUNCTION__);
+
+  return pressure;
+}
+
+void
+hd_mem_pressure_free (HdMemPressure *pressure)
+{
+  if (!pressure)
+    return;
+
+  if (pressure->resample_id)
+    g_source_remove (pressure->resample_id);
+  if (pressure->psi_watch)
+    g_source_remove (pressure->psi_watch);
+  if (pressure->psi_channel)
+    g_io_channel_unref (pressure->psi_channel);
+  if (pressure->psi_fd >= 0)
+    close (pressure->psi_fd);
+  if (pressure->lowmem_fd >= 0)
+    close (pressure->lowmem_fd);
+  g_free (pressure);
+}
+
+gboolean
+hd_mem_pressure_is_event_driven (HdMemPressure *pressure)
+{
+  return pressure && pressure->psi_fd >= 0;
+}
+
+HdMemPressureLevel
+hd_mem_pressure_get_level (HdMemPressure *pressure)
+{
+  return pressure ? pressure->level : HD_MEM_PRESSURE_NONE;
+}
+
+/* Returns the current level, reading the lowmem pages first if that's
+ * what we rely on.  With PSI the level is always up to date. */
+HdMemPressureLevel
+hd_mem_pressure_sample (HdMemPressure *pressure)
+{
+  if (!pressure)
+    return HD_MEM_PRESSURE_NONE;
+
+  if (pressure->lowmem_fd >= 0)
+    hd_mem_pressure_update (pressure, hd_mem_pressure_read_lowmem (pressure));
+
+  return pressure->level;
+}
+
+gboolean
+hd_mem_pressure_save_trace (HdMemPressure *pressure, const gchar *filename)
+{
+  GString *str;
+  GError *error = NULL;
+  guint i, n, first;
+  gboolean ret;
+
+  if (!pressure)
+    return FALSE;
+
+  n = pressure->trace_full ? TRACE_SIZE : pressure->trace_next;
+  first = pressure->trace_full ? pressure->trace_next : 0;
+
+  str = g_string_new ("# time(us) raw(%) level\n");
+  for (i = 0; i < n; i++)
+    {
+      const HdMemPressureSample *s = &pressure->trace[(first + i) % TRACE_SIZE];
+      gchar raw[G_ASCII_DTOSTR_BUF_SIZE];
+
+      g_string_append_printf (str, "%lld %s %u\n", (long long)s->time,
+                              g_ascii_dtostr (raw, sizeof (raw), s->raw),
+                              s->level);
+    }
+
+  ret = g_file_set_contents (filename, str->str, str->len, &error);
+  if (!ret)
+    {
+      g_warning ("%s: %s", __FUNCTION__, error->message);
+      g_error_free (error);
+    }
+
+  g_string_free (str, TRUE);
+  return ret;
+}
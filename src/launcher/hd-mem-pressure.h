@@ -0,0 +1,73 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * HdMemPressure watches the memory pressure of the system and reduces it
+ * to a few levels HdAppMgr acts on.  When the kernel supports PSI
+ * triggers (/proc/pressure/memory) it is entirely event driven, otherwise
+ * it samples the lowmem free pages through a cached file descriptor
+ * whenever it is asked to.  Either way it resamples by itself while
+ * there is pressure, to notice when it's gone.  On the way down the
+ * level drops to LOW or NONE right away, never to one which acts.
+ */
+
+#ifndef __HD_MEM_PRESSURE_H__
+#define __HD_MEM_PRESSURE_H__
+
+#include <glib.h>
+#include <sys/types.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  HD_MEM_PRESSURE_NONE = 0,
+  HD_MEM_PRESSURE_LOW,        /* Don't prestart. */
+  HD_MEM_PRESSURE_MEDIUM,     /* Hibernate background apps. */
+  HD_MEM_PRESSURE_CRITICAL,   /* Kill prestarted apps. */
+
+  HD_MEM_PRESSURE_NUM_LEVELS
+} HdMemPressureLevel;
+
+typedef struct _HdMemPressure HdMemPressure;
+
+typedef void (*HdMemPressureFunc) (HdMemPressureLevel level, gpointer data);
+
+/* The page limits are only used when falling back to the lowmem files,
+ * (size_t)-1 means unknown. */
+HdMemPressure *hd_mem_pressure_new  (size_t prestart_required_pages,
+                                     size_t launch_required_pages,
+                                     size_t notify_low_pages,
+                                     HdMemPressureFunc func,
+                                     gpointer data);
+void           hd_mem_pressure_free (HdMemPressure *pressure);
+
+gboolean           hd_mem_pressure_is_event_driven (HdMemPressure *pressure);
+HdMemPressureLevel hd_mem_pressure_get_level       (HdMemPressure *pressure);
+HdMemPressureLevel hd_mem_pressure_sample          (HdMemPressure *pressure);
+
+/* The last samples are kept in a ring buffer, which can be written out. */
+gboolean hd_mem_pressure_save_trace (HdMemPressure *pressure,
+                                     const gchar *filename);
+
+G_END_DECLS
+
+#endif /* __HD_MEM_PRESSURE_H__ */
@@ -40,6 +40,9 @@ struct _HdRunningAppPrivate
   HdRunningAppState state;
   GPid pid;
   time_t last_launch;
+  gsize pss;
+  time_t pss_time;
+  gdouble launch_cost;
 };
 
 G_DEFINE_TYPE (HdRunningApp, hd_running_app, G_TYPE_OBJECT);
@@ -127,6 +130,9 @@ void
 hd_running_app_set_pid (HdRunningApp *app, GPid pid)
 {
   HdRunningAppPrivate *priv = HD_RUNNING_APP_GET_PRIVATE (app);
+  if (priv->pid != pid)
+    /* The old measurement was for another process. */
+    priv->pss = priv->pss_time = 0;
   priv->pid = pid;
 }
 
@@ -144,6 +150,42 @@ hd_running_app_set_last_launch (HdRunningApp *app, time_t time)
   priv->last_launch = time;
 }
 
+gsize
+hd_running_app_get_pss (HdRunningApp *app)
+{
+  HdRunningAppPrivate *priv = HD_RUNNING_APP_GET_PRIVATE (app);
+  return priv->pss;
+}
+
+time_t
+hd_running_app_get_pss_time (HdRunningApp *app)
+{
+  HdRunningAppPrivate *priv = HD_RUNNING_APP_GET_PRIVATE (app);
+  return priv->pss_time;
+}
+
+void
+hd_running_app_set_pss (HdRunningApp *app, gsize pss, time_t time)
+{
+  HdRunningAppPrivate *priv = HD_RUNNING_APP_GET_PRIVATE (app);
+  priv->pss = pss;
+  priv->pss_time = time;
+}
+
+gdouble
+hd_running_app_get_launch_cost (HdRunningApp *app)
+{
+  HdRunningAppPrivate *priv = HD_RUNNING_APP_GET_PRIVATE (app);
+  return priv->launch_cost;
+}
+
+void
+hd_running_app_set_launch_cost (HdRunningApp *app, gdouble cost)
+{
+  HdRunningAppPrivate *priv = HD_RUNNING_APP_GET_PRIVATE (app);
+  priv->launch_cost = cost;
+}
+
 HdLauncherApp  *
 hd_running_app_get_launcher_app  (HdRunningApp *app)
 {
@@ -86,6 +86,16 @@ void hd_running_app_set_pid (HdRunningApp *app, GPid pid);
 time_t hd_running_app_get_last_launch (HdRunningApp *app);
 void   hd_running_app_set_last_launch (HdRunningApp *app, time_t time);
 
+/* Memory accounting, the proportional set size in kB and when it was
+ * measured (0 if never). */
+gsize  hd_running_app_get_pss      (HdRunningApp *app);
+time_t hd_running_app_get_pss_time (HdRunningApp *app);
+void   hd_running_app_set_pss      (HdRunningApp *app, gsize pss, time_t time);
+/* How long it took the app to appear the last time it was launched or
+ * woken up, in seconds. */
+gdouble hd_running_app_get_launch_cost (HdRunningApp *app);
+void    hd_running_app_set_launch_cost (HdRunningApp *app, gdouble cost);
+
 /* Some convenience functions. */
 const gchar *hd_running_app_get_service (HdRunningApp *app);
 const gchar *hd_running_app_get_id      (HdRunningApp *app);
@@ -49,6 +49,8 @@
 #include "hd-util.h"
 #include "hd-dbus.h"
 #include "hd-volume-profile.h"
+#include "hd-trace.h"
+#include "hd-screenshot.h"
 #include "launcher/hd-app-mgr.h"
 #include "home/hd-render-manager.h"
 #include "hd-transition.h"
@@ -78,50 +80,33 @@ asm(".previous");
 
 gboolean hd_debug_mode_set = FALSE;
 MBWindowManager *hd_mb_wm = NULL;
-static int hd_clutter_mutex_enabled = FALSE;
-static int hd_clutter_mutex_do_unlock_after_disabling = FALSE;
-static GMutex hd_clutter_mutex;
-
-void hd_mutex_enable (int setting)
-{
-  /*g_printerr ("%s, setting %d\n", __func__, setting);*/
-  if (hd_clutter_mutex_enabled && !setting)
-    /* deactivating mutex, make sure the mutex is unlocked if
-     * hd_mutex_unlock is called later */
-    hd_clutter_mutex_do_unlock_after_disabling = TRUE;
-
-  hd_clutter_mutex_enabled = setting;
-}
 
+/* Clutter is only used in the main thread (background work is done with
+ * hd_task_submit(), which calls back in the main loop), so it needn't
+ * be locked at all. */
 static void
-hd_mutex_lock (void)
+hd_mutex_nop (void)
 {
-  /*g_printerr ("%s, enabled %d\n", __func__, hd_clutter_mutex_enabled);*/
-  if (hd_clutter_mutex_enabled)
-    g_mutex_lock (&hd_clutter_mutex);
 }
 
 static void
-hd_mutex_unlock (void)
+hd_mutex_init (void)
 {
-  /*g_printerr ("%s, enabled %d\n", __func__, hd_clutter_mutex_enabled);*/
-  if (hd_clutter_mutex_enabled)
-    g_mutex_unlock (&hd_clutter_mutex);
-  else if (hd_clutter_mutex_do_unlock_after_disabling)
-    {
-      g_mutex_unlock (&hd_clutter_mutex);
-      hd_clutter_mutex_do_unlock_after_disabling = FALSE;
-    }
+  clutter_threads_set_lock_functions (hd_mutex_nop, hd_mutex_nop);
 }
 
+static gboolean screenshot_in_flight;
+
 static void
-hd_mutex_init (void)
+screenshot_saved (const gchar *filename, gboolean saved, gpointer unused)
 {
-  /* g_printerr ("%s%d\n", __func__); */
-  clutter_threads_set_lock_functions (hd_mutex_lock, hd_mutex_unlock);
+  screenshot_in_flight = FALSE;
+  if (saved)
+    g_debug ("Screenshot '%s' saved.", filename);
 }
 
-/* Take screenshot */
+/* Take screenshot.  Only grabbing the screen is done here, it's saved
+ * in the background. */
 static void
 take_screenshot (void)
 {
@@ -133,13 +118,12 @@ take_screenshot (void)
   GdkDrawable *window;
   int width, height;
   GdkPixbuf *image;
-  GError *error = NULL;
-  gboolean ret;
   GConfClient *client;
 
   /* limit the rate of screenshots to avoid jamming HD when the key
-   * is pressed all the time */
-  if (time (NULL) - secs < 5)
+   * is pressed all the time, and don't start another one until the
+   * previous one is saved */
+  if (time (NULL) - secs < 5 || screenshot_in_flight)
     return;
 
   client = gconf_client_get_default ();
@@ -180,15 +164,18 @@ take_screenshot (void)
 				       0, 0,
 				       0, 0,
 				       width, height);
-  ret = gdk_pixbuf_save (image, filename, "png", &error, NULL);
+  if (!image)
+    {
+      g_warning ("%s: couldn't grab the screen", __func__);
+      g_free (filename);
+      return;
+    }
+  /* screenshot_saved() may be called right away. */
+  screenshot_in_flight = TRUE;
+  if (!hd_screenshot_save (image, filename, HD_SCREENSHOT_PNG,
+                           screenshot_saved, NULL))
+    screenshot_in_flight = FALSE;
   g_object_unref(image);
-
-  if (ret) {
-    g_debug ("Screenshot '%s' saved.", filename);
-  } else if (error) {
-    g_warning ("%s: Image saving failed: %s", __func__, error->message);
-    g_error_free (error);
-  }
   g_free (filename);
 }
 
@@ -373,6 +360,7 @@ dump_debug_info_when_idle (gpointer unused)
 {
   extern void hd_comp_mgr_dump_debug_info (const gchar *tag);
   hd_comp_mgr_dump_debug_info ("SIGUSR1");
+  hd_trace_save ();
   return FALSE;
 }
 
@@ -599,6 +587,11 @@ main (int argc, char **argv)
   HdAppMgr *app_mgr;
   char keys1[32], c; 
 
+  /* Before we grow big, so that starting applications doesn't
+   * need to copy us. */
+  hd_app_mgr_start_launch_helper ();
+
+  hd_trace_init ();
   signal (SIGUSR1, dump_debug_info_sighand);
   signal (SIGHUP,  relaunch);
   signal (SIGTERM, terminating);
@@ -817,6 +810,7 @@ main (int argc, char **argv)
 
   hd_app_mgr_stop ();
   g_object_unref (app_mgr);
+  hd_trace_save ();
   signal (SIGTERM, SIG_DFL);
 
 #if MBWM_WANT_DEBUG
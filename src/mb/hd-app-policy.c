@@ -0,0 +1,203 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-app-policy.h"
+#include "hd-transition.h"
+
+#include <string.h>
+
+#define APP_POLICY_INI  HD_DATADIR "/app-policy.ini"
+
+/* Used if app-policy.ini is missing or broken. */
+static const gchar default_policy[] =
+  "[class:Chessui]\n"
+  "force_composited=true\n"
+  "[class:Mahjong]\n"
+  "force_composited=true\n"
+  "[name:rtcom-call-ui]\n"
+  "call_ui=true\n"
+  "[name:systemui]\n"
+  "not_an_app=true\n";
+
+static const struct
+{
+  const gchar *key;
+  HdAppPolicy  flag;
+} policy_keys[] =
+{
+  { "force_composited",   HD_APP_POLICY_FORCE_COMPOSITED   },
+  { "call_ui",            HD_APP_POLICY_CALL_UI            },
+  { "not_an_app",         HD_APP_POLICY_NOT_AN_APP         },
+  { "portrait_blacklist", HD_APP_POLICY_PORTRAIT_BLACKLIST },
+  { "portrait_whitelist", HD_APP_POLICY_PORTRAIT_WHITELIST },
+};
+
+/* Maps WM_CLASS classes, WM_CLASS names and desktop ids to HdAppPolicy:s. */
+static GHashTable *by_class, *by_name, *by_desktop_id;
+
+/* The same for the [thp_tweaks] lists, which are by WM_CLASS name. */
+static GHashTable *tweaks_by_name;
+static gchar *tweaks_blacklist, *tweaks_whitelist;
+
+static void
+hd_app_policy_add (GHashTable *table, const gchar *key, HdAppPolicy flags)
+{
+  flags |= GPOINTER_TO_UINT (g_hash_table_lookup (table, key));
+  g_hash_table_insert (table, g_strdup (key), GUINT_TO_POINTER (flags));
+}
+
+static void
+hd_app_policy_load (void)
+{
+  GKeyFile *ini;
+  GError *error;
+  gchar **groups;
+  guint i, j;
+
+  if (by_class)
+    return;
+
+  by_class = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  by_desktop_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, NULL);
+
+  error = NULL;
+  ini = g_key_file_new ();
+  if (!g_key_file_load_from_file (ini, APP_POLICY_INI, 0, &error))
+    {
+      g_warning ("%s: couldn't load %s: %s", __FUNCTION__,
+                 APP_POLICY_INI, error->message);
+      g_error_free (error);
+      g_key_file_load_from_data (ini, default_policy, strlen (default_policy),
+                                 0, NULL);
+    }
+
+  groups = g_key_file_get_groups (ini, NULL);
+  for (i = 0; groups[i]; i++)
+    {
+      HdAppPolicy flags;
+      GHashTable *table;
+      const gchar *key;
+
+      /* Groups are "class:<res_class>", "name:<res_name>" or
+       * "desktop:<desktop id>". */
+      if (g_str_has_prefix (groups[i], "class:"))
+        table = by_class;
+      else if (g_str_has_prefix (groups[i], "name:"))
+        table = by_name;
+      else if (g_str_has_prefix (groups[i], "desktop:"))
+        table = by_desktop_id;
+      else
+        {
+          g_warning ("%s: ignoring unknown group [%s]", __FUNCTION__,
+                     groups[i]);
+          continue;
+        }
+      key = strchr (groups[i], ':') + 1;
+
+      flags = 0;
+      for (j = 0; j < G_N_ELEMENTS (policy_keys); j++)
+        if (g_key_file_get_boolean (ini, groups[i], policy_keys[j].key, NULL))
+          flags |= policy_keys[j].flag;
+      hd_app_policy_add (table, key, flags);
+    }
+
+  g_strfreev (groups);
+  g_key_file_free (ini);
+}
+
+/* @list is WM_CLASS names separated by spaces, tabs or commas. */
+static void
+hd_app_policy_add_list (const gchar *list, HdAppPolicy flag)
+{
+  gchar **names;
+  guint i;
+
+  names = g_strsplit_set (list, " \t,", -1);
+  for (i = 0; names[i]; i++)
+    if (*names[i])
+      hd_app_policy_add (tweaks_by_name, names[i], flag);
+  g_strfreev (names);
+}
+
+/* transitions.ini can change any time, so see if the lists are still
+ * the same.  This is only done when a new client is looked up. */
+static void
+hd_app_policy_update_tweaks (void)
+{
+  gchar *blacklist, *whitelist;
+
+  blacklist = hd_transition_get_string ("thp_tweaks", "blacklist", "");
+  whitelist = hd_transition_get_string ("thp_tweaks", "whitelist", "");
+  if (tweaks_by_name && !strcmp (blacklist, tweaks_blacklist)
+      && !strcmp (whitelist, tweaks_whitelist))
+    {
+      g_free (blacklist);
+      g_free (whitelist);
+      return;
+    }
+
+  if (tweaks_by_name)
+    g_hash_table_destroy (tweaks_by_name);
+  tweaks_by_name = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, NULL);
+  hd_app_policy_add_list (blacklist, HD_APP_POLICY_PORTRAIT_BLACKLIST);
+  hd_app_policy_add_list (whitelist, HD_APP_POLICY_PORTRAIT_WHITELIST);
+
+  g_free (tweaks_blacklist);
+  g_free (tweaks_whitelist);
+  tweaks_blacklist = blacklist;
+  tweaks_whitelist = whitelist;
+}
+
+/* Returns the policy of the application identified by any of the
+ * arguments, which can be NULL. */
+HdAppPolicy
+hd_app_policy_lookup (const gchar *res_class, const gchar *res_name,
+                      const gchar *desktop_id)
+{
+  HdAppPolicy policy;
+
+  hd_app_policy_load ();
+  hd_app_policy_update_tweaks ();
+
+  policy = 0;
+  if (res_class)
+    policy |= GPOINTER_TO_UINT (g_hash_table_lookup (by_class, res_class));
+  if (res_name)
+    {
+      policy |= GPOINTER_TO_UINT (g_hash_table_lookup (by_name, res_name));
+      policy |= GPOINTER_TO_UINT (g_hash_table_lookup (tweaks_by_name,
+                                                       res_name));
+    }
+  else
+    policy |= HD_APP_POLICY_UNNAMED;
+  if (desktop_id)
+    policy |= GPOINTER_TO_UINT (g_hash_table_lookup (by_desktop_id,
+                                                     desktop_id));
+
+  return policy;
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Per-application exceptions to the compositing and rotation rules,
+ * read from app-policy.ini and the [thp_tweaks] black- and whitelist
+ * of transitions.ini.  Applications are matched exactly by their
+ * WM_CLASS class, their WM_CLASS name or their desktop id.
+ */
+
+#ifndef __HD_APP_POLICY_H__
+#define __HD_APP_POLICY_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  HD_APP_POLICY_FORCE_COMPOSITED   = 1 << 0, /* Never unredirect it. */
+  HD_APP_POLICY_CALL_UI            = 1 << 1, /* Not orientation-locked. */
+  HD_APP_POLICY_NOT_AN_APP         = 1 << 2, /* Never the current app. */
+  HD_APP_POLICY_PORTRAIT_BLACKLIST = 1 << 3, /* Kept in landscape. */
+  HD_APP_POLICY_PORTRAIT_WHITELIST = 1 << 4, /* Allowed in portrait. */
+
+  /* These are not set by the configuration. */
+  HD_APP_POLICY_FORCE_LANDSCAPE    = 1 << 5, /* X-CSSU-Force-Landscape */
+  HD_APP_POLICY_UNNAMED            = 1 << 6  /* No WM_CLASS name. */
+} HdAppPolicy;
+
+HdAppPolicy hd_app_policy_lookup (const gchar *res_class,
+                                  const gchar *res_name,
+                                  const gchar *desktop_id);
+
+G_END_DECLS
+
+#endif /* __HD_APP_POLICY_H__ */
@@ -51,6 +51,11 @@ struct HdApp
   Bool         non_composited_read;
   Bool         non_composited;
   Bool         force_composited;
+  /* The window property said no to non-composited mode. */
+  Bool         non_composited_optout;
+  /* We decided to unredirect the client although it didn't ask for it,
+   * see hd_comp_mgr_update_auto_non_composited(). */
+  Bool         auto_non_composited;
 
   Window       detransitised_from;  
 };
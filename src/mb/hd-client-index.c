@@ -0,0 +1,71 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-client-index.h"
+
+/* ClutterActor -> MBWindowManagerClient and the other way round,
+ * so that a client can be removed without its actor. */
+static GHashTable *by_actor, *by_client;
+
+/* Makes @actor the actor of @client, replacing the previous one if any.
+ * A NULL @actor is the same as hd_client_index_remove(). */
+void
+hd_client_index_set (MBWindowManagerClient *client, ClutterActor *actor)
+{
+  hd_client_index_remove (client);
+  if (!actor)
+    return;
+
+  if (!by_actor)
+    {
+      by_actor = g_hash_table_new (NULL, NULL);
+      by_client = g_hash_table_new (NULL, NULL);
+    }
+
+  g_hash_table_insert (by_actor, actor, client);
+  g_hash_table_insert (by_client, client, actor);
+}
+
+void
+hd_client_index_remove (MBWindowManagerClient *client)
+{
+  ClutterActor *actor;
+
+  if (!by_client || !(actor = g_hash_table_lookup (by_client, client)))
+    return;
+
+  g_hash_table_remove (by_client, client);
+  /* Unless another client has taken it over meanwhile. */
+  if (g_hash_table_lookup (by_actor, actor) == client)
+    g_hash_table_remove (by_actor, actor);
+}
+
+/* Returns the client whose actor is @actor, or NULL. */
+MBWindowManagerClient *
+hd_client_index_lookup (ClutterActor *actor)
+{
+  return by_actor ? g_hash_table_lookup (by_actor, actor) : NULL;
+}
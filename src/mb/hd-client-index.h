@@ -0,0 +1,43 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Finds the window manager client of a window actor in O(1), for the
+ * render manager, which needs it for every actor on every restack.
+ * Maintained by the compositor as clients come and go.
+ */
+
+#ifndef __HD_CLIENT_INDEX_H__
+#define __HD_CLIENT_INDEX_H__
+
+#include <clutter/clutter.h>
+#include <matchbox/core/mb-wm.h>
+
+G_BEGIN_DECLS
+
+void                   hd_client_index_set    (MBWindowManagerClient *client,
+                                               ClutterActor          *actor);
+void                   hd_client_index_remove (MBWindowManagerClient *client);
+MBWindowManagerClient *hd_client_index_lookup (ClutterActor          *actor);
+
+G_END_DECLS
+
+#endif /* __HD_CLIENT_INDEX_H__ */
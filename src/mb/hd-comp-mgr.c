@@ -33,12 +33,16 @@
 #include "hd-wm.h"
 #include "hd-home-applet.h"
 #include "hd-app.h"
+#include "hd-app-policy.h"
+#include "hd-client-index.h"
 #include "hd-gtk-style.h"
 #include "hd-note.h"
 #include "hd-animation-actor.h"
 #include "hd-render-manager.h"
 #include "hd-title-bar.h"
 #include "hd-orientation-lock.h"
+#include "hd-trace.h"
+#include "hd-scheduler.h"
 #include "launcher/hd-app-mgr.h"
 #include "launcher/hd-launcher-editor.h"
 
@@ -54,6 +58,8 @@
 #include <clutter/x11/clutter-x11.h>
 
 #include "../tidy/tidy-blur-group.h"
+#include "../tidy/tidy-cached-group.h"
+#include "../tidy/tidy-fbo-pool.h"
 
 #include <dbus/dbus-glib-bindings.h>
 #include <mce/dbus-names.h>
@@ -63,6 +69,7 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <math.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
 
@@ -71,6 +78,10 @@
 #define STAMP_FILE                 STAMP_DIR "desktop-started.stamp"
 #define GCONF_KEY_DESKTOP_ORIENTATION_LOCK "/apps/osso/hildon-desktop/desktop_orientation_lock"
 
+/* How long a client needs to cover the screen opaquely before we
+ * unredirect it on our own, in ms. */
+#define AUTO_NON_COMPOSITED_DELAY  1500
+
 #if 0
 # define PORTRAIT       g_debug
 #else
@@ -95,10 +106,17 @@ struct HdCompMgrPrivate
 
   DBusConnection        *dbus_connection;
 
-  /* g_idle_add() event source, set by hd_comp_mgr_sync_stacking()
-   * to call hd_comp_mgr_restack() some time. */
+  /* Pre-paint job, set by hd_comp_mgr_sync_stacking() and when
+   * the WM restacks to call hd_comp_mgr_restack() some time. */
   guint                  stack_sync;
 
+  /* The HdCompMgrStackEntry:s of the stack and the home view last
+   * time the actors were restacked, and whether hd_comp_mgr_sync_stacking()
+   * wants them restacked anyway. */
+  GArray                *last_stack;
+  guint                  last_stack_view;
+  gboolean               restack_forced;
+
   /* Do Not Disturb flag */
   gboolean               do_not_disturb_flag : 1;
 
@@ -123,6 +141,11 @@ struct HdCompMgrPrivate
 
   /* GConf client for orientation lock. */
   GConfClient* gconf_client;
+
+  /* The client we're about to unredirect automatically, and the timer
+   * it's waiting for. */
+  Window                 auto_non_comp_window;
+  guint                  auto_non_comp_timer;
 };
 
 /*
@@ -137,13 +160,25 @@ struct HdCompMgrClientPrivate
   gboolean              can_hibernate : 1;
 
   gboolean              has_video_overlay;
+
+  /* Resolved when the client is created. */
+  HdAppPolicy           policy;
 };
 
 extern gboolean hd_dbus_display_is_off;
 static guint portrait_freshness_counter;
 
+/* Window -> HdAppPolicy of the clients which don't have their
+ * HdCompMgrClient (yet), so that it's resolved only once for them too. */
+static GHashTable *unmanaged_policies;
+
 HdRunningApp *hd_comp_mgr_client_get_app_key (HdCompMgrClient *client,
-                                               HdCompMgr *hmgr);
+                                               HdCompMgr *hmgr,
+                                               const XClassHint *class_hint);
+static HdAppPolicy hd_comp_mgr_resolve_policy (MBWindowManagerClient *c,
+                                               const XClassHint *class_hint,
+                                               HdRunningApp *app);
+static HdAppPolicy hd_comp_mgr_client_get_policy (MBWindowManagerClient *c);
 
 static void hd_comp_mgr_check_do_not_disturb_flag (HdCompMgr *hmgr);
 
@@ -156,6 +191,8 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
 
 static MBWindowManagerClient *hd_comp_mgr_determine_current_app (void);
 
+static void hd_comp_mgr_update_auto_non_composited (MBWMCompMgr *mgr);
+
 static MBWMCompMgrClient *
 hd_comp_mgr_client_new (MBWindowManagerClient * client)
 {
@@ -220,16 +257,13 @@ hd_comp_mgr_client_process_hibernation_prop (HdCompMgrClient * hc)
 }
 
 HdRunningApp *
-hd_comp_mgr_client_get_app_key (HdCompMgrClient *client, HdCompMgr *hmgr)
+hd_comp_mgr_client_get_app_key (HdCompMgrClient *client, HdCompMgr *hmgr,
+                                const XClassHint *class_hint)
 {
   MBWindowManagerClient *wm_client;
-  MBWindowManager       *wm;
-  XClassHint             class_hint;
-  Status                 status = 0;
   HdRunningApp          *app = NULL;
   HdCompMgrClientPrivate *priv = client->priv;
 
-  wm = MB_WM_COMP_MGR (hmgr)->wm;
   wm_client = MB_WM_COMP_MGR_CLIENT (client)->wm_client;
 
   /* We only lookup the app for main windows and dialogs. */
@@ -237,20 +271,11 @@ hd_comp_mgr_client_get_app_key (HdCompMgrClient *client, HdCompMgr *hmgr)
       MB_WM_CLIENT_CLIENT_TYPE (wm_client) != MBWMClientTypeDialog)
     return NULL;
 
-  memset(&class_hint, 0, sizeof(XClassHint));
-
-  /* We don't care about X errors here, because they will be reported
-   * in the return value of XGetWindowAttributes */
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-
-  status = XGetClassHint(wm->xdpy, wm_client->window->xwindow, &class_hint);
-
-  mb_wm_util_async_untrap_x_errors();
-  if (!status)
-    goto out;
+  if (!class_hint)
+    return NULL;
 
-  app = hd_app_mgr_match_window (class_hint.res_name,
-                                 class_hint.res_class,
+  app = hd_app_mgr_match_window (class_hint->res_name,
+                                 class_hint->res_class,
                                  wm_client->window->pid);
 
   if (app)
@@ -280,7 +305,7 @@ hd_comp_mgr_client_get_app_key (HdCompMgrClient *client, HdCompMgr *hmgr)
 
       key = g_strdup_printf ("%s/%s/%s/%d",
               hd_running_app_get_id (app),
-              class_hint.res_class ? class_hint.res_class : "",
+              class_hint->res_class ? class_hint->res_class : "",
               role ? role : "",
               level);
       g_debug ("%s: app %s, window key: %s\n", __FUNCTION__,
@@ -292,14 +317,88 @@ hd_comp_mgr_client_get_app_key (HdCompMgrClient *client, HdCompMgr *hmgr)
       g_free (key);
     }
 
- out:
+  return app;
+}
+
+static HdAppPolicy
+hd_comp_mgr_resolve_policy (MBWindowManagerClient *c,
+                            const XClassHint *class_hint,
+                            HdRunningApp *app)
+{
+  HdAppPolicy policy;
+  const gchar *res_name, *res_class;
+
+  /* Like before, a name without a class doesn't count. */
+  res_class = class_hint ? class_hint->res_class : NULL;
+  res_name  = res_class  ? class_hint->res_name  : NULL;
+
+  policy = hd_app_policy_lookup (res_class, res_name,
+                                 app ? hd_running_app_get_id (app) : NULL);
+
+  /* Check, if X-CSSU-Force-Landscape=true. */
+  if (HD_IS_APP (c)
+      && hd_comp_mgr_is_blacklisted_parse_desktop_file ((char *)res_name,
+                                                        (char *)res_class,
+                                                        c->window->pid))
+    policy |= HD_APP_POLICY_FORCE_LANDSCAPE;
+
+  return policy;
+}
+
+/* @c has its HdCompMgrClient or is gone, its policy needn't be
+ * remembered in @unmanaged_policies anymore. */
+static void
+hd_comp_mgr_client_forget_policy (MBWindowManagerClient *c)
+{
+  if (unmanaged_policies && c->window)
+    g_hash_table_remove (unmanaged_policies,
+                         GUINT_TO_POINTER (c->window->xwindow));
+}
+
+/* Returns the HdAppPolicy of @c, which is looked up only once. */
+static HdAppPolicy
+hd_comp_mgr_client_get_policy (MBWindowManagerClient *c)
+{
+  MBWindowManager *wm = c->wmref;
+  XClassHint class_hint;
+  HdRunningApp *app;
+  HdAppPolicy policy;
+  gpointer cached;
+  Status ret;
+
+  if (c->cm_client && HD_COMP_MGR_CLIENT (c->cm_client)->priv)
+    return HD_COMP_MGR_CLIENT (c->cm_client)->priv->policy;
+  if (!c->window)
+    return 0;
+
+  if (!unmanaged_policies)
+    unmanaged_policies = g_hash_table_new (NULL, NULL);
+  else if (g_hash_table_lookup_extended (unmanaged_policies,
+                                 GUINT_TO_POINTER (c->window->xwindow),
+                                 NULL, &cached))
+    return GPOINTER_TO_UINT (cached);
+
+  memset (&class_hint, 0, sizeof (XClassHint));
+  mb_wm_util_async_trap_x_errors (wm->xdpy);
+  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
+  mb_wm_util_async_untrap_x_errors ();
+
+  app = ret && HD_IS_APP (c)
+    ? hd_app_mgr_match_window (class_hint.res_name, class_hint.res_class,
+                               c->window->pid)
+    : NULL;
+  policy = hd_comp_mgr_resolve_policy (c, ret ? &class_hint : NULL, app);
+
   if (class_hint.res_class)
-    XFree(class_hint.res_class);
+    XFree (class_hint.res_class);
 
   if (class_hint.res_name)
-    XFree(class_hint.res_name);
+    XFree (class_hint.res_name);
 
-  return app;
+  g_hash_table_insert (unmanaged_policies,
+                       GUINT_TO_POINTER (c->window->xwindow),
+                       GUINT_TO_POINTER (policy));
+  return policy;
 }
 
 static int
@@ -310,12 +409,23 @@ hd_comp_mgr_client_init (MBWMObject *obj, va_list vap)
   HdCompMgr              *hmgr;
   MBWindowManagerClient  *wm_client = MB_WM_COMP_MGR_CLIENT (obj)->wm_client;
   HdRunningApp          *app;
+  XClassHint             class_hint;
+  Status                 status;
 
   hmgr = HD_COMP_MGR (wm_client->wmref->comp_mgr);
 
   priv = client->priv = g_new0 (HdCompMgrClientPrivate, 1);
 
-  app = hd_comp_mgr_client_get_app_key (client, hmgr);
+  /* We don't care about X errors here, because they will be reported
+   * in the return value of XGetWindowAttributes */
+  memset(&class_hint, 0, sizeof(XClassHint));
+  mb_wm_util_async_trap_x_errors (wm_client->wmref->xdpy);
+  status = XGetClassHint(wm_client->wmref->xdpy, wm_client->window->xwindow,
+                         &class_hint);
+  mb_wm_util_async_untrap_x_errors();
+
+  app = hd_comp_mgr_client_get_app_key (client, hmgr,
+                                        status ? &class_hint : NULL);
   if (app)
     {
       priv->app = g_object_ref (app);
@@ -333,6 +443,17 @@ hd_comp_mgr_client_init (MBWMObject *obj, va_list vap)
                            GUINT_TO_POINTER (++windows));
     }
 
+  priv->policy = hd_comp_mgr_resolve_policy (wm_client,
+                                             status ? &class_hint : NULL,
+                                             app);
+  hd_comp_mgr_client_forget_policy (wm_client);
+
+  if (class_hint.res_class)
+    XFree(class_hint.res_class);
+
+  if (class_hint.res_name)
+    XFree(class_hint.res_name);
+
   /* Initially get window overlay state */
   client->priv->has_video_overlay = hd_util_client_has_video_overlay(wm_client);
 
@@ -443,6 +564,7 @@ static void hd_comp_mgr_map_notify
 static void hd_comp_mgr_unmap_notify
                         (MBWMCompMgr *mgr, MBWindowManagerClient *c);
 static void hd_comp_mgr_turn_on (MBWMCompMgr *mgr);
+static void hd_comp_mgr_queue_restack (MBWMCompMgr *mgr);
 static void hd_comp_mgr_effect (MBWMCompMgr *mgr, MBWindowManagerClient *c,
                                 MBWMCompMgrClientEvent event);
 static Bool hd_comp_mgr_client_property_changed (XPropertyEvent *event,
@@ -483,7 +605,7 @@ hd_comp_mgr_class_init (MBWMObjectClass *klass)
   cm_klass->turn_on           = hd_comp_mgr_turn_on;
   cm_klass->map_notify        = hd_comp_mgr_map_notify;
   cm_klass->unmap_notify      = hd_comp_mgr_unmap_notify;
-  cm_klass->restack           = (void (*)(MBWMCompMgr*))hd_comp_mgr_restack;
+  cm_klass->restack           = hd_comp_mgr_queue_restack;
 
   clutter_klass->client_new   = hd_comp_mgr_client_new;
 
@@ -638,7 +760,11 @@ hd_comp_mgr_destroy (MBWMObject *obj)
     }
 
   if (priv->stack_sync)
-    g_source_remove (priv->stack_sync);
+    hd_scheduler_remove (priv->stack_sync);
+  if (priv->last_stack)
+    g_array_free (priv->last_stack, TRUE);
+  if (priv->auto_non_comp_timer)
+    g_source_remove (priv->auto_non_comp_timer);
 }
 
 HdCompMgrClient *
@@ -747,6 +873,7 @@ hd_comp_mgr_client_property_changed (XPropertyEvent *event, HdCompMgr *hmgr)
   if (event->atom == wm->atoms[MBWM_ATOM_NET_WM_STATE] || non_comp_changed)
     {
       c = mb_wm_managed_client_from_xwindow (wm, event->window);
+      hd_comp_mgr_update_auto_non_composited (MB_WM_COMP_MGR (hmgr));
       if (c && HD_IS_APP (c))
         {
           gboolean client_non_comp;
@@ -1153,6 +1280,9 @@ hd_comp_mgr_register_client (MBWMCompMgr           * mgr,
 
   if (parent_klass->register_client)
     parent_klass->register_client (mgr, c, activate);
+  if (c->cm_client)
+    hd_client_index_set (c, mb_wm_comp_mgr_clutter_client_get_actor (
+                              MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client)));
 
   if (!activate)
     {
@@ -1183,6 +1313,8 @@ hd_comp_mgr_unregister_client (MBWMCompMgr *mgr, MBWindowManagerClient *c)
 
   g_debug ("%s, c=%p ctype=%d", __FUNCTION__, c, MB_WM_CLIENT_CLIENT_TYPE (c));
   actor = mb_wm_comp_mgr_clutter_client_get_actor (cclient);
+  hd_client_index_remove (c);
+  hd_comp_mgr_client_forget_policy (c);
 
   /* Check if it's the last window for the app. */
   if (hclient->priv->app)
@@ -1418,7 +1550,7 @@ hd_comp_mgr_texture_update_area(HdCompMgr *hmgr,
                                 ClutterActor* actor)
 {
   ClutterActor *parent;
-  gboolean blur_update = FALSE;
+  gboolean blur_update = FALSE, cached_update = FALSE;
   ClutterActor *actors_stage;
 
   if (!actor || !CLUTTER_ACTOR_IS_VISIBLE(actor) || hmgr == 0)
@@ -1467,12 +1599,17 @@ hd_comp_mgr_texture_update_area(HdCompMgr *hmgr,
           if (tidy_blur_group_source_buffered(parent))
             blur_update = TRUE;
         }
+      /* Cached groups which refresh themselves will redraw when they do,
+       * but the blur groups above them still need to know. */
+      if (TIDY_IS_CACHED_GROUP(parent)
+          && tidy_cached_group_hint_source_changed(parent))
+        cached_update = TRUE;
       parent = clutter_actor_get_parent(parent);
     }
 
   /* We no longer display changes that occur on blurred windows, so if
    * this damage was actually on a blurred window, forget about it. */
-  if (blur_update)
+  if (blur_update || cached_update)
     return;
 
   /* Update the screen. This function checks for scaling/visibility and
@@ -1606,6 +1743,7 @@ hd_comp_mgr_unredirect_topmost_client (MBWindowManager *wm, gboolean force)
       if (c->cm_client && c->window->net_type ==
             wm->atoms[MBWM_ATOM_NET_WM_WINDOW_TYPE_NORMAL] &&
           (c->window->ewmh_state & MBWMClientWindowEWMHStateFullscreen
+           || (HD_IS_APP (c) && HD_APP (c)->auto_non_composited)
            || force))
         {
           if (!mb_wm_comp_mgr_clutter_client_is_unredirected (c->cm_client))
@@ -1620,6 +1758,108 @@ hd_comp_mgr_unredirect_topmost_client (MBWindowManager *wm, gboolean force)
     }
 }
 
+/* Returns whether @c covers the screen with opaque content and hasn't
+ * said anything against non-composited mode.  Only the client window
+ * itself counts, not its decoration, which we'd lose with compositing. */
+static gboolean
+hd_comp_mgr_client_can_auto_non_composite (MBWindowManagerClient *c)
+{
+  MBGeometry *geo;
+  Bool bshaped, cshaped;
+  int xb, yb, xc, yc;
+  unsigned wb, hb, wc, hc;
+  Status ret;
+
+  if (!HD_IS_APP (c) || !c->window || !c->cm_client)
+    return FALSE;
+  if (HD_APP (c)->force_composited || HD_APP (c)->non_composited_optout)
+    return FALSE;
+  if (c->is_argb32 || mb_wm_theme_is_client_shaped (c->wmref->theme, c))
+    return FALSE;
+
+  geo = &c->window->geometry;
+  if (!(geo->x <= 0 && geo->y <= 0
+        && geo->x + geo->width  >= hd_comp_mgr_get_current_screen_width ()
+        && geo->y + geo->height >= hd_comp_mgr_get_current_screen_height ()))
+    return FALSE;
+
+  /* The theme only knows about the decoration, ask about the client. */
+  mb_wm_util_async_trap_x_errors (c->wmref->xdpy);
+  ret = XShapeQueryExtents (c->wmref->xdpy, c->window->xwindow,
+                            &bshaped, &xb, &yb, &wb, &hb,
+                            &cshaped, &xc, &yc, &wc, &hc);
+  mb_wm_util_async_untrap_x_errors ();
+
+  /* The window may be gone, then the query fails. */
+  return ret && !bshaped;
+}
+
+static gboolean
+hd_comp_mgr_auto_non_composited_timeout (MBWMCompMgr *mgr)
+{
+  HdCompMgrPrivate *priv = HD_COMP_MGR (mgr)->priv;
+  MBWindowManagerClient *c;
+
+  priv->auto_non_comp_timer = 0;
+  c = hd_comp_mgr_determine_current_app ();
+  if (c && c->window && c->window->xwindow == priv->auto_non_comp_window
+      && hd_comp_mgr_client_can_auto_non_composite (c))
+    {
+      g_debug ("%s: unredirecting '%s'", __FUNCTION__,
+               mb_wm_client_get_name (c));
+      HD_APP (c)->auto_non_composited = TRUE;
+      hd_comp_mgr_reconsider_compositing (mgr);
+    }
+
+  return FALSE;
+}
+
+/*
+ * Clients which don't ask for non-composited mode but cover the screen
+ * with opaque content are unredirected too, once they have done so for
+ * %AUTO_NON_COMPOSITED_DELAY.  Going back to composited mode is immediate,
+ * but the delay applies again before the next unredirection, so that we
+ * don't flap when something pops up repeatedly over the client.
+ * To be called whenever the current application may have changed.
+ */
+static void
+hd_comp_mgr_update_auto_non_composited (MBWMCompMgr *mgr)
+{
+  HdCompMgrPrivate *priv = HD_COMP_MGR (mgr)->priv;
+  MBWindowManagerClient *c, *old;
+
+  c = hd_comp_mgr_determine_current_app ();
+  if (c && (c == mgr->wm->desktop || !c->window))
+    c = NULL;
+
+  if (priv->auto_non_comp_window
+      && (!c || c->window->xwindow != priv->auto_non_comp_window))
+    { /* The previous candidate is not on top anymore. */
+      old = mb_wm_managed_client_from_xwindow (mgr->wm,
+                                               priv->auto_non_comp_window);
+      if (old && HD_IS_APP (old))
+        HD_APP (old)->auto_non_composited = FALSE;
+      priv->auto_non_comp_window = None;
+    }
+
+  if (!c || !hd_comp_mgr_client_can_auto_non_composite (c))
+    {
+      if (c && HD_IS_APP (c))
+        HD_APP (c)->auto_non_composited = FALSE;
+      if (priv->auto_non_comp_timer)
+        {
+          g_source_remove (priv->auto_non_comp_timer);
+          priv->auto_non_comp_timer = 0;
+        }
+      return;
+    }
+
+  priv->auto_non_comp_window = c->window->xwindow;
+  if (!HD_APP (c)->auto_non_composited && !priv->auto_non_comp_timer)
+    priv->auto_non_comp_timer = g_timeout_add (AUTO_NON_COMPOSITED_DELAY,
+                  (GSourceFunc)hd_comp_mgr_auto_non_composited_timeout, mgr);
+}
+
 static void
 hd_comp_mgr_unredirect_client (MBWindowManagerClient *c)
 {
@@ -1655,32 +1895,13 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
 
   wm = client->wmref;
 
-  if (!HD_APP (client)->non_composited_read)
+  if (!HD_APP (client)->non_composited_read
+      && (hd_comp_mgr_client_get_policy (client)
+          & HD_APP_POLICY_FORCE_COMPOSITED))
     {
-      /* check if the window is blacklisted */
-      XClassHint class_hint;
-      memset (&class_hint, 0, sizeof (XClassHint));
-      mb_wm_util_async_trap_x_errors (wm->xdpy);
-      ret = XGetClassHint (wm->xdpy, client->window->xwindow, &class_hint);
-      mb_wm_util_async_untrap_x_errors ();
-
-      if (ret && class_hint.res_class)
-        {
-          if (!strcmp (class_hint.res_class, "Chessui") ||
-              !strcmp (class_hint.res_class, "Mahjong"))
-            {
-              /* g_printerr ("%s: mahjong or chess\n", __func__); */
-              HD_APP (client)->non_composited_read = True;
-              HD_APP (client)->non_composited = False;
-              HD_APP (client)->force_composited = True;
-            }
-        }
-
-      if (class_hint.res_class)
-        XFree (class_hint.res_class);
-
-      if (class_hint.res_name)
-        XFree (class_hint.res_name);
+      HD_APP (client)->non_composited_read = True;
+      HD_APP (client)->non_composited = False;
+      HD_APP (client)->force_composited = True;
     }
 
   if (HD_APP (client)->force_composited)
@@ -1692,7 +1913,8 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
           && HD_APP (client)->non_composited)
         return TRUE;
       else
-        return FALSE;
+        return HD_APP (client)->auto_non_composited
+          && hd_comp_mgr_client_can_auto_non_composite (client);
     }
 
   hmgr = HD_COMP_MGR (wm->comp_mgr);
@@ -1718,6 +1940,7 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
       XFree (prop);
     }
 
+  HD_APP (client)->non_composited_optout = False;
   if (actual_type == XA_INTEGER)
     {
       if (value)
@@ -1727,7 +1950,11 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
             return TRUE;
         }
       else
-        HD_APP (client)->non_composited = False;
+        {
+          HD_APP (client)->non_composited = False;
+          HD_APP (client)->non_composited_optout = True;
+          HD_APP (client)->auto_non_composited = False;
+        }
     }
   else
    {
@@ -1741,7 +1968,8 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
      else
        HD_APP (client)->non_composited = False;
    }
-  return FALSE;
+  return HD_APP (client)->auto_non_composited
+    && hd_comp_mgr_client_can_auto_non_composite (client);
 }
 
 /* returns HdApp of client that was replaced (because the stack_index
@@ -2065,6 +2293,12 @@ hd_comp_mgr_map_notify (MBWMCompMgr *mgr, MBWindowManagerClient *c)
   if (MB_WM_CLIENT_CLIENT_TYPE (c) == MBWMClientTypeDesktop)
     return;
 
+  /* In case it didn't have its actor yet when it was registered;
+   * the restacks below look it up. */
+  if (c->cm_client)
+    hd_client_index_set (c, mb_wm_comp_mgr_clutter_client_get_actor (
+                              MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client)));
+
   if (c->window->live_background)
     {
       /*g_printerr ("%s: client '%s' is live background\n", __func__,
@@ -2684,7 +2918,7 @@ hd_comp_mgr_determine_current_app ()
         continue;
       if (!c->window)
         continue;
-      if (c->window->name && !g_ascii_strncasecmp (c->window->name, "systemui", 8))
+      if (hd_comp_mgr_client_get_policy (c) & HD_APP_POLICY_NOT_AN_APP)
         /* systemui is not an application. */
         continue;
       return c;
@@ -2749,6 +2983,9 @@ hd_comp_mgr_reconsider_compositing (MBWMCompMgr *mgr)
 
           if (found || !hd_comp_mgr_is_non_composited (c, FALSE))
             {
+              if (HD_IS_APP (c))
+                /* Take our time before unredirecting it again. */
+                HD_APP (c)->auto_non_composited = FALSE;
               hd_render_manager_switch_to_composited_state ();
               return TRUE;
             }
@@ -3049,12 +3286,103 @@ hd_comp_mgr_effect (MBWMCompMgr                *mgr,
     }
 }
 
+/* What the restacking of the actors depends on: besides the order,
+ * everything hd_render_manager_restack() looks at in the clients. */
+typedef struct
+{
+  Window              xwin;
+  MBWMCompMgrClient  *cm_client;
+  ClutterActor       *actor;
+  MBGeometry          geometry, window_geometry;
+  gint                desktop;
+  gint                live_background;
+  gboolean            unmap_confirmed;
+  guint               cm_flags;
+} HdCompMgrStackEntry;
+
+static GArray *
+hd_comp_mgr_get_stack (MBWindowManager *wm)
+{
+  MBWindowManagerClient *c;
+  HdCompMgrStackEntry entry;
+  GArray *stack;
+
+  stack = g_array_new (FALSE, FALSE, sizeof (entry));
+  mb_wm_stack_enumerate (wm, c)
+    {
+      /* It's compared with memcmp(), so clear the padding. */
+      memset (&entry, 0, sizeof (entry));
+      entry.xwin = c->window->xwindow;
+      entry.cm_client = c->cm_client;
+      entry.actor = c->cm_client
+        ? mb_wm_comp_mgr_clutter_client_get_actor (
+                              MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client))
+        : NULL;
+      entry.geometry = c->frame_geometry;
+      entry.window_geometry = c->window->geometry;
+      entry.desktop = c->desktop;
+      entry.live_background = c->window->live_background;
+      entry.unmap_confirmed = mb_wm_client_is_unmap_confirmed (c) != 0;
+      entry.cm_flags = c->cm_client
+        ? mb_wm_comp_mgr_clutter_client_get_flags (
+                              MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client))
+        : 0;
+      g_array_append_val (stack, entry);
+    }
+
+  return stack;
+}
+
+/* Has the stack changed since the actors were last restacked?
+ * If so, remember it as it is now. */
+static gboolean
+hd_comp_mgr_stack_changed (HdCompMgr *hmgr)
+{
+  HdCompMgrPrivate *priv = hmgr->priv;
+  GArray *stack;
+  guint view;
+  gboolean changed;
+
+  /* The live background and the applets shown depend on the view. */
+  view = priv->home ? hd_home_get_current_view_id (HD_HOME (priv->home)) : 0;
+
+  stack = hd_comp_mgr_get_stack (MB_WM_COMP_MGR (hmgr)->wm);
+  changed = priv->restack_forced || !priv->last_stack
+    || priv->last_stack_view != view
+    || priv->last_stack->len != stack->len
+    || memcmp (priv->last_stack->data, stack->data,
+               stack->len * sizeof (HdCompMgrStackEntry));
+  priv->restack_forced = FALSE;
+
+  if (priv->last_stack)
+    g_array_free (priv->last_stack, TRUE);
+  priv->last_stack = stack;
+  priv->last_stack_view = view;
+
+  return changed;
+}
+
+/* The WM wants the actors restacked.  It does so many times during
+ * a burst of events, so just do it once before the next frame. */
+static void
+hd_comp_mgr_queue_restack (MBWMCompMgr *mgr)
+{
+  HdCompMgrPrivate *priv = HD_COMP_MGR (mgr)->priv;
+
+  if (!priv->stack_sync)
+    priv->stack_sync = hd_scheduler_add (HD_SCHEDULE_PRE_PAINT,
+                                         "sync_stacking",
+                                         (GSourceFunc)hd_comp_mgr_restack,
+                                         mgr, NULL);
+}
+
 gboolean
 hd_comp_mgr_restack (MBWMCompMgr * mgr)
 {
   HdCompMgrPrivate         * priv = HD_COMP_MGR (mgr)->priv;
   MBWMCompMgrClass         * parent_klass =
     MB_WM_COMP_MGR_CLASS (MB_WM_OBJECT_GET_PARENT_CLASS(MB_WM_OBJECT(mgr)));
+  gboolean                   stack_changed;
 
   /* g_debug ("%s", __FUNCTION__); */
 
@@ -3066,7 +3394,7 @@ hd_comp_mgr_restack (MBWMCompMgr * mgr)
    */
   if (priv->stack_sync)
     {
-      g_source_remove (priv->stack_sync);
+      hd_scheduler_remove (priv->stack_sync);
       priv->stack_sync = 0;
     }
 
@@ -3081,11 +3409,16 @@ hd_comp_mgr_restack (MBWMCompMgr * mgr)
       return FALSE;
     }
 
+  hd_trace_begin (HD_TRACE_RESTACK, "hd_comp_mgr_restack");
+
   /* Hide the Edit button if it is currently shown */
   if (priv->home)
     hd_home_hide_edit_button (HD_HOME (priv->home));
 
-  if (parent_klass->restack)
+  /* Reordering the actors and recomputing visibility and input
+   * shapes is only worth it if the stack has changed. */
+  stack_changed = hd_comp_mgr_stack_changed (HD_COMP_MGR (mgr));
+  if (stack_changed && parent_klass->restack)
     parent_klass->restack (mgr);
 
   /* Update _MB_CURRENT_APP_WINDOW if we're ready and it's changed.
@@ -3131,7 +3464,10 @@ hd_comp_mgr_restack (MBWMCompMgr * mgr)
                * client on top of non-composited client */
               hd_comp_mgr_reconsider_compositing (mgr);
               if (new_current_app)
-                hd_app_mgr_hibernatable (new_current_app, FALSE);
+                {
+                  hd_app_mgr_hibernatable (new_current_app, FALSE);
+                  hd_app_mgr_app_switched_to (new_current_app);
+                }
             }
 
           priv->current_hclient = new_current_hclient;
@@ -3150,25 +3486,24 @@ hd_comp_mgr_restack (MBWMCompMgr * mgr)
 
   /* Decide about portraitification in case a blocking window was unmapped. */
   hd_comp_mgr_check_do_not_disturb_flag (HD_COMP_MGR (mgr));
-  hd_render_manager_restack ();
+  hd_comp_mgr_update_auto_non_composited (mgr);
+  if (stack_changed)
+    hd_render_manager_restack ();
   hd_app_mgr_mce_activate_accel_if_needed (FALSE);
   hd_comp_mgr_portrait_or_not_portrait (mgr, NULL);
+  hd_trace_end (HD_TRACE_RESTACK, "hd_comp_mgr_restack");
 
   return FALSE;
 }
 
-/* Do a restack some time.  Used in cases when multiple parties
- * want restacking, not knowing about each other. */
+/* Do a restack some time, even if the stack hasn't changed.  Used in
+ * cases when multiple parties want restacking, not knowing about each
+ * other, or when the render manager's idea of the stacking changes. */
 void
 hd_comp_mgr_sync_stacking (HdCompMgr * hmgr)
 {
-  HdCompMgrPrivate * priv = hmgr->priv;
-
-  if (!priv->stack_sync)
-    /* We need higher priority than idles usually have because
-     * the effect has higher priority too and it could starve us. */
-    priv->stack_sync = g_idle_add_full (0, (GSourceFunc)hd_comp_mgr_restack,
-                                        hmgr, NULL);
+  hmgr->priv->restack_forced = TRUE;
+  hd_comp_mgr_queue_restack (MB_WM_COMP_MGR (hmgr));
 }
 
 /*
@@ -3792,6 +4127,7 @@ hd_comp_mgr_dump_debug_info (const gchar *tag)
   XFree(inputshape);
 
   dump_clutter_actor_tree (clutter_stage_get_default (), NULL);
+  tidy_fbo_pool_dump ();
   hd_app_mgr_dump_app_list (TRUE);
 #endif
 }
@@ -3884,11 +4220,7 @@ hd_comp_mgr_update_applets_on_current_desktop_property (HdCompMgr *hmgr)
 gboolean
 hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
 {
-  gchar *whitelist;
-  XClassHint class_hint;
-  Status ret;
-  gchar *wname = NULL;
-  gboolean is_on_whitelist = FALSE;
+  gboolean is_on_whitelist;
 
   if ((!c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
     return FALSE;
@@ -3899,84 +4231,38 @@ hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
       return FALSE;
   }
 
-  whitelist = g_strdup(hd_transition_get_string("thp_tweaks", "whitelist", ""));
-  memset(&class_hint, 0, sizeof(XClassHint));
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
-  mb_wm_util_async_untrap_x_errors ();
-
-  if (ret && class_hint.res_class)
-    wname = g_strdup(class_hint.res_name);
-
-  if (class_hint.res_class)
-    XFree(class_hint.res_class);
-
-  if (class_hint.res_name)
-    XFree(class_hint.res_name);
-
-  if (g_strrstr(whitelist, wname))
-    is_on_whitelist = TRUE;
+  is_on_whitelist = (hd_comp_mgr_client_get_policy (c)
+                     & HD_APP_POLICY_PORTRAIT_WHITELIST) != 0;
 
-  PORTRAIT ("Whitelist: WName %s; Supp: %d; Req: %d; SuppInh: %d, ReqInh: %d", wname, c->portrait_supported, c->portrait_requested, c->portrait_supported_inherited, c->portrait_requested_inherited);
+  PORTRAIT ("Whitelist: %d; Supp: %d; Req: %d; SuppInh: %d, ReqInh: %d", is_on_whitelist, c->portrait_supported, c->portrait_requested, c->portrait_supported_inherited, c->portrait_requested_inherited);
 #ifdef DEBUG_WINDOWS
   if (c->transient_for)
       PORTRAIT("Whitelist: Parent Sup: %d Req: %d", c->transient_for->portrait_supported, c->transient_for->portrait_requested);
 #endif
 
-  g_free(whitelist);
-  g_free(wname);
-
   return is_on_whitelist;
 }
 
 gboolean
 hd_comp_mgr_is_blacklisted(MBWindowManager *wm, MBWindowManagerClient *c)
 {
-  gchar *blacklist;
-  XClassHint class_hint;
-  Status ret;
-  gchar *wname = NULL;
-  gboolean blacklisted = FALSE;
-  gboolean blacklisted_by_desktopfile = FALSE;
+  HdAppPolicy policy;
+  gboolean blacklisted;
   gboolean forcerotation = hd_transition_get_int("thp_tweaks", "forcerotation", 0);
 
   if ((!c) || !HD_IS_APP (c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
     return FALSE;
 
-  blacklist = g_strdup (hd_transition_get_string ("thp_tweaks", "blacklist", ""));
-  memset (&class_hint, 0, sizeof (XClassHint));
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
-  mb_wm_util_async_untrap_x_errors ();
-
-  if (ret && class_hint.res_class)
-    wname = g_strdup (class_hint.res_name);
-
-  /* Check, if X-CSSU-Force-Landscape=true. */
-  blacklisted_by_desktopfile = hd_comp_mgr_is_blacklisted_parse_desktop_file (wname, class_hint.res_class, c->window->pid);
-
-  if (class_hint.res_class)
-    XFree(class_hint.res_class);
-
-  if (class_hint.res_name)
-    XFree(class_hint.res_name);
-
-  if (!blacklisted_by_desktopfile)
-    {
-      if (g_strrstr(blacklist, wname))
-        blacklisted = TRUE;
-
-      if (c->stacked_below && (wname == NULL))
-        if (hd_comp_mgr_is_blacklisted (wm, c->stacked_below))
-          blacklisted = TRUE;
-    }
-
-  g_free (blacklist);
-  g_free (wname);
+  policy = hd_comp_mgr_client_get_policy (c);
 
-  if (blacklisted_by_desktopfile)
+  /* X-CSSU-Force-Landscape=true in the desktop file. */
+  if (policy & HD_APP_POLICY_FORCE_LANDSCAPE)
     return TRUE;
 
+  blacklisted = (policy & HD_APP_POLICY_PORTRAIT_BLACKLIST) != 0;
+  if (!blacklisted && c->stacked_below && (policy & HD_APP_POLICY_UNNAMED))
+    blacklisted = hd_comp_mgr_is_blacklisted (wm, c->stacked_below);
+
   /* Do not lock to landscape a window which supports portrait mode. */
   if (c->portrait_supported || c->portrait_requested)
       return FALSE;
@@ -4015,35 +4301,10 @@ hd_comp_mgr_is_blacklisted_parse_desktop_file(char *res_name,
 gboolean
 hd_comp_mgr_is_callui_window (MBWindowManager *wm, MBWindowManagerClient *c)
 {
-  gchar *whitelist = "rtcom-call-ui";
-  XClassHint class_hint;
-  Status ret;
-  gchar *wname = NULL;
-  gboolean is_callui_window = FALSE;
-
   if ((!c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
     return FALSE;
 
-  memset(&class_hint, 0, sizeof(XClassHint));
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
-  mb_wm_util_async_untrap_x_errors ();
-
-  if (ret && class_hint.res_class)
-    wname = g_strdup(class_hint.res_name);
-
-  if (class_hint.res_class)
-    XFree(class_hint.res_class);
-
-  if (class_hint.res_name)
-    XFree(class_hint.res_name);
-
-  if (g_strrstr(whitelist, wname))
-    is_callui_window = TRUE;
-
-  g_free(wname);
-
-  return is_callui_window;
+  return (hd_comp_mgr_client_get_policy (c) & HD_APP_POLICY_CALL_UI) != 0;
 }
 
 gboolean
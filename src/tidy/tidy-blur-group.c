@@ -8,6 +8,7 @@
 
 #include "tidy-blur-group.h"
 #include "tidy-util.h"
+#include "tidy-fbo-pool.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -139,6 +140,9 @@ struct _TidyBlurGroupPrivate
   /* Internal TidyBlurGroup stuff */
   ClutterShader *shader_blur;
   ClutterShader *shader_saturate;
+  /* Taken from the pool only while we're buffering. */
+  TidyFbo *buf_a, *buf_b;
+  guint tex_width, tex_height;
   CoglHandle tex_a;
   CoglHandle fbo_a;
   CoglHandle tex_b;
@@ -242,43 +246,59 @@ static void tidy_blur_group_check_shader(TidyBlurGroup *group,
    }
 }
 
-/* Allocate @priv->fbo_[ab]. */
+/* Return @priv->buf_[ab] to the pool. */
 static void
-tidy_blur_group_allocate_textures (TidyBlurGroup *self)
+tidy_blur_group_release_textures (TidyBlurGroup *self)
 {
   TidyBlurGroupPrivate *priv = self->priv;
-  guint tex_width, tex_height;
 
-#ifdef __i386__
-  if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
-    /* Don't try to allocate FBOs. */
+  if (!priv->buf_a)
     return;
-#endif
+
+  tidy_fbo_pool_release(priv->buf_a);
+  tidy_fbo_pool_release(priv->buf_b);
+  priv->buf_a = priv->buf_b = NULL;
+  priv->tex_a = priv->fbo_a = 0;
+  priv->tex_b = priv->fbo_b = 0;
+  priv->current_blur_step = 0;
+  priv->source_changed = TRUE;
+}
+
+/* Get @priv->buf_[ab] from the pool if we don't have them. */
+static void
+tidy_blur_group_acquire_textures (TidyBlurGroup *self)
+{
+  TidyBlurGroupPrivate *priv = self->priv;
+
+  if (priv->buf_a)
+    return;
+
+  priv->buf_a = tidy_fbo_pool_acquire(priv->tex_width, priv->tex_height,
+                                      priv->use_alpha);
+  priv->buf_b = tidy_fbo_pool_acquire(priv->tex_width, priv->tex_height,
+                                      priv->use_alpha);
+  priv->tex_a = priv->buf_a->tex;
+  priv->fbo_a = priv->buf_a->fbo;
+  priv->tex_b = priv->buf_b->tex;
+  priv->fbo_b = priv->buf_b->fbo;
+  priv->current_blur_step = 0;
+  priv->source_changed = TRUE;
+}
+
+/* Work out the size of @priv->fbo_[ab]. */
+static void
+tidy_blur_group_allocate_textures (TidyBlurGroup *self)
+{
+  TidyBlurGroupPrivate *priv = self->priv;
+  guint tex_width, tex_height;
 
 #if !RESIZE_TEXTURE
-  if (priv->fbo_a && priv->fbo_b)
+  if (priv->tex_width && priv->tex_height)
     /* Rotate in _paint() rather than resize. */
     return;
 #endif
 
-  /* Free the textures. */
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
-  if (priv->fbo_b)
-    {
-      cogl_offscreen_unref(priv->fbo_b);
-      cogl_texture_unref(priv->tex_b);
-      priv->fbo_b = 0;
-      priv->tex_b = 0;
-    }
-
-  /* (Re)create the textures + offscreen buffers.  Downsample by 2.
-   * We can specify mipmapping here, but we don't need it. */
+  /* Downsample by 2. */
   clutter_actor_get_size(CLUTTER_ACTOR(self), &tex_width, &tex_height);
 
   /* if we want blurless desaturation, don't downsample (downsampling
@@ -289,20 +309,12 @@ tidy_blur_group_allocate_textures (TidyBlurGroup *self)
       tex_height /= 2;
     }
 
-  priv->tex_a = cogl_texture_new_with_size(
-            tex_width, tex_height, 0, FALSE /* mipmap */,
-            priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
-                              COGL_PIXEL_FORMAT_RGB_565);
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_a = cogl_offscreen_new_to_texture(priv->tex_a);
-
-  priv->tex_b = cogl_texture_new_with_size(
-            tex_width, tex_height, 0, FALSE /* mipmap */,
-            priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
-                              COGL_PIXEL_FORMAT_RGB_565);
-  cogl_texture_set_filters(priv->tex_b, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_b = cogl_offscreen_new_to_texture(priv->tex_b);
+  if (tex_width == priv->tex_width && tex_height == priv->tex_height)
+    return;
 
+  priv->tex_width  = tex_width;
+  priv->tex_height = tex_height;
+  tidy_blur_group_release_textures(self);
   priv->current_blur_step = 0;
   priv->source_changed = TRUE;
 }
@@ -388,44 +400,6 @@ tidy_blur_group_do_chequer(TidyBlurGroup *group, guint width, guint height)
                           CFX_ONE*height/CHEQUER_SIZE);
 }
 
-/* Recursively set texture filtering state on this actor and children, and
- * save the old state in the object. */
-static void
-recursive_set_linear_texture_filter(ClutterActor *actor, GArray *filters)
-{
-  if (CLUTTER_IS_CONTAINER(actor))
-    clutter_container_foreach(CLUTTER_CONTAINER(actor),
-                   (ClutterCallback)recursive_set_linear_texture_filter,
-                   filters);
-  else if (CLUTTER_IS_TEXTURE(actor))
-    {
-      ClutterTexture *tex = CLUTTER_TEXTURE(actor);
-      ClutterTextureQuality quality;
-
-      quality = clutter_texture_get_filter_quality(tex);
-      g_array_append_val(filters, quality);
-      clutter_texture_set_filter_quality(tex, GL_LINEAR);
-    }
-}
-
-/* Recursively set texture filtering state on this actor and children, and
- * save the old state in the object. */
-static void
-recursive_reset_texture_filter(ClutterActor *actor,
-                               const ClutterTextureQuality **filtersp)
-{
-  if (CLUTTER_IS_CONTAINER(actor))
-    clutter_container_foreach(CLUTTER_CONTAINER(actor),
-                        (ClutterCallback)recursive_reset_texture_filter,
-                        filtersp);
-  else if (CLUTTER_IS_TEXTURE(actor))
-    {
-      clutter_texture_set_filter_quality(CLUTTER_TEXTURE(actor),
-                                         **filtersp);
-      (*filtersp)++;
-    }
-}
-
 /* An implementation for the ClutterGroup::paint() vfunc,
    painting all the child actors: */
 static void
@@ -442,8 +416,6 @@ tidy_blur_group_paint (ClutterActor *actor)
   gint                         width, height, tex_width, tex_height;
   gboolean                     rotate_90;
   ClutterColor                 col;
-  GArray                      *filters;
-  const ClutterTextureQuality *filters_array;
 
   if (!TIDY_IS_SANE_BLUR_GROUP(actor))
     return;
@@ -457,7 +429,8 @@ tidy_blur_group_paint (ClutterActor *actor)
   if (!tidy_blur_group_source_buffered(actor) ||
       !tidy_blur_group_children_visible(group))
     {
-      /* set our buffer as damaged, so next time it gets re-created */
+      /* give our buffers back, next time they get re-created */
+      tidy_blur_group_release_textures(container);
       priv->current_blur_step = 0;
       priv->source_changed = TRUE;
       /* render direct */
@@ -481,6 +454,13 @@ tidy_blur_group_paint (ClutterActor *actor)
     }
 #endif
 
+  if (!priv->tex_width || !priv->tex_height)
+    { /* Not allocated yet. */
+      CLUTTER_ACTOR_CLASS(tidy_blur_group_parent_class)->paint(actor);
+      return;
+    }
+  tidy_blur_group_acquire_textures(container);
+
   tex_width  = cogl_texture_get_width(priv->tex_a);
   tex_height = cogl_texture_get_height(priv->tex_a);
 
@@ -519,12 +499,9 @@ tidy_blur_group_paint (ClutterActor *actor)
       cogl_color (&white);
       /* Actually do the drawing of the children, but ensure that they are
        * all linear sampled so they are smoothly interpolated. Restore after. */
-      filters = g_array_new(FALSE, FALSE, sizeof(ClutterTextureQuality));
-      recursive_set_linear_texture_filter(actor, filters);
+      tidy_util_push_linear_sampling();
       CLUTTER_ACTOR_CLASS(tidy_blur_group_parent_class)->paint(actor);
-      filters_array = (void *)filters->data;
-      recursive_reset_texture_filter(actor, &filters_array);
-      g_array_free(filters, TRUE);
+      tidy_util_pop_linear_sampling();
 
       tidy_util_cogl_pop_offscreen_buffer();
       cogl_pop_matrix();
@@ -849,20 +826,7 @@ tidy_blur_group_dispose (GObject *gobject)
   TidyBlurGroup *container = TIDY_BLUR_GROUP(gobject);
   TidyBlurGroupPrivate *priv = container->priv;
 
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
-  if (priv->fbo_b)
-    {
-      cogl_offscreen_unref(priv->fbo_b);
-      cogl_texture_unref(priv->tex_b);
-      priv->fbo_b = 0;
-      priv->tex_b = 0;
-    }
+  tidy_blur_group_release_textures(container);
   if (priv->tex_chequer)
     {
       cogl_texture_unref(priv->tex_chequer);
@@ -1140,6 +1104,8 @@ void tidy_blur_group_set_use_alpha(ClutterActor *blur_group, gboolean alpha)
 
   priv = TIDY_BLUR_GROUP(blur_group)->priv;
 
+  if (priv->use_alpha != alpha)
+    tidy_blur_group_release_textures(TIDY_BLUR_GROUP(blur_group));
   priv->use_alpha = alpha;
 }
 
@@ -4,8 +4,12 @@
  * it can use to speed up rendering, or to continue showing images of its'
  * children after they have been destroyed. */
 
+/* For glBlendFuncSeparate() on desktop GL. */
+#define GL_GLEXT_PROTOTYPES
+
 #include "tidy-cached-group.h"
 #include "tidy-util.h"
+#include "tidy-fbo-pool.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -22,7 +26,8 @@
 
 struct _TidyCachedGroupPrivate
 {
-  /* Internal TidyCachedGroup stuff */
+  /* Internal TidyCachedGroup stuff, taken from the pool while caching */
+  TidyFbo *buf;
   CoglHandle tex;
   CoglHandle fbo;
   /* When we rendered to this texture, did we render rotated? */
@@ -36,19 +41,40 @@ struct _TidyCachedGroupPrivate
   gboolean source_changed;
   /* how much quality loss you can afford when rendering cached texture */
   float downsample;
+
+  /* If not 0, changes to our children are picked up at most this often
+   * (in ms) while we're cached, see tidy_cached_group_hint_source_changed() */
+  guint refresh_interval;
+  guint refresh_timer;
 };
 
 G_DEFINE_TYPE (TidyCachedGroup,
                tidy_cached_group,
                CLUTTER_TYPE_GROUP);
 
+/* Return @priv->buf to the pool, with what we had cached. */
+static void
+tidy_cached_group_release_texture (TidyCachedGroup *self)
+{
+  TidyCachedGroupPrivate *priv = self->priv;
+
+  if (!priv->buf)
+    return;
+
+  tidy_fbo_pool_release(priv->buf);
+  priv->buf = NULL;
+  priv->tex = 0;
+  priv->fbo = 0;
+  priv->source_changed = TRUE;
+}
+
 /* An implementation for the ClutterGroup::paint() vfunc,
    painting all the child actors: */
 static void
 tidy_cached_group_paint (ClutterActor *actor)
 {
   ClutterColor    white = { 0xff, 0xff, 0xff, 0xff };
-  ClutterColor    bgcol = { 0x00, 0x00, 0x00, 0xff };
+  ClutterColor    bgcol = { 0x00, 0x00, 0x00, 0x00 };
   ClutterColor    col = { 0xff, 0xff, 0xff, 0xff };
   gint            x_1, y_1, x_2, y_2;
   gboolean        rotate_90;
@@ -71,6 +97,7 @@ tidy_cached_group_paint (ClutterActor *actor)
       width==0 || height==0)
     {
       /* render direct */
+      tidy_cached_group_release_texture(container);
       CLUTTER_ACTOR_CLASS (tidy_cached_group_parent_class)->paint(actor);
       return;
     }
@@ -94,31 +121,26 @@ tidy_cached_group_paint (ClutterActor *actor)
       tex_width = cogl_texture_get_width(priv->tex);
       tex_height = cogl_texture_get_height(priv->tex);
     }
-#if RESIZE_TEXTURE
-  /* free texture if the size is wrong */
-  if (tex_width!=exp_width || tex_height!=exp_height) {
-    if (priv->fbo)
-      {
-        cogl_offscreen_unref(priv->fbo);
-        cogl_texture_unref(priv->tex);
-        priv->fbo = 0;
-        priv->tex = 0;
-      }
-    priv->source_changed = TRUE;
-  }
-#endif
+  /* Give back the texture if the downsampling has changed.  The
+   * orientation doesn't matter, we can render rotated into it (see below). */
+  if (priv->tex
+      && (MAX(tex_width, tex_height) != MAX(exp_width, exp_height)
+          || MIN(tex_width, tex_height) != MIN(exp_width, exp_height)))
+    tidy_cached_group_release_texture(container);
   /* create the texture + offscreen buffer if they didn't exist. */
   if (!priv->tex)
     {
       tex_width = exp_width;
       tex_height = exp_height;
 
-      priv->tex = cogl_texture_new_with_size(
-                tex_width, tex_height, 0, FALSE /*mipmap*/,
-                priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
-                                  COGL_PIXEL_FORMAT_RGB_565);
-      cogl_texture_set_filters(priv->tex, CGL_NEAREST, CGL_NEAREST);
-      priv->fbo = cogl_offscreen_new_to_texture (priv->tex);
+      priv->buf = tidy_fbo_pool_acquire(tex_width, tex_height,
+                                        priv->use_alpha);
+      priv->tex = priv->buf->tex;
+      priv->fbo = priv->buf->fbo;
+      /* Smooth it out if we're going to be stretched. */
+      if (tex_width != width && tex_width != height)
+        cogl_texture_set_filters(priv->tex, CGL_LINEAR, CGL_LINEAR);
+      priv->source_changed = TRUE;
     }
   /* It may be that we have resized, but the texture has not.
    * If so, try and keep screen looking 'nice' by rotating so that
@@ -147,9 +169,17 @@ tidy_cached_group_paint (ClutterActor *actor)
         cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
       }
 
+      bgcol.alpha = priv->use_alpha ? 0x00 : 0xff;
       cogl_paint_init(&bgcol);
       cogl_color (&white);
+      /* Blending the alpha with SRC_ALPHA too would leave alpha squared
+       * in the image, blend it like the premultiplied colours instead. */
+      if (priv->use_alpha)
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
       CLUTTER_ACTOR_CLASS (tidy_cached_group_parent_class)->paint(actor);
+      if (priv->use_alpha)
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
       tidy_util_cogl_pop_offscreen_buffer();
       cogl_pop_matrix();
@@ -173,7 +203,13 @@ tidy_cached_group_paint (ClutterActor *actor)
       col.alpha = (int)(priv->cache_amount*255);
     }
 
-  /* Now we render the image we have... */
+  /* Now we render the image we have...  If it has alpha, the colours
+   * in it are already multiplied by it. */
+  if (priv->use_alpha)
+    {
+      col.red = col.green = col.blue = col.alpha;
+      cogl_blend_func(CGL_ONE, CGL_ONE_MINUS_SRC_ALPHA);
+    }
   cogl_color (&col);
 
   if (rotate_90)
@@ -193,21 +229,21 @@ tidy_cached_group_paint (ClutterActor *actor)
     {
       cogl_pop_matrix();
     }
+  if (priv->use_alpha)
+    cogl_blend_func(CGL_SRC_ALPHA, CGL_ONE_MINUS_SRC_ALPHA);
 }
 
 static void
 tidy_cached_group_dispose (GObject *gobject)
 {
   TidyCachedGroup *container = TIDY_CACHED_GROUP(gobject);
-  TidyCachedGroupPrivate *priv = container->priv;
 
-  if (priv->fbo)
+  if (container->priv->refresh_timer)
     {
-      cogl_offscreen_unref(priv->fbo);
-      cogl_texture_unref(priv->tex);
-      priv->fbo = 0;
-      priv->tex = 0;
+      g_source_remove(container->priv->refresh_timer);
+      container->priv->refresh_timer = 0;
     }
+  tidy_cached_group_release_texture(container);
 
   G_OBJECT_CLASS (tidy_cached_group_parent_class)->dispose (gobject);
 }
@@ -281,6 +317,9 @@ void tidy_cached_group_set_render_cache(ClutterActor *cached_group, float amount
   if (priv->cache_amount != amount)
     {
       priv->cache_amount = amount;
+      /* Don't hold onto the buffer if we may not be painted for a while. */
+      if (amount < 0.01)
+        tidy_cached_group_release_texture(TIDY_CACHED_GROUP(cached_group));
       if (CLUTTER_ACTOR_IS_VISIBLE(cached_group))
         clutter_actor_queue_redraw(cached_group);
     }
@@ -311,3 +350,69 @@ void tidy_cached_group_changed(ClutterActor *cached_group)
 }
 
 
+
+/* Whether to keep the alpha channel of the children in the cached image.
+ * If not, they're cached over black. */
+void tidy_cached_group_set_use_alpha(ClutterActor *cached_group,
+                                     gboolean use_alpha)
+{
+  TidyCachedGroupPrivate *priv;
+
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  if (priv->use_alpha == use_alpha)
+    return;
+
+  /* The pool has different buffers for the two. */
+  tidy_cached_group_release_texture(TIDY_CACHED_GROUP(cached_group));
+  priv->use_alpha = use_alpha;
+}
+
+/* Sets how often (in ms) tidy_cached_group_hint_source_changed() may
+ * cause the cached image to be updated.  0 means never, which is the
+ * default: the image only changes when tidy_cached_group_changed() is
+ * called. */
+void tidy_cached_group_set_refresh_interval(ClutterActor *cached_group,
+                                            guint interval)
+{
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+  TIDY_CACHED_GROUP(cached_group)->priv->refresh_interval = interval;
+}
+
+static gboolean
+tidy_cached_group_refresh_cb(gpointer data)
+{
+  TidyCachedGroup *container = TIDY_CACHED_GROUP(data);
+
+  container->priv->refresh_timer = 0;
+  container->priv->source_changed = TRUE;
+  if (CLUTTER_ACTOR_IS_VISIBLE(container))
+    clutter_actor_queue_redraw(CLUTTER_ACTOR(container));
+  return FALSE;
+}
+
+/**
+ * Notifies the group that one of its children has changed.  Returns
+ * whether the group is showing its cached image and will update it by
+ * itself later, in which case there's no need to redraw now.
+ */
+gboolean tidy_cached_group_hint_source_changed(ClutterActor *cached_group)
+{
+  TidyCachedGroupPrivate *priv;
+
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return FALSE;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  if (!priv->refresh_interval || priv->cache_amount < 0.99 || !priv->tex)
+    return FALSE;
+
+  if (!priv->refresh_timer)
+    priv->refresh_timer = g_timeout_add(priv->refresh_interval,
+                                        tidy_cached_group_refresh_cb,
+                                        cached_group);
+  return TRUE;
+}
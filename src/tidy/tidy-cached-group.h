@@ -38,6 +38,11 @@ void tidy_cached_group_set_render_cache(ClutterActor *cached_group, float amount
 void tidy_cached_group_set_downsampling_factor(ClutterActor *cached_group,
                                                float downsample);
 void tidy_cached_group_changed(ClutterActor *cached_group);
+void tidy_cached_group_set_use_alpha(ClutterActor *cached_group,
+                                     gboolean use_alpha);
+void tidy_cached_group_set_refresh_interval(ClutterActor *cached_group,
+                                            guint interval);
+gboolean tidy_cached_group_hint_source_changed(ClutterActor *cached_group);
 
 
 G_END_DECLS
@@ -9,6 +9,7 @@
 
 #include "tidy-desaturation-group.h"
 #include "tidy-util.h"
+#include "tidy-fbo-pool.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -89,6 +90,9 @@ struct _TidyDesaturationGroupPrivate
 {
   /* Internal TidyDesaturationGroup stuff */
   ClutterShader *shader_saturate;
+  /* Taken from the pool only while we're buffering. */
+  TidyFbo *buf_a;
+  guint tex_width, tex_height;
   CoglHandle tex_a;
   CoglHandle fbo_a;
 
@@ -174,36 +178,53 @@ static void tidy_desaturation_group_check_shader(TidyDesaturationGroup *group,
    }
 }
 
+/* Return @priv->buf_a to the pool. */
 static void
-tidy_desaturation_group_allocate_textures (TidyDesaturationGroup *self)
+tidy_desaturation_group_release_textures (TidyDesaturationGroup *self)
 {
   TidyDesaturationGroupPrivate *priv = self->priv;
-  guint tex_width, tex_height;
 
-#ifdef __i386__
-  if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
-    /* Don't try to allocate FBOs. */
+  if (!priv->buf_a)
     return;
-#endif
 
-  /* Free the texture. */
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
+  tidy_fbo_pool_release(priv->buf_a);
+  priv->buf_a = NULL;
+  priv->tex_a = priv->fbo_a = 0;
+  priv->current_desaturation_step = 0;
+  priv->source_changed = TRUE;
+}
 
-  /* (Re)create the texture and offscreen buffer.
-   * We can specify mipmapping here, but we don't need it. */
-  clutter_actor_get_size(CLUTTER_ACTOR(self), &tex_width, &tex_height);
+/* Get @priv->buf_a from the pool if we don't have it. */
+static void
+tidy_desaturation_group_acquire_textures (TidyDesaturationGroup *self)
+{
+  TidyDesaturationGroupPrivate *priv = self->priv;
 
-  priv->tex_a = cogl_texture_new_with_size(
-            tex_width, tex_height, 0, FALSE /* mipmap */,
-            COGL_PIXEL_FORMAT_RGBA_8888);
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_a = cogl_offscreen_new_to_texture(priv->tex_a);
+  if (priv->buf_a)
+    return;
+
+  priv->buf_a = tidy_fbo_pool_acquire(priv->tex_width, priv->tex_height,
+                                      TRUE);
+  priv->tex_a = priv->buf_a->tex;
+  priv->fbo_a = priv->buf_a->fbo;
+  priv->current_desaturation_step = 0;
+  priv->source_changed = TRUE;
+}
+
+/* Work out the size of @priv->fbo_a. */
+static void
+tidy_desaturation_group_allocate_textures (TidyDesaturationGroup *self)
+{
+  TidyDesaturationGroupPrivate *priv = self->priv;
+  guint tex_width, tex_height;
+
+  clutter_actor_get_size(CLUTTER_ACTOR(self), &tex_width, &tex_height);
+  if (tex_width != priv->tex_width || tex_height != priv->tex_height)
+    {
+      priv->tex_width  = tex_width;
+      priv->tex_height = tex_height;
+      tidy_desaturation_group_release_textures(self);
+    }
 
   priv->current_desaturation_step = 0;
   priv->source_changed = TRUE;
@@ -232,44 +253,6 @@ tidy_desaturation_group_children_visible(ClutterGroup *group)
   return FALSE;
 }
 
-/* Recursively set texture filtering state on this actor and children, and
- * save the old state in the object. */
-static void
-recursive_set_linear_texture_filter(ClutterActor *actor, GArray *filters)
-{
-  if (CLUTTER_IS_CONTAINER(actor))
-    clutter_container_foreach(CLUTTER_CONTAINER(actor),
-                   (ClutterCallback)recursive_set_linear_texture_filter,
-                   filters);
-  else if (CLUTTER_IS_TEXTURE(actor))
-    {
-      ClutterTexture *tex = CLUTTER_TEXTURE(actor);
-      ClutterTextureQuality quality;
-
-      quality = clutter_texture_get_filter_quality(tex);
-      g_array_append_val(filters, quality);
-      clutter_texture_set_filter_quality(tex, GL_LINEAR);
-    }
-}
-
-/* Recursively set texture filtering state on this actor and children, and
- * save the old state in the object. */
-static void
-recursive_reset_texture_filter(ClutterActor *actor,
-                               const ClutterTextureQuality **filtersp)
-{
-  if (CLUTTER_IS_CONTAINER(actor))
-    clutter_container_foreach(CLUTTER_CONTAINER(actor),
-                        (ClutterCallback)recursive_reset_texture_filter,
-                        filtersp);
-  else if (CLUTTER_IS_TEXTURE(actor))
-    {
-      clutter_texture_set_filter_quality(CLUTTER_TEXTURE(actor),
-                                         **filtersp);
-      (*filtersp)++;
-    }
-}
-
 static void
 tidy_desaturation_group_paint (ClutterActor *actor)
 {
@@ -281,8 +264,6 @@ tidy_desaturation_group_paint (ClutterActor *actor)
   ClutterActorBox              box;
   gint                         width, height, tex_width, tex_height;
   ClutterColor                 col;
-  GArray                      *filters;
-  const ClutterTextureQuality *filters_array;
 
   if (!TIDY_IS_SANE_DESATURATION_GROUP(actor))
     return;
@@ -296,7 +277,8 @@ tidy_desaturation_group_paint (ClutterActor *actor)
   if (!tidy_desaturation_group_source_buffered(actor) ||
       !tidy_desaturation_group_children_visible(group))
     {
-      /* set our buffer as damaged, so next time it gets re-created */
+      /* give our buffer back, next time it gets re-created */
+      tidy_desaturation_group_release_textures(container);
       priv->current_desaturation_step = 0;
       priv->source_changed = TRUE;
       CLUTTER_ACTOR_CLASS(tidy_desaturation_group_parent_class)->paint(actor);
@@ -308,6 +290,13 @@ tidy_desaturation_group_paint (ClutterActor *actor)
       return;
 #endif
 
+  if (!priv->tex_width || !priv->tex_height)
+    { /* Not allocated yet. */
+      CLUTTER_ACTOR_CLASS(tidy_desaturation_group_parent_class)->paint(actor);
+      return;
+    }
+  tidy_desaturation_group_acquire_textures(container);
+
   tex_width  = cogl_texture_get_width(priv->tex_a);
   tex_height = cogl_texture_get_height(priv->tex_a);
 
@@ -323,12 +312,9 @@ tidy_desaturation_group_paint (ClutterActor *actor)
       cogl_color (&white);
       /* Actually do the drawing of the children, but ensure that they are
        * all linear sampled so they are smoothly interpolated. Restore after. */
-      filters = g_array_new(FALSE, FALSE, sizeof(ClutterTextureQuality));
-      recursive_set_linear_texture_filter(actor, filters);
+      tidy_util_push_linear_sampling();
       CLUTTER_ACTOR_CLASS(tidy_desaturation_group_parent_class)->paint(actor);
-      filters_array = (void *)filters->data;
-      recursive_reset_texture_filter(actor, &filters_array);
-      g_array_free(filters, TRUE);
+      tidy_util_pop_linear_sampling();
 
       tidy_util_cogl_pop_offscreen_buffer();
       cogl_pop_matrix();
@@ -386,15 +372,8 @@ static void
 tidy_desaturation_group_dispose (GObject *gobject)
 {
   TidyDesaturationGroup *container = TIDY_DESATURATION_GROUP(gobject);
-  TidyDesaturationGroupPrivate *priv = container->priv;
 
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
+  tidy_desaturation_group_release_textures(container);
 
   G_OBJECT_CLASS (tidy_desaturation_group_parent_class)->dispose (gobject);
 }
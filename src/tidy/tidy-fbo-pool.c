@@ -0,0 +1,144 @@
+#include "tidy-fbo-pool.h"
+
+/* The pool keeps the buffers nobody is rendering into for a while in case
+ * some group wants one of the same size again, which is the common case:
+ * the blur group and the task switcher thumbnails are rarely busy at the
+ * same time, and neither is the rotation snapshot.  Buffers idle for more
+ * than IDLE_TIMEOUT seconds are freed.
+ *
+ * Buffers are told apart by size and by whether they have alpha (RGBA 8888)
+ * or not (RGB 565). */
+/* ------------------------------------------------ */
+#define IDLE_TIMEOUT  10
+
+/* Idle buffers, most recently released first. */
+static GList *idle_buffers;
+static guint trim_timer;
+
+/* For tidy_fbo_pool_dump() */
+static gsize bytes_in_use, bytes_idle, bytes_peak;
+static guint nallocated, nreused;
+/* ------------------------------------------------ */
+
+static gsize
+tidy_fbo_size (const TidyFbo *buf)
+{
+  return buf->width * buf->height * (buf->use_alpha ? 4 : 2);
+}
+
+static void
+tidy_fbo_free (TidyFbo *buf)
+{
+  cogl_offscreen_unref (buf->fbo);
+  cogl_texture_unref (buf->tex);
+  g_slice_free (TidyFbo, buf);
+}
+
+/* Returns an offscreen buffer of the given size, whose contents are
+ * undefined.  Its filters are CGL_NEAREST. */
+TidyFbo *
+tidy_fbo_pool_acquire (guint width, guint height, gboolean use_alpha)
+{
+  TidyFbo *buf;
+  GList *li;
+
+  for (li = idle_buffers; li; li = li->next)
+    {
+      buf = li->data;
+      if (buf->width == width && buf->height == height
+          && buf->use_alpha == use_alpha)
+        {
+          idle_buffers = g_list_delete_link (idle_buffers, li);
+          bytes_idle   -= tidy_fbo_size (buf);
+          bytes_in_use += tidy_fbo_size (buf);
+          nreused++;
+          return buf;
+        }
+    }
+
+  /* We can specify mipmapping here, but we don't need it. */
+  buf = g_slice_new0 (TidyFbo);
+  buf->width = width;
+  buf->height = height;
+  buf->use_alpha = use_alpha;
+  buf->tex = cogl_texture_new_with_size (width, height, 0, FALSE /* mipmap */,
+                                         use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888
+                                                   : COGL_PIXEL_FORMAT_RGB_565);
+  cogl_texture_set_filters (buf->tex, CGL_NEAREST, CGL_NEAREST);
+  buf->fbo = cogl_offscreen_new_to_texture (buf->tex);
+
+  bytes_in_use += tidy_fbo_size (buf);
+  if (bytes_peak < bytes_in_use + bytes_idle)
+    bytes_peak = bytes_in_use + bytes_idle;
+  nallocated++;
+
+  return buf;
+}
+
+static gboolean
+tidy_fbo_pool_trim_cb (gpointer unused)
+{
+  tidy_fbo_pool_trim (FALSE);
+  if (idle_buffers)
+    return TRUE;
+
+  trim_timer = 0;
+  return FALSE;
+}
+
+/* Gives @buf back to the pool. */
+void
+tidy_fbo_pool_release (TidyFbo *buf)
+{
+  if (!buf)
+    return;
+
+  cogl_texture_set_filters (buf->tex, CGL_NEAREST, CGL_NEAREST);
+  g_get_current_time (&buf->released);
+  idle_buffers  = g_list_prepend (idle_buffers, buf);
+  bytes_in_use -= tidy_fbo_size (buf);
+  bytes_idle   += tidy_fbo_size (buf);
+
+  if (!trim_timer)
+    trim_timer = g_timeout_add_seconds (IDLE_TIMEOUT,
+                                        tidy_fbo_pool_trim_cb, NULL);
+}
+
+/* Frees the buffers which have been idle for long, or all of them. */
+void
+tidy_fbo_pool_trim (gboolean all)
+{
+  GTimeVal now;
+  GList *li, *next;
+
+  g_get_current_time (&now);
+  for (li = idle_buffers; li; li = next)
+    {
+      TidyFbo *buf = li->data;
+
+      next = li->next;
+      if (!all && now.tv_sec - buf->released.tv_sec < IDLE_TIMEOUT)
+        continue;
+
+      idle_buffers = g_list_delete_link (idle_buffers, li);
+      bytes_idle  -= tidy_fbo_size (buf);
+      tidy_fbo_free (buf);
+    }
+}
+
+void
+tidy_fbo_pool_dump (void)
+{
+  GList *li;
+
+  g_debug ("offscreen buffers: %" G_GSIZE_FORMAT " kB in use, "
+           "%" G_GSIZE_FORMAT " kB idle, %" G_GSIZE_FORMAT " kB at most",
+           bytes_in_use / 1024, bytes_idle / 1024, bytes_peak / 1024);
+  g_debug ("  %u allocated, %u reused", nallocated, nreused);
+  for (li = idle_buffers; li; li = li->next)
+    {
+      TidyFbo *buf = li->data;
+      g_debug ("  idle: %ux%u%s", buf->width, buf->height,
+               buf->use_alpha ? " alpha" : "");
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef _TIDY_FBO_POOL
+#define _TIDY_FBO_POOL
+
+#include <clutter/clutter.h>
+
+/* Offscreen render targets shared by the effect groups.  A group takes
+ * one when it starts rendering through it and gives it back when it goes
+ * back to rendering directly; what's in a buffer is lost then. */
+typedef struct _TidyFbo TidyFbo;
+
+struct _TidyFbo
+{
+  CoglHandle tex;
+  CoglHandle fbo;
+  guint      width, height;
+  gboolean   use_alpha;
+
+  /*< private >*/
+  GTimeVal   released;
+};
+
+TidyFbo *tidy_fbo_pool_acquire (guint width, guint height, gboolean use_alpha);
+void     tidy_fbo_pool_release (TidyFbo *buf);
+void     tidy_fbo_pool_trim    (gboolean all);
+void     tidy_fbo_pool_dump    (void);
+
+#endif
@@ -26,6 +26,7 @@
 
 #include "tidy-finger-scroll.h"
 #include "tidy-enum-types.h"
+#include "tidy-kinetic.h"
 #include "tidy-marshal.h"
 #include "tidy-scroll-bar.h"
 #include "tidy-scrollable.h"
@@ -66,9 +67,8 @@ struct _TidyFingerScrollPrivate
 
   /* Variables for storing acceleration information for kinetic mode */
   ClutterTimeline       *deceleration_timeline;
-  int                    deceleration_timeline_lastframe;
-  ClutterUnit            dx;
-  ClutterUnit            dy;
+  GTimeVal               deceleration_start;
+  TidyKinetic            hkinetic, vkinetic;
   ClutterFixed           decel_rate;
   ClutterFixed           bouncing_decel_rate;
   ClutterFixed           bounce_back_speed_rate;
@@ -359,98 +359,23 @@ deceleration_completed_cb (ClutterTimeline *timeline,
   scroll->priv->deceleration_timeline = NULL;
 }
 
-/*
- * Returns the next priv->dx or dy.  If we're scrolling normally
- * (lower <= value <= upper) it's decelerated by decel_rate.
- * If we're in the danger zone (below lower or above upper)
- * it's decelerated by bouncing_decel_rate.  If we're boucing back
- * (we hit lowest or highest or we stopped in the danger zone)
- * We return the initial bouncing speed, which is based on how
- * far we are in the danger zone (the distance from lower/upper).
- */
-static ClutterFixed
-get_next_delta (TidyFingerScroll *scroll,
-                ClutterFixed lowest, ClutterFixed lower,
-                ClutterFixed value, ClutterFixed prevdiff,
-                ClutterFixed upper, ClutterFixed highest)
-{
-  TidyFingerScrollPrivate *priv = scroll->priv;
-  ClutterFixed decel_rate, nextdiff;
-  gboolean in_upper_danger_zone, in_lower_danger_zone;
-
-  in_lower_danger_zone = value < lower;
-  in_upper_danger_zone = value > upper;
-  decel_rate = in_lower_danger_zone || in_upper_danger_zone
-    ? priv->bouncing_decel_rate : priv->decel_rate;
-  nextdiff = clutter_qmulx (prevdiff, decel_rate);
-  if (prevdiff && decel_rate && prevdiff == nextdiff)
-    /* Arithmetic underflow. */
-    nextdiff = prevdiff < 0 ? -CFX_ONE : CFX_ONE;
-
-  if (in_lower_danger_zone)
-    {
-      if (value+nextdiff <= lowest || (-CFX_ONE < nextdiff && nextdiff <= 0))
-        {
-          nextdiff = clutter_qmulx(lower-value, priv->bounce_back_speed_rate);
-          if (!nextdiff)
-            nextdiff = CFX_ONE;
-        }
-    }
-  else if (in_upper_danger_zone)
-    {
-      if (value+nextdiff >= highest || (0 <= nextdiff && nextdiff < CFX_ONE))
-        {
-          nextdiff = clutter_qmulx(upper-value, priv->bounce_back_speed_rate);
-          if (!nextdiff)
-            nextdiff = -CFX_ONE;
-        }
-    }
-
-  return nextdiff;
-}
-
-/* Advances *@valuep by @diff and returns how much it actually advanced. */
-static ClutterFixed
-advance_value (ClutterFixed lowest, ClutterFixed lower,
-               ClutterFixed *valuep, ClutterFixed diff,
-               ClutterFixed upper, ClutterFixed highest)
+/* Microseconds from @since to now. */
+static gdouble
+elapsed_since (const GTimeVal *since)
 {
-  static const gboolean likeable = FALSE;
+  GTimeVal now;
 
-  *valuep += diff;
-  if (!likeable)
-    {
-      if (*valuep < lowest)
-        { /* Bounce back from the top. */
-          diff -= *valuep - lowest;
-          *valuep = lowest;
-        }
-      else if (*valuep < lower && 0 < diff && diff < CFX_ONE)
-        { /* Leaving the top danger zone, snap it to the boundary. */
-          diff = 0;
-          *valuep = lower;
-        }
-      else if (*valuep > upper && -CFX_ONE < diff && diff < 0)
-        { /* Same for the bottom danger zone. */
-          diff = 0;
-          *valuep = upper;
-        }
-      else if (*valuep > highest)
-        { /* Bounce back from the bottom. */
-          diff -= *valuep - highest;
-          *valuep = highest;
-        }
-    }
-  return diff;
+  g_get_current_time (&now);
+  return (now.tv_sec - since->tv_sec) * (gdouble)G_USEC_PER_SEC
+    + (now.tv_usec - since->tv_usec);
 }
 
 /*
  * Callback of an indefinite timeline which scrolls @child.
- * When we began scrolling in button_release_event_cb() its
- * length is calculated so that it finishes when our speed
- * drops under 1px/frame under normal scrolling conditions.
- * However, this doesn't account for bouncing, so we decide
- * when to stop eventually, and extend our lifetime if necessary.
+ * Where we are is a function of the time since we started
+ * in button_release_event_cb(), so it doesn't matter how many
+ * frames were skipped or how late this one is.  We stop when
+ * neither axis moves anymore, and extend our lifetime until then.
  */
 static void
 deceleration_new_frame_cb (ClutterTimeline *timeline,
@@ -460,54 +385,76 @@ deceleration_new_frame_cb (ClutterTimeline *timeline,
   TidyFingerScrollPrivate *priv = scroll->priv;
   ClutterActor *child;
   TidyAdjustment *hadjust, *vadjust;
-  ClutterFixed hvalue, hlowest, hlower, hpage, hupper, hhighest;
-  ClutterFixed vvalue, vlowest, vlower, vpage, vupper, vhighest;
+  gdouble t, hvalue, vvalue;
+  gboolean moving;
 
   if (!(child = tidy_scroll_view_get_child (TIDY_SCROLL_VIEW(scroll))))
     return;
   tidy_scrollable_get_adjustments (TIDY_SCROLLABLE (child),
                                    &hadjust, &vadjust);
 
-  tidy_adjustment_get_skirtx (hadjust, &hlowest, &hhighest);
-  tidy_adjustment_get_valuesx (hadjust, &hvalue, &hlower, &hupper,
-                               NULL, NULL, &hpage);
-  hupper -= hpage;
+  /* TidyKinetic counts time in 1/60 s. */
+  t = elapsed_since (&priv->deceleration_start) * 60 / G_USEC_PER_SEC;
+  moving  = tidy_kinetic_get_value (&priv->hkinetic, t, &hvalue);
+  moving |= tidy_kinetic_get_value (&priv->vkinetic, t, &vvalue);
+  tidy_adjustment_set_value (hadjust, hvalue);
+  tidy_adjustment_set_value (vadjust, vvalue);
 
-  tidy_adjustment_get_skirtx (vadjust, &vlowest, &vhighest);
-  tidy_adjustment_get_valuesx (vadjust, &vvalue, &vlower, &vupper,
-                               NULL, NULL, &vpage);
-  vupper -= vpage;
-
-  /* We need to keep track of how many frames were skipped so we can
-   * make up for it... */
-  for (; priv->deceleration_timeline_lastframe < frame_num;
-       priv->deceleration_timeline_lastframe++)
-    {
-      priv->dx = advance_value (
-                  hlowest, hlower, &hvalue, priv->dx, hupper, hhighest);
-      priv->dx = get_next_delta (scroll,
-                   hlowest, hlower, hvalue, priv->dx, hupper, hhighest);
-      priv->dy = advance_value (
-                  vlowest, vlower, &vvalue, priv->dy, vupper, vhighest);
-      priv->dy = get_next_delta (scroll,
-                   vlowest, vlower, vvalue, priv->dy, vupper, vhighest);
-    }
-  tidy_adjustment_set_valuex (hadjust, hvalue);
-  tidy_adjustment_set_valuex (vadjust, vvalue);
-
-  /* Stop the timeline if we don't move anymore,
-   * or extend it if we're running out of frames. */
-  if (   vlower <= vvalue && vvalue <= vupper
-      && -CFX_ONE < priv->dy && priv->dy < CFX_ONE
-      && hlower <= hvalue && hvalue <= hupper
-      && -CFX_ONE < priv->dx && priv->dx < CFX_ONE)
-    /* Not in danger zone and not moving. */
+  if (!moving)
     deceleration_completed_cb (timeline, scroll);
   else if (clutter_timeline_get_n_frames (timeline) < frame_num+60)
     /* Extend our lifetime. */
     clutter_timeline_set_n_frames (timeline, frame_num+60);
 }
 
+/* Prepares @kinetic to scroll @adjust, but doesn't start it. */
+static void
+setup_kinetic (TidyFingerScroll *scroll, TidyKinetic *kinetic,
+               TidyAdjustment *adjust)
+{
+  TidyFingerScrollPrivate *priv = scroll->priv;
+  ClutterFixed lowest, highest;
+  gdouble lower, upper, page;
+
+  kinetic->decel_rate = CLUTTER_FIXED_TO_FLOAT (priv->decel_rate);
+  kinetic->bouncing_decel_rate =
+    CLUTTER_FIXED_TO_FLOAT (priv->bouncing_decel_rate);
+  kinetic->bounce_back_rate =
+    CLUTTER_FIXED_TO_FLOAT (priv->bounce_back_speed_rate);
+
+  tidy_adjustment_get_values (adjust, NULL, &lower, &upper,
+                              NULL, NULL, &page);
+  tidy_adjustment_get_skirtx (adjust, &lowest, &highest);
+  kinetic->lower = lower;
+  kinetic->upper = upper - page;
+  kinetic->lowest = CLUTTER_FIXED_TO_FLOAT (lowest);
+  kinetic->highest = CLUTTER_FIXED_TO_FLOAT (highest);
+}
+
+/* Starts @kinetic from the current value of @adjust with @speed,
+ * or with something close to it which makes us stop on a step
+ * boundary. */
+static void
+start_kinetic (TidyKinetic *kinetic, TidyAdjustment *adjust,
+               gdouble speed)
+{
+  gdouble value, lower, step_increment, d;
+
+  tidy_adjustment_get_values (adjust, &value, &lower, NULL,
+                              &step_increment, NULL, NULL);
+  if (step_increment > 0)
+    {
+      /* Find how far we'd go, find its nearest step boundary,
+       * then solve for the speed. */
+      d = tidy_kinetic_get_distance (kinetic, speed);
+      d = ((rint (((value + d) - lower) / step_increment) *
+            step_increment) + lower) - value;
+      speed = tidy_kinetic_get_speed (kinetic, d);
+    }
+
+  tidy_kinetic_start (kinetic, value, speed);
+}
+
 /*
  * Figure out the initial speed when we start decelerating.  @diff is
  * the initial estimate which this function may override if the dhild
@@ -579,7 +526,7 @@ button_release_event_cb (ClutterActor *actor,
                                                CLUTTER_UNITS_FROM_DEVICE(event->y),
                                                &x, &y))
         {
-          ClutterUnit frac, x_origin, y_origin;
+          ClutterUnit frac, x_origin, y_origin, dx, dy;
           GTimeVal release_time, motion_time;
           TidyAdjustment *hadjust, *vadjust;
           glong time_diff;
@@ -626,10 +573,10 @@ button_release_event_cb (ClutterActor *actor,
                                 CLUTTER_FLOAT_TO_FIXED (1000.0/60.0));
 
           /* See how many units to move in 1/60th of a second */
-          priv->dx = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
-                     CLUTTER_UNITS_TO_FIXED(x_origin - x), frac));
-          priv->dy = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
-                     CLUTTER_UNITS_TO_FIXED(y_origin - y), frac));
+          dx = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
+               CLUTTER_UNITS_TO_FIXED(x_origin - x), frac));
+          dy = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
+               CLUTTER_UNITS_TO_FIXED(y_origin - y), frac));
 
           /* Get adjustments to do step-increment snapping */
           tidy_scrollable_get_adjustments (TIDY_SCROLLABLE (child),
@@ -637,104 +584,33 @@ button_release_event_cb (ClutterActor *actor,
                                            &vadjust);
 
           /* Possibly adjust the initial speed if we're overdragged. */
-          priv->dx = initial_speed (scroll, hadjust, priv->dx);
-          priv->dy = initial_speed (scroll, vadjust, priv->dy);
-
-          if (ABS(CLUTTER_UNITS_TO_INT(priv->dx)) > 1 ||
-              ABS(CLUTTER_UNITS_TO_INT(priv->dy)) > 1)
-            {
-              gdouble value, lower, step_increment, d, a, x, y, n;
-
-              /* TODO: Convert this all to fixed point? */
-
-              /* We want n, where x / y^n < z,
-               * x = Distance to move per frame
-               * y = Deceleration rate
-               * z = maximum distance from target
-               *
-               * Rearrange to n = log (x / z) / log (y)
-               * To simplify, z = 1, so n = log (x) / log (y)
-               *
-               * As z = 1, this will cause stops to be slightly abrupt -
-               * add a constant 15 frames to compensate.
-               */
-              x = CLUTTER_FIXED_TO_FLOAT (MAX(ABS(priv->dx), ABS(priv->dy)));
-              y = CLUTTER_FIXED_TO_FLOAT (priv->decel_rate);
-              n = logf (x) * logf (y) + 15.0;
-
-              /* Now we have n, adjust dx/dy so that we finish on a step
-               * boundary.
-               *
-               * Distance moved, using the above variable names:
-               *
-               * d = x + x/y + x/y^2 + ... + x/y^n
-               *
-               * Using geometric series,
-               *
-               * d = (1 - 1/y^(n+1))/(1 - 1/y)*x
-               *
-               * Let a = (1 - 1/y^(n+1))/(1 - 1/y),
-               *
-               * d = a * x
-               *
-               * Find d and find its nearest page boundary, then solve for x
-               *
-               * x = d / a
-               */
-
-              /* Get adjustments, work out y^n */
-              a = (1.0 - pow (y, n + 1)) / (1.0 - y);
-
-              /* Solving for dx */
-              d = a * CLUTTER_UNITS_TO_FLOAT (priv->dx);
-              tidy_adjustment_get_values (hadjust, &value, &lower, NULL,
-                                          &step_increment, NULL, NULL);
-              d = ((rint (((value + d) - lower) / step_increment) *
-                    step_increment) + lower) - value;
-              priv->dx = CLUTTER_UNITS_FROM_FLOAT (d / a);
-
-              /* Solving for dy */
-              d = a * CLUTTER_UNITS_TO_FLOAT (priv->dy);
-              tidy_adjustment_get_values (vadjust, &value, &lower, NULL,
-                                          &step_increment, NULL, NULL);
-              d = ((rint (((value + d) - lower) / step_increment) *
-                    step_increment) + lower) - value;
-              priv->dy = CLUTTER_UNITS_FROM_FLOAT (d / a);
-
-              priv->deceleration_timeline = clutter_timeline_new ((gint)n, 60);
-            }
-          else
-            {
-              gdouble value, lower, step_increment, d, a, y;
-
-              /* Start a short effects timeline to snap to the nearest step
-               * boundary (see equations above)
-               */
-              y = CLUTTER_FIXED_TO_FLOAT (priv->decel_rate);
-              a = (1.0 - pow (y, 4 + 1)) / (1.0 - y);
-
-              tidy_adjustment_get_values (hadjust, &value, &lower, NULL,
-                                          &step_increment, NULL, NULL);
-              d = ((rint ((value - lower) / step_increment) *
-                    step_increment) + lower) - value;
-              priv->dx = CLUTTER_UNITS_FROM_FLOAT (d / a);
-
-              tidy_adjustment_get_values (vadjust, &value, &lower, NULL,
-                                          &step_increment, NULL, NULL);
-              d = ((rint ((value - lower) / step_increment) *
-                    step_increment) + lower) - value;
-              priv->dy = CLUTTER_UNITS_FROM_FLOAT (d / a);
-
-              priv->deceleration_timeline = clutter_timeline_new (4, 60);
-            }
-
+          dx = initial_speed (scroll, hadjust, dx);
+          dy = initial_speed (scroll, vadjust, dy);
+
+          /* If we're hardly moving, this just snaps to the nearest
+           * step boundary. */
+          if (ABS(CLUTTER_UNITS_TO_INT(dx)) <= 1 &&
+              ABS(CLUTTER_UNITS_TO_INT(dy)) <= 1)
+            dx = dy = 0;
+
+          setup_kinetic (scroll, &priv->hkinetic, hadjust);
+          setup_kinetic (scroll, &priv->vkinetic, vadjust);
+          start_kinetic (&priv->hkinetic, hadjust,
+                         CLUTTER_UNITS_TO_FLOAT (dx));
+          start_kinetic (&priv->vkinetic, vadjust,
+                         CLUTTER_UNITS_TO_FLOAT (dy));
+
+          /* The timeline only wakes us up for every frame, its length
+           * is extended in deceleration_new_frame_cb() as long as
+           * we're moving. */
+          priv->deceleration_start = release_time;
+          priv->deceleration_timeline = clutter_timeline_new (60, 60);
           g_signal_connect (priv->deceleration_timeline, "new_frame",
                             G_CALLBACK (deceleration_new_frame_cb), scroll);
           g_signal_connect (priv->deceleration_timeline, "completed",
                             G_CALLBACK (deceleration_completed_cb), scroll);
           clutter_timeline_start (priv->deceleration_timeline);
           /* force redraw of first frame */
-          priv->deceleration_timeline_lastframe = -1;
           deceleration_new_frame_cb(priv->deceleration_timeline, 0, scroll);
           decelerating = TRUE;
         }
@@ -0,0 +1,228 @@
+#include <math.h>
+
+#include "tidy-kinetic.h"
+
+/* Free scrolling stops when it has less than this much to go. */
+#define REST_DISTANCE   0.5
+
+/* Bouncing stops when slower than this, like it always has. */
+#define MIN_BOUNCE_SPEED 1.0
+
+/* Time until something never happening. */
+#define NEVER           G_MAXDOUBLE
+
+/* Keeps pow() and log() sane. */
+static gdouble
+clamp_rate (gdouble rate)
+{
+  return CLAMP (rate, 0.001, 0.999999);
+}
+
+static gdouble
+rate_of (const TidyKinetic *kinetic, TidyKineticPhase phase)
+{
+  return clamp_rate (phase == TIDY_KINETIC_FREE
+                     ? kinetic->decel_rate : kinetic->bouncing_decel_rate);
+}
+
+/*
+ * Moving from @x0 with @v0 for @tau, decaying by @r, we get to
+ *
+ *   x = x0 + v0 + v0*r + v0*r^2 + ... = x0 + v0 * (1 - r^tau) / (1 - r)
+ *
+ * with the speed v0 * r^tau, which is what stepping frame by frame
+ * gives for integer @tau.
+ */
+static gdouble
+position_at (gdouble x0, gdouble v0, gdouble r, gdouble tau)
+{
+  return x0 + v0 * (1 - pow (r, tau)) / (1 - r);
+}
+
+static gdouble
+speed_at (gdouble v0, gdouble r, gdouble tau)
+{
+  return v0 * pow (r, tau);
+}
+
+/* When do we get from @x0 to @x with @v0? */
+static gdouble
+time_to_reach (gdouble x0, gdouble v0, gdouble r, gdouble x)
+{
+  gdouble s;
+
+  if (x == x0)
+    return 0;
+  if (v0 == 0)
+    return NEVER;
+
+  /* Solve position_at() for tau. */
+  s = (x - x0) * (1 - r) / v0;
+  if (s < 0 || s >= 1)
+    /* Wrong direction or not fast enough. */
+    return NEVER;
+  return log (1 - s) / log (r);
+}
+
+/* When do we slow down from @v0 to @v? */
+static gdouble
+time_to_slow (gdouble v0, gdouble r, gdouble v)
+{
+  return fabs (v0) <= v ? 0 : log (v / fabs (v0)) / log (r);
+}
+
+/* The edge we're beyond, or the one we're heading to. */
+static gdouble
+edge_of (const TidyKinetic *kinetic, gdouble x, gdouble v)
+{
+  if (x < kinetic->lower)
+    return kinetic->lower;
+  if (x > kinetic->upper)
+    return kinetic->upper;
+  return v < 0 ? kinetic->lower : kinetic->upper;
+}
+
+/* The edge to bounce back to from @x. */
+static gdouble
+nearest_edge (const TidyKinetic *kinetic, gdouble x)
+{
+  return x - kinetic->lower <= kinetic->upper - x
+    ? kinetic->lower : kinetic->upper;
+}
+
+/* Begins @phase at @t from @x with @v, and works out when and how
+ * it ends. */
+static void
+enter (TidyKinetic *kinetic, TidyKineticPhase phase,
+       gdouble t, gdouble x, gdouble v)
+{
+  gdouble r, edge, bound, tau, tau_edge, tau_slow;
+
+  kinetic->phase = phase;
+  kinetic->t0 = t;
+  kinetic->x0 = x;
+  kinetic->v0 = v;
+
+  r = rate_of (kinetic, phase);
+  edge = phase == TIDY_KINETIC_BOUNCE
+    ? nearest_edge (kinetic, x) : edge_of (kinetic, x, v);
+  switch (phase)
+    {
+    case TIDY_KINETIC_FREE:
+      /* Either we leave through an edge or come to rest. */
+      tau_edge = v != 0 ? time_to_reach (x, v, r, edge) : NEVER;
+      tau_slow = time_to_slow (v, r, REST_DISTANCE * (1 - r));
+      if (tau_edge <= tau_slow)
+        {
+          tau = tau_edge;
+          kinetic->next = TIDY_KINETIC_OVERSHOOT;
+          kinetic->x1 = edge;
+        }
+      else
+        {
+          tau = tau_slow;
+          kinetic->next = TIDY_KINETIC_REST;
+          kinetic->x1 = CLAMP (x + v / (1 - r),
+                               kinetic->lower, kinetic->upper);
+        }
+      break;
+
+    case TIDY_KINETIC_OVERSHOOT:
+      /* Until we run out of speed or skirt, then we bounce back. */
+      bound = x < kinetic->lower || (x == kinetic->lower && v < 0)
+        ? kinetic->lowest : kinetic->highest;
+      tau_edge = time_to_reach (x, v, r, bound);
+      tau_slow = time_to_slow (v, r, MIN_BOUNCE_SPEED);
+      tau = MIN (tau_edge, tau_slow);
+      kinetic->next = TIDY_KINETIC_BOUNCE;
+      kinetic->x1 = tau_edge <= tau_slow
+        ? bound : position_at (x, v, r, tau);
+      break;
+
+    case TIDY_KINETIC_BOUNCE:
+      /* Either we make it back with some speed left, or we're
+       * snapped to the edge when we're about to stop. */
+      tau_edge = time_to_reach (x, v, r, edge);
+      tau_slow = time_to_slow (v, r, MIN_BOUNCE_SPEED);
+      tau = MIN (tau_edge, tau_slow);
+      kinetic->next = tau_edge <= tau_slow
+        ? TIDY_KINETIC_FREE : TIDY_KINETIC_REST;
+      kinetic->x1 = edge;
+      break;
+
+    default:
+      kinetic->t1 = NEVER;
+      return;
+    }
+
+  kinetic->t1 = tau < NEVER ? t + tau : NEVER;
+  kinetic->v1 = speed_at (v, r, tau < NEVER ? tau : 0);
+  if (kinetic->next == TIDY_KINETIC_BOUNCE)
+    kinetic->v1 = (nearest_edge (kinetic, kinetic->x1) - kinetic->x1)
+      * kinetic->bounce_back_rate;
+  else if (kinetic->next == TIDY_KINETIC_REST)
+    kinetic->v1 = 0;
+}
+
+/* Starts moving from @value with @speed at time 0.  The rates and the
+ * limits must be set by then. */
+void
+tidy_kinetic_start (TidyKinetic *kinetic, gdouble value, gdouble speed)
+{
+  TidyKineticPhase phase;
+
+  kinetic->upper = MAX (kinetic->lower, kinetic->upper);
+  kinetic->lowest = MIN (kinetic->lowest, kinetic->lower);
+  kinetic->highest = MAX (kinetic->highest, kinetic->upper);
+
+  if (kinetic->lower <= value && value <= kinetic->upper)
+    phase = TIDY_KINETIC_FREE;
+  else if ((value < kinetic->lower) == (speed > 0))
+    /* Dragged beyond the edge but thrown back. */
+    phase = TIDY_KINETIC_BOUNCE;
+  else
+    phase = TIDY_KINETIC_OVERSHOOT;
+
+  enter (kinetic, phase, 0, value, speed);
+}
+
+/* Sets *@value to where we are at time @t, and returns whether we're
+ * still moving.  @t mustn't go backwards much: the segments already
+ * left behind are forgotten. */
+gboolean
+tidy_kinetic_get_value (TidyKinetic *kinetic, gdouble t, gdouble *value)
+{
+  guint i;
+
+  /* There are no more than a few segments in practice, but don't
+   * trust floating point to end them. */
+  for (i = 0; kinetic->phase != TIDY_KINETIC_REST && t >= kinetic->t1; i++)
+    if (i < 16)
+      enter (kinetic, kinetic->next, kinetic->t1, kinetic->x1, kinetic->v1);
+    else
+      enter (kinetic, TIDY_KINETIC_REST, t, kinetic->x1, 0);
+
+  if (kinetic->phase == TIDY_KINETIC_REST)
+    *value = kinetic->x0;
+  else
+    *value = position_at (kinetic->x0, kinetic->v0,
+                          rate_of (kinetic, kinetic->phase),
+                          MAX (t - kinetic->t0, 0));
+  *value = CLAMP (*value, kinetic->lowest, kinetic->highest);
+
+  return kinetic->phase != TIDY_KINETIC_REST;
+}
+
+/* How far free scrolling at @speed takes us. */
+gdouble
+tidy_kinetic_get_distance (const TidyKinetic *kinetic, gdouble speed)
+{
+  return speed / (1 - clamp_rate (kinetic->decel_rate));
+}
+
+/* The speed it takes to get @distance far. */
+gdouble
+tidy_kinetic_get_speed (const TidyKinetic *kinetic, gdouble distance)
+{
+  return distance * (1 - clamp_rate (kinetic->decel_rate));
+}
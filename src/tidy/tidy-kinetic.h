@@ -0,0 +1,52 @@
+#ifndef _TIDY_KINETIC
+#define _TIDY_KINETIC
+
+#include <glib.h>
+
+/* Kinetic scrolling along one axis, as a function of time rather than
+ * of the number of frames drawn.  Times are in 1/60 s units and speeds
+ * in units per 1/60 s, and the rates are how much of the speed is kept
+ * after each such unit.  Between @lower and @upper the speed decays by
+ * @decel_rate; past them (in the skirt, at most until @lowest and
+ * @highest) by @bouncing_decel_rate, and once it's spent it bounces
+ * back at @bounce_back_rate times the distance from the edge.
+ *
+ * The motion is a handful of segments with a closed form each, so
+ * getting the position at any time is O(1), however many frames have
+ * been skipped since the last time. */
+typedef struct _TidyKinetic TidyKinetic;
+
+typedef enum
+{
+  TIDY_KINETIC_FREE,        /* Between @lower and @upper. */
+  TIDY_KINETIC_OVERSHOOT,   /* Moving away from them in the skirt. */
+  TIDY_KINETIC_BOUNCE,      /* Moving back towards them. */
+  TIDY_KINETIC_REST
+} TidyKineticPhase;
+
+struct _TidyKinetic
+{
+  gdouble          decel_rate, bouncing_decel_rate, bounce_back_rate;
+  gdouble          lowest, lower, upper, highest;
+
+  /*< private >*/
+  TidyKineticPhase phase, next;
+
+  /* The current segment begins at @t0 from @x0 with @v0 and ends
+   * at @t1, where @next begins from @x1 with @v1. */
+  gdouble          t0, x0, v0;
+  gdouble          t1, x1, v1;
+};
+
+void     tidy_kinetic_start        (TidyKinetic       *kinetic,
+                                    gdouble            value,
+                                    gdouble            speed);
+gboolean tidy_kinetic_get_value    (TidyKinetic       *kinetic,
+                                    gdouble            t,
+                                    gdouble           *value);
+gdouble  tidy_kinetic_get_distance (const TidyKinetic *kinetic,
+                                    gdouble            speed);
+gdouble  tidy_kinetic_get_speed    (const TidyKinetic *kinetic,
+                                    gdouble            distance);
+
+#endif
@@ -70,3 +70,71 @@ void tidy_util_cogl_pop_offscreen_buffer(void)
   cogl_draw_buffer (obe->fbo ? COGL_OFFSCREEN_BUFFER : COGL_WINDOW_BUFFER,
                     obe->fbo);
 }
+
+/* Linear sampling override.  While it's on we hook into every actor's paint
+ * and switch the filters of the cogl texture of ClutterTextures which are
+ * about to be painted with nearest filtering, remembering them to switch
+ * them back at the end.  This way only what is actually painted is touched
+ * and the ClutterTextures' filter-quality is left alone.
+ * ------------------------------------------------ */
+static guint linear_sampling_depth;
+static gulong linear_sampling_hook;
+/* The cogl textures we've switched to linear filtering.  Kept around
+ * between passes so we don't need to allocate it every time. */
+static GPtrArray *linear_sampled;
+
+static gboolean
+linear_sampling_paint_hook(GSignalInvocationHint *ihint,
+                           guint n_param_values,
+                           const GValue *param_values,
+                           gpointer unused)
+{
+  ClutterActor *actor;
+  CoglHandle tex;
+
+  actor = g_value_get_object(&param_values[0]);
+  if (!CLUTTER_IS_TEXTURE(actor))
+    return TRUE;
+
+  tex = clutter_texture_get_cogl_texture(CLUTTER_TEXTURE(actor));
+  if (tex == COGL_INVALID_HANDLE
+      || cogl_texture_get_min_filter(tex) != CGL_NEAREST)
+    return TRUE;
+
+  cogl_texture_set_filters(tex, CGL_LINEAR, CGL_LINEAR);
+  g_ptr_array_add(linear_sampled, cogl_texture_ref(tex));
+  return TRUE;
+}
+
+void tidy_util_push_linear_sampling(void)
+{
+  if (linear_sampling_depth++)
+    return;
+
+  if (!linear_sampled)
+    linear_sampled = g_ptr_array_new();
+  linear_sampling_hook = g_signal_add_emission_hook(
+                      g_signal_lookup("paint", CLUTTER_TYPE_ACTOR), 0,
+                      linear_sampling_paint_hook, NULL, NULL);
+}
+
+void tidy_util_pop_linear_sampling(void)
+{
+  guint i;
+
+  g_assert(linear_sampling_depth > 0);
+  if (--linear_sampling_depth)
+    return;
+
+  g_signal_remove_emission_hook(g_signal_lookup("paint", CLUTTER_TYPE_ACTOR),
+                                linear_sampling_hook);
+  linear_sampling_hook = 0;
+
+  for (i = 0; i < linear_sampled->len; i++)
+    {
+      CoglHandle tex = g_ptr_array_index(linear_sampled, i);
+      cogl_texture_set_filters(tex, CGL_NEAREST, CGL_NEAREST);
+      cogl_texture_unref(tex);
+    }
+  g_ptr_array_set_size(linear_sampled, 0);
+}
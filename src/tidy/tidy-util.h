@@ -8,4 +8,10 @@
 void tidy_util_cogl_push_offscreen_buffer(CoglHandle fbo);
 void tidy_util_cogl_pop_offscreen_buffer(void);
 
+/* Between these the textures painted are sampled linearly, as if their
+ * filter quality was high, without changing it.  Used by the effect groups
+ * when they render their children offscreen.  They nest. */
+void tidy_util_push_linear_sampling(void);
+void tidy_util_pop_linear_sampling(void);
+
 #endif
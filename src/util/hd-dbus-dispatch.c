@@ -0,0 +1,136 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-dbus-dispatch.h"
+
+#include <string.h>
+
+struct _HdDBusDispatch
+{
+  /* Of the HdDBusSignal:s we were created with, keyed by themselves. */
+  GHashTable         *signals;
+  const HdDBusSignal *table;
+  guint               n_signals;
+  gpointer            data;
+
+  /* How many times we've looked into @signals, for the curious. */
+  guint               n_lookups;
+};
+
+static guint
+hd_dbus_signal_hash (gconstpointer key)
+{
+  const HdDBusSignal *sig = key;
+
+  return g_str_hash (sig->interface) * 31 + g_str_hash (sig->member);
+}
+
+static gboolean
+hd_dbus_signal_equal (gconstpointer a, gconstpointer b)
+{
+  const HdDBusSignal *sa = a, *sb = b;
+
+  return !strcmp (sa->member, sb->member)
+    && !strcmp (sa->interface, sb->interface);
+}
+
+/* @signals must be around as long as the returned dispatcher,
+ * which is forever.  @data is passed to the handlers. */
+HdDBusDispatch *
+hd_dbus_dispatch_new (const HdDBusSignal *signals, guint n_signals,
+                      gpointer data)
+{
+  HdDBusDispatch *self;
+  guint i;
+
+  self = g_new0 (HdDBusDispatch, 1);
+  self->signals = g_hash_table_new (hd_dbus_signal_hash,
+                                    hd_dbus_signal_equal);
+  self->table = signals;
+  self->n_signals = n_signals;
+  self->data = data;
+
+  for (i = 0; i < n_signals; i++)
+    g_hash_table_insert (self->signals, (gpointer)&signals[i],
+                         (gpointer)&signals[i]);
+
+  return self;
+}
+
+/* Asks the bus of @conn to send us the signals of @dispatch,
+ * and nothing else. */
+void
+hd_dbus_dispatch_add_matches (HdDBusDispatch *dispatch,
+                              DBusConnection *conn)
+{
+  const HdDBusSignal *sig;
+  gchar *rule;
+  guint i;
+
+  for (i = 0; i < dispatch->n_signals; i++)
+    {
+      sig = &dispatch->table[i];
+      if (sig->path)
+        rule = g_strdup_printf ("type='signal',path='%s',"
+                                "interface='%s',member='%s'",
+                                sig->path, sig->interface, sig->member);
+      else
+        rule = g_strdup_printf ("type='signal',"
+                                "interface='%s',member='%s'",
+                                sig->interface, sig->member);
+      dbus_bus_add_match (conn, rule, NULL);
+      g_free (rule);
+    }
+}
+
+/* A DBusHandleMessageFunction for dbus_connection_add_filter(), with
+ * the dispatcher as its user data.  Returns what the handler returns. */
+DBusHandlerResult
+hd_dbus_dispatch_filter (DBusConnection *conn, DBusMessage *msg,
+                         void *dispatch)
+{
+  HdDBusDispatch *self = dispatch;
+  const HdDBusSignal *sig;
+  HdDBusSignal key;
+
+  if (dbus_message_get_type (msg) != DBUS_MESSAGE_TYPE_SIGNAL)
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  key.interface = dbus_message_get_interface (msg);
+  key.member = dbus_message_get_member (msg);
+  if (!key.interface || !key.member)
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  self->n_lookups++;
+  if (!(sig = g_hash_table_lookup (self->signals, &key)))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  return sig->func (msg, self->data);
+}
+
+guint
+hd_dbus_dispatch_get_n_lookups (HdDBusDispatch *dispatch)
+{
+  return dispatch->n_lookups;
+}
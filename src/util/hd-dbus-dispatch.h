@@ -0,0 +1,63 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Dispatching D-Bus signals to their handlers through a hash table
+ * keyed by (interface, member), instead of comparing every message
+ * to every signal we know.  The same table tells the bus which
+ * signals to send us in the first place.
+ */
+
+#ifndef __HD_DBUS_DISPATCH_H__
+#define __HD_DBUS_DISPATCH_H__
+
+#include <glib.h>
+#include <dbus/dbus.h>
+
+G_BEGIN_DECLS
+
+typedef DBusHandlerResult (*HdDBusSignalFunc) (DBusMessage *msg,
+                                               gpointer data);
+
+typedef struct
+{
+  /* Only used in the match rule, may be NULL. */
+  const gchar      *path;
+  const gchar      *interface;
+  const gchar      *member;
+  HdDBusSignalFunc  func;
+} HdDBusSignal;
+
+typedef struct _HdDBusDispatch HdDBusDispatch;
+
+HdDBusDispatch    *hd_dbus_dispatch_new (const HdDBusSignal *signals,
+                                         guint n_signals,
+                                         gpointer data);
+void               hd_dbus_dispatch_add_matches (HdDBusDispatch *dispatch,
+                                                 DBusConnection *conn);
+DBusHandlerResult  hd_dbus_dispatch_filter (DBusConnection *conn,
+                                            DBusMessage *msg,
+                                            void *dispatch);
+guint              hd_dbus_dispatch_get_n_lookups (HdDBusDispatch *dispatch);
+
+G_END_DECLS
+
+#endif /* __HD_DBUS_DISPATCH_H__ */
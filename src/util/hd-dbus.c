@@ -1,6 +1,7 @@
 #include <unistd.h>
 
 #include "hd-dbus.h"
+#include "hd-dbus-dispatch.h"
 #include "hd-switcher.h"
 #include "hd-title-bar.h"
 #include "hd-render-manager.h"
@@ -30,268 +31,288 @@ gboolean hd_dbus_cunt = FALSE;
 
 static DBusConnection *connection, *sysbus_conn;
 
+static gboolean hd_dbus_call_active;
+
+/* Gets the first argument of @msg if it's an int32. */
+static gboolean
+hd_dbus_get_int32_arg (DBusMessage *msg, int *value)
+{
+  DBusMessageIter args;
+
+  if (!dbus_message_iter_init (msg, &args)
+      || dbus_message_iter_get_arg_type (&args) != DBUS_TYPE_INT32)
+    return FALSE;
+  dbus_message_iter_get_basic (&args, value);
+  return TRUE;
+}
+
 static DBusHandlerResult
-hd_dbus_signal_handler (DBusConnection *conn, DBusMessage *msg, void *data)
+hd_dbus_appkiller_exit (DBusMessage *msg, gpointer data)
 {
-  HdCompMgr  * hmgr = data;
+  HdCompMgr *hmgr = data;
 
-  if (dbus_message_is_signal(msg,
-			     APPKILLER_SIGNAL_INTERFACE,
-			     APPKILLER_SIGNAL_NAME))
-    {
-      /* kill -TERM all programs started from the launcher unconditionally,
-       * this signal is used by Backup application */
-      hd_comp_mgr_kill_all_apps (hmgr);
+  /* kill -TERM all programs started from the launcher unconditionally,
+   * this signal is used by Backup application */
+  hd_comp_mgr_kill_all_apps (hmgr);
 
-      return DBUS_HANDLER_RESULT_HANDLED;
-    }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  TASKNAV_SIGNAL_NAME))
-    {
-      if (STATE_IS_APP (hd_render_manager_get_state ()))
-	hd_render_manager_set_state (HDRM_STATE_TASK_NAV);
-      return DBUS_HANDLER_RESULT_HANDLED;
-    }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "set_state"))
-    {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	switch(sigvalue) {
-	  case HDRM_STATE_HOME :
-          case HDRM_STATE_HOME_PORTRAIT:
-          case HDRM_STATE_APP:
-          case HDRM_STATE_APP_PORTRAIT:
-          case HDRM_STATE_TASK_NAV:
-	  case HDRM_STATE_LAUNCHER:
-	  case HDRM_STATE_NON_COMPOSITED:
-          case HDRM_STATE_NON_COMP_PORT:
-            hd_render_manager_set_state (sigvalue);
-            break;
-        }
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
-    }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "activate_window"))
-    {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -1, 0);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
-    }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "close_window"))
-    {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -1, 1);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
-    }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "activate_window_time"))
-    {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -2, 0);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
-    }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "close_window_time"))
-    {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -2, 1);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
-    }
-  else if (dbus_message_is_signal(msg, TASKNAV_SIGNAL_INTERFACE, "launcher_activate"))
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static DBusHandlerResult
+hd_dbus_exit_app_view (DBusMessage *msg, gpointer data)
+{
+  if (STATE_IS_APP (hd_render_manager_get_state ()))
+    hd_render_manager_set_state (HDRM_STATE_TASK_NAV);
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static DBusHandlerResult
+hd_dbus_set_state (DBusMessage *msg, gpointer data)
+{
+  int sigvalue;
+
+  if (!hd_dbus_get_int32_arg (msg, &sigvalue))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  switch (sigvalue)
     {
-	    DBusMessageIter args;
-	    int sigvalue;
-
-	    if ((dbus_message_iter_init(msg, &args)) && 
-			    (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-		    dbus_message_iter_get_basic(&args, &sigvalue);
-		    hd_launcher_activate(sigvalue);
-		    return DBUS_HANDLER_RESULT_HANDLED;
-	    }
+      case HDRM_STATE_HOME:
+      case HDRM_STATE_HOME_PORTRAIT:
+      case HDRM_STATE_APP:
+      case HDRM_STATE_APP_PORTRAIT:
+      case HDRM_STATE_TASK_NAV:
+      case HDRM_STATE_LAUNCHER:
+      case HDRM_STATE_NON_COMPOSITED:
+      case HDRM_STATE_NON_COMP_PORT:
+        hd_render_manager_set_state (sigvalue);
+        break;
     }
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* hd_task_navigator_activate() with the window in @msg. */
+static DBusHandlerResult
+hd_dbus_activate (DBusMessage *msg, int timestamp, int flags)
+{
+  int sigvalue;
 
+  if (!hd_dbus_get_int32_arg (msg, &sigvalue))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  hd_task_navigator_activate (sigvalue, timestamp, flags);
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
 
+static DBusHandlerResult
+hd_dbus_activate_window (DBusMessage *msg, gpointer data)
+{
+  return hd_dbus_activate (msg, -1, 0);
+}
 
+static DBusHandlerResult
+hd_dbus_close_window (DBusMessage *msg, gpointer data)
+{
+  return hd_dbus_activate (msg, -1, 1);
+}
 
-  return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+static DBusHandlerResult
+hd_dbus_activate_window_time (DBusMessage *msg, gpointer data)
+{
+  return hd_dbus_activate (msg, -2, 0);
 }
 
 static DBusHandlerResult
-hd_dbus_system_bus_signal_handler (DBusConnection *conn,
-                                   DBusMessage *msg, void *data)
+hd_dbus_close_window_time (DBusMessage *msg, gpointer data)
+{
+  return hd_dbus_activate (msg, -2, 1);
+}
+
+static DBusHandlerResult
+hd_dbus_launcher_activate (DBusMessage *msg, gpointer data)
+{
+  int sigvalue;
+
+  if (!hd_dbus_get_int32_arg (msg, &sigvalue))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  hd_launcher_activate (sigvalue);
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* The rest is from the system bus and leaves the signals for others. */
+static DBusHandlerResult
+hd_dbus_dsme_shutdown (DBusMessage *msg, gpointer data)
 {
   HdCompMgr  * hmgr = data;
   extern MBWindowManager *hd_mb_wm;
-  static gboolean call_active;
-
-  if (dbus_message_is_signal(msg, DSME_SIGNAL_INTERFACE,
-			     DSME_SHUTDOWN_SIGNAL_NAME))
+  Window overlay;
+
+  g_warning ("%s: " DSME_SHUTDOWN_SIGNAL_NAME " from DSME", __func__);
+  /* send TERM to applications and exit without cleanup */
+  hd_volume_profile_set_silent (TRUE);
+  hd_comp_mgr_kill_all_apps (hmgr);
+  overlay = mb_wm_comp_mgr_clutter_get_overlay_window (
+                    MB_WM_COMP_MGR_CLUTTER (hmgr));
+  if (overlay != None)
     {
-      Window overlay;
-      g_warning ("%s: " DSME_SHUTDOWN_SIGNAL_NAME " from DSME", __func__);
-      /* send TERM to applications and exit without cleanup */
-      hd_volume_profile_set_silent (TRUE);
-      hd_comp_mgr_kill_all_apps (hmgr);
-      overlay = mb_wm_comp_mgr_clutter_get_overlay_window (
-                        MB_WM_COMP_MGR_CLUTTER (hmgr));
-      if (overlay != None)
-        {
-          /* needed because of the non-composite optimisations in X,
-           * otherwise we could show garbage if the shutdown screen is
-           * a bit slow or missing */
-          XClearWindow (hd_mb_wm->xdpy, overlay);
-          XFlush (hd_mb_wm->xdpy);
-        }
-      _exit (0);
+      /* needed because of the non-composite optimisations in X,
+       * otherwise we could show garbage if the shutdown screen is
+       * a bit slow or missing */
+      XClearWindow (hd_mb_wm->xdpy, overlay);
+      XFlush (hd_mb_wm->xdpy);
     }
-  else if (dbus_message_is_signal (msg, MCE_SIGNAL_IF, "tklock_mode_ind"))
-    {
-      const char *mode;
+  _exit (0);
+}
+
+static DBusHandlerResult
+hd_dbus_tklock_mode (DBusMessage *msg, gpointer data)
+{
+  extern MBWindowManager *hd_mb_wm;
+  const char *mode;
 
-      if (dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &mode,
-                                 DBUS_TYPE_INVALID))
+  if (!dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &mode,
+                              DBUS_TYPE_INVALID))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  if (strcmp(mode, MCE_TK_LOCKED))
+    {
+      hd_dbus_cunt = FALSE;
+      if (hd_dbus_tklock_on)
         {
-          if (strcmp(mode, MCE_TK_LOCKED))
-            {
-              hd_dbus_cunt = FALSE;
-              if (hd_dbus_tklock_on)
-                {
-                  hd_dbus_tklock_on = FALSE;
-                  /* if we avoided focusing a window during tklock, do it now
-                   * (this only has an effect if no window is currently
-                   * focused) */
-                  mb_wm_unfocus_client (hd_mb_wm, NULL);
-
-                  if (hd_dbus_state_before_tklock != HDRM_STATE_UNDEFINED)
-                    /* possibly go back to the state before tklock */
-                    hd_render_manager_set_state (HDRM_STATE_AFTER_TKLOCK);
-                  else
-                    hd_app_mgr_mce_activate_accel_if_needed (FALSE);
-                }
-            }
-          else if (!hd_dbus_tklock_on)
-            {
-              /*
-               * The order of the events is either
-               * call_state=ringing, tklock_ind=locked, call_state=active or
-               * call_state=ringing, call_state=active, tklock_ind=locked.
-               * Handle both cases.
-               */
-              hd_dbus_state_before_tklock = hd_render_manager_get_state ();
-              hd_dbus_tklock_on = TRUE;
-              hd_dbus_cunt = call_active
-                && (hd_render_manager_get_state()
-                    & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
-              hd_app_mgr_mce_activate_accel_if_needed (FALSE);
-            }
+          hd_dbus_tklock_on = FALSE;
+          /* if we avoided focusing a window during tklock, do it now
+           * (this only has an effect if no window is currently
+           * focused) */
+          mb_wm_unfocus_client (hd_mb_wm, NULL);
+
+          if (hd_dbus_state_before_tklock != HDRM_STATE_UNDEFINED)
+            /* possibly go back to the state before tklock */
+            hd_render_manager_set_state (HDRM_STATE_AFTER_TKLOCK);
+          else
+            hd_app_mgr_mce_activate_accel_if_needed (FALSE);
         }
     }
-  else if (dbus_message_is_signal (msg, MCE_SIGNAL_IF, "display_status_ind"))
+  else if (!hd_dbus_tklock_on)
     {
-      DBusMessageIter iter;
+      /*
+       * The order of the events is either
+       * call_state=ringing, tklock_ind=locked, call_state=active or
+       * call_state=ringing, call_state=active, tklock_ind=locked.
+       * Handle both cases.
+       */
+      hd_dbus_state_before_tklock = hd_render_manager_get_state ();
+      hd_dbus_tklock_on = TRUE;
+      hd_dbus_cunt = hd_dbus_call_active
+        && (hd_render_manager_get_state()
+            & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
+      hd_app_mgr_mce_activate_accel_if_needed (FALSE);
+    }
 
-      if (dbus_message_iter_init(msg, &iter))
-        {
-          char *str = NULL;
-          dbus_message_iter_get_basic(&iter, &str);
-          if (str)
-            {
-              if (strcmp (str, "on") == 0)
-                {
-                  ClutterActor *stage = clutter_stage_get_default ();
-                  /* Allow redraws again... */
-                  clutter_actor_show(
-                      CLUTTER_ACTOR(hd_render_manager_get()));
-                  clutter_actor_set_allow_redraw(stage, TRUE);
-                  /* make a blocking redraw to draw any new window (such as
-                   * the "swipe to unlock") first, otherwise just a black
-                   * screen will be visible (see below) */
-                  hd_dbus_display_is_off = FALSE;
-                  clutter_redraw (CLUTTER_STAGE (stage));
-                  if (hd_task_navigator_has_notifications ())
-                    { /* (Re)start pulsating if we have notifs. */
-                      HdTitleBar *tb = HD_TITLE_BAR (hd_render_manager_get_title_bar ());
-                      hd_title_bar_set_switcher_pulse (tb, FALSE);
-                      hd_title_bar_set_switcher_pulse (tb, TRUE);
-                    }
-                  hd_app_mgr_check_show_callui ();
-                }
-              else if (strcmp (str, "off") == 0)
-                {
-                  ClutterActor *stage = clutter_stage_get_default ();
-                  /* Stop redraws from anything. We do this on the stage
-                   * because Rotation does it on HDRM, and we don't want to
-                   * conflict. */
-                  clutter_actor_hide(
-                      CLUTTER_ACTOR(hd_render_manager_get()));
-                  clutter_actor_set_allow_redraw(stage, FALSE);
-                  hd_dbus_display_is_off = TRUE;
-                  /* Hiding before set_allow_redraw will queue a redraw,
-                   * which will draw a black screen (because hdrm is hidden).
-                   * This is needed for bug 139928 so that there is
-                   * absolutely no flicker of the previous screen
-                   * contents before the lock window appears. */
-                  clutter_redraw (CLUTTER_STAGE (stage));
-                }
-
-              hd_comp_mgr_update_applets_on_current_desktop_property (hmgr);
-            }
+  return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static DBusHandlerResult
+hd_dbus_display_status (DBusMessage *msg, gpointer data)
+{
+  HdCompMgr  * hmgr = data;
+  DBusMessageIter iter;
+  char *str = NULL;
+
+  if (!dbus_message_iter_init(msg, &iter))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  dbus_message_iter_get_basic(&iter, &str);
+  if (!str)
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  if (strcmp (str, "on") == 0)
+    {
+      ClutterActor *stage = clutter_stage_get_default ();
+      /* Allow redraws again... */
+      clutter_actor_show(
+          CLUTTER_ACTOR(hd_render_manager_get()));
+      clutter_actor_set_allow_redraw(stage, TRUE);
+      /* make a blocking redraw to draw any new window (such as
+       * the "swipe to unlock") first, otherwise just a black
+       * screen will be visible (see below) */
+      hd_dbus_display_is_off = FALSE;
+      clutter_redraw (CLUTTER_STAGE (stage));
+      if (hd_task_navigator_has_notifications ())
+        { /* (Re)start pulsating if we have notifs. */
+          HdTitleBar *tb = HD_TITLE_BAR (hd_render_manager_get_title_bar ());
+          hd_title_bar_set_switcher_pulse (tb, FALSE);
+          hd_title_bar_set_switcher_pulse (tb, TRUE);
         }
+      hd_app_mgr_check_show_callui ();
     }
-  else if (dbus_message_is_signal (msg, MCE_SIGNAL_IF, "sig_call_state_ind"))
+  else if (strcmp (str, "off") == 0)
     {
-      const char *state;
-
-      /* Watch the call state.  If we got an active call tell hdrm to
-       * try keeping the call-ui in the foreground after tklock is closed. */
-      dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &state,
-                             DBUS_TYPE_INVALID);
-      call_active = !strcmp(state, "active");
-      hd_dbus_cunt = call_active && hd_dbus_tklock_on
-        && (hd_render_manager_get_state()
-            & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
+      ClutterActor *stage = clutter_stage_get_default ();
+      /* Stop redraws from anything. We do this on the stage
+       * because Rotation does it on HDRM, and we don't want to
+       * conflict. */
+      clutter_actor_hide(
+          CLUTTER_ACTOR(hd_render_manager_get()));
+      clutter_actor_set_allow_redraw(stage, FALSE);
+      hd_dbus_display_is_off = TRUE;
+      /* Hiding before set_allow_redraw will queue a redraw,
+       * which will draw a black screen (because hdrm is hidden).
+       * This is needed for bug 139928 so that there is
+       * absolutely no flicker of the previous screen
+       * contents before the lock window appears. */
+      clutter_redraw (CLUTTER_STAGE (stage));
     }
 
+  hd_comp_mgr_update_applets_on_current_desktop_property (hmgr);
   return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
+static DBusHandlerResult
+hd_dbus_call_state (DBusMessage *msg, gpointer data)
+{
+  const char *state;
+
+  /* Watch the call state.  If we got an active call tell hdrm to
+   * try keeping the call-ui in the foreground after tklock is closed. */
+  if (!dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &state,
+                              DBUS_TYPE_INVALID))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  hd_dbus_call_active = !strcmp(state, "active");
+  hd_dbus_cunt = hd_dbus_call_active && hd_dbus_tklock_on
+    && (hd_render_manager_get_state()
+        & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
+
+  return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static const HdDBusSignal session_signals[] =
+{
+  { NULL, APPKILLER_SIGNAL_INTERFACE,
+    APPKILLER_SIGNAL_NAME, hd_dbus_appkiller_exit },
+  { NULL, TASKNAV_SIGNAL_INTERFACE, TASKNAV_SIGNAL_NAME,
+    hd_dbus_exit_app_view },
+  { NULL, TASKNAV_SIGNAL_INTERFACE, "set_state", hd_dbus_set_state },
+  { NULL, TASKNAV_SIGNAL_INTERFACE, "activate_window",
+    hd_dbus_activate_window },
+  { NULL, TASKNAV_SIGNAL_INTERFACE, "close_window",
+    hd_dbus_close_window },
+  { NULL, TASKNAV_SIGNAL_INTERFACE, "activate_window_time",
+    hd_dbus_activate_window_time },
+  { NULL, TASKNAV_SIGNAL_INTERFACE, "close_window_time",
+    hd_dbus_close_window_time },
+  { NULL, TASKNAV_SIGNAL_INTERFACE, "launcher_activate",
+    hd_dbus_launcher_activate },
+};
+
+static const HdDBusSignal system_signals[] =
+{
+  { NULL, DSME_SIGNAL_INTERFACE, DSME_SHUTDOWN_SIGNAL_NAME,
+    hd_dbus_dsme_shutdown },
+  { MCE_SIGNAL_PATH, MCE_SIGNAL_IF, MCE_TKLOCK_MODE_SIG,
+    hd_dbus_tklock_mode },
+  { MCE_SIGNAL_PATH, MCE_SIGNAL_IF, MCE_DISPLAY_SIG,
+    hd_dbus_display_status },
+  { MCE_SIGNAL_PATH, MCE_SIGNAL_IF, MCE_CALL_STATE_SIG,
+    hd_dbus_call_state },
+};
+
 static void
 hd_dbus_prevent_display_blanking (void)
 {
@@ -430,36 +451,21 @@ hd_dbus_init (HdCompMgr * hmgr)
     }
   else
     {
-      /* session bus */
-      dbus_bus_add_match (connection, "type='signal', interface='"
-                          APPKILLER_SIGNAL_INTERFACE "'", NULL);
+      HdDBusDispatch *dispatch;
 
-      dbus_bus_add_match (connection, "type='signal', interface='"
-                          TASKNAV_SIGNAL_INTERFACE "'", NULL);
-
-      dbus_connection_add_filter (connection, hd_dbus_signal_handler,
-				  hmgr, NULL);
+      /* session bus */
+      dispatch = hd_dbus_dispatch_new (session_signals,
+                                       G_N_ELEMENTS (session_signals), hmgr);
+      hd_dbus_dispatch_add_matches (dispatch, connection);
+      dbus_connection_add_filter (connection, hd_dbus_dispatch_filter,
+                                  dispatch, NULL);
 
       /* system bus */
-      dbus_bus_add_match (sysbus_conn, "type='signal', interface='"
-                          DSME_SIGNAL_INTERFACE "'", NULL);
-      dbus_bus_add_match (sysbus_conn,
-                          "type='signal',path='"MCE_SIGNAL_PATH"',"
-                          "interface='"MCE_SIGNAL_IF"',"
-                          "member='tklock_mode_ind'",
-                          NULL);
-      dbus_bus_add_match (sysbus_conn,
-                          "type='signal',path='" MCE_SIGNAL_PATH "',"
-                          "interface='" MCE_SIGNAL_IF "',"
-                          "member='" MCE_DISPLAY_SIG "'", NULL);
-      dbus_bus_add_match (sysbus_conn,
-                          "type='signal',path='" MCE_SIGNAL_PATH "',"
-                          "interface='" MCE_SIGNAL_IF "',"
-                          "member='" MCE_CALL_STATE_SIG "'", NULL);
-
-      dbus_connection_add_filter (sysbus_conn,
-                                  hd_dbus_system_bus_signal_handler,
-                                  hmgr, NULL);
+      dispatch = hd_dbus_dispatch_new (system_signals,
+                                       G_N_ELEMENTS (system_signals), hmgr);
+      hd_dbus_dispatch_add_matches (dispatch, sysbus_conn);
+      dbus_connection_add_filter (sysbus_conn, hd_dbus_dispatch_filter,
+                                  dispatch, NULL);
     }
 
   return connection;
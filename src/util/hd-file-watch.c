@@ -0,0 +1,230 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-file-watch.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/* What makes a file changed. */
+#define WATCH_MASK  (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)
+
+typedef struct
+{
+  /* The inotify watch descriptor of @path, or -1 if it's not watched. */
+  gint       wd;
+  gchar     *path;
+
+  /* The %HdFileWatch:es of the files in @path. */
+  GList     *watches;
+} HdFileWatchDir;
+
+struct _HdFileWatch
+{
+  HdFileWatchDir *dir;
+  gchar          *name;
+  gboolean        changed;
+};
+
+/* @inofd is -1 until the first watch is added, and stays so if there's
+ * no inotify, in which case @no_inotify is set and every file is always
+ * considered changed. */
+static gint inofd = -1;
+static gboolean no_inotify;
+static GList *dirs;
+
+static HdFileWatchDir *
+hd_file_watch_find_dir (const gchar *path, gint wd)
+{
+  GList *li;
+
+  for (li = dirs; li; li = li->next)
+    {
+      HdFileWatchDir *dir = li->data;
+
+      if (path ? !strcmp (dir->path, path) : dir->wd == wd)
+        return dir;
+    }
+
+  return NULL;
+}
+
+static void
+hd_file_watch_dir_changed (HdFileWatchDir *dir, const gchar *name)
+{
+  GList *li;
+
+  for (li = dir->watches; li; li = li->next)
+    {
+      HdFileWatch *watch = li->data;
+
+      if (!name || !strcmp (watch->name, name))
+        watch->changed = TRUE;
+    }
+}
+
+static gboolean
+hd_file_watch_read (GIOChannel *chnl, GIOCondition cond, gpointer unused)
+{
+  /* Events are variable-sized, but read() returns only whole ones. */
+  union
+  {
+    struct inotify_event ev;
+    gchar buf[4096];
+  } events;
+  const struct inotify_event *ev;
+  HdFileWatchDir *dir;
+  ssize_t len;
+  gsize i;
+
+  if ((len = read (inofd, &events, sizeof (events))) < 0)
+    {
+      if (errno != EINTR && errno != EAGAIN)
+        g_warning ("%s: read: %s", __FUNCTION__, strerror (errno));
+      return TRUE;
+    }
+
+  for (i = 0; i + sizeof (*ev) <= (gsize)len; i += sizeof (*ev) + ev->len)
+    {
+      ev = (const struct inotify_event *)&events.buf[i];
+
+      if (ev->mask & IN_Q_OVERFLOW)
+        { /* We don't know what we've missed. */
+          GList *li;
+
+          for (li = dirs; li; li = li->next)
+            hd_file_watch_dir_changed (li->data, NULL);
+        }
+      else if (!(dir = hd_file_watch_find_dir (NULL, ev->wd)))
+        /* We've just stopped watching it. */;
+      else if (ev->mask & IN_IGNORED)
+        { /* The directory is gone and so are its files. */
+          dir->wd = -1;
+          hd_file_watch_dir_changed (dir, NULL);
+        }
+      else if (ev->len)
+        hd_file_watch_dir_changed (dir, ev->name);
+    }
+
+  return TRUE;
+}
+
+/* Returns whether @dir is watched now. */
+static gboolean
+hd_file_watch_dir_start (HdFileWatchDir *dir)
+{
+  if (inofd < 0)
+    {
+      GIOChannel *chnl;
+
+      if (no_inotify)
+        return FALSE;
+      if ((inofd = inotify_init ()) < 0)
+        {
+          g_warning ("inotify_init: %s", strerror (errno));
+          no_inotify = TRUE;
+          return FALSE;
+        }
+
+      chnl = g_io_channel_unix_new (inofd);
+      g_io_add_watch (chnl, G_IO_IN, hd_file_watch_read, NULL);
+      g_io_channel_unref (chnl);
+    }
+
+  if ((dir->wd = inotify_add_watch (inofd, dir->path, WATCH_MASK)) < 0
+      && errno != ENOENT)
+    g_warning ("%s: %s", dir->path, strerror (errno));
+
+  return dir->wd >= 0;
+}
+
+/* Starts watching @fname, which is considered changed until the
+ * first hd_file_watch_take_changed(). */
+HdFileWatch *
+hd_file_watch_add (const gchar *fname)
+{
+  HdFileWatch *watch;
+  HdFileWatchDir *dir;
+  gchar *path;
+
+  path = g_path_get_dirname (fname);
+  if (!(dir = hd_file_watch_find_dir (path, -1)))
+    {
+      dir = g_new0 (HdFileWatchDir, 1);
+      dir->path = path;
+      hd_file_watch_dir_start (dir);
+      dirs = g_list_prepend (dirs, dir);
+    }
+  else
+    g_free (path);
+
+  watch = g_new0 (HdFileWatch, 1);
+  watch->dir = dir;
+  watch->name = g_path_get_basename (fname);
+  watch->changed = TRUE;
+  dir->watches = g_list_prepend (dir->watches, watch);
+
+  return watch;
+}
+
+void
+hd_file_watch_remove (HdFileWatch *watch)
+{
+  HdFileWatchDir *dir = watch->dir;
+
+  dir->watches = g_list_remove (dir->watches, watch);
+  g_free (watch->name);
+  g_free (watch);
+
+  if (!dir->watches)
+    {
+      if (dir->wd >= 0)
+        inotify_rm_watch (inofd, dir->wd);
+      dirs = g_list_remove (dirs, dir);
+      g_free (dir->path);
+      g_free (dir);
+    }
+}
+
+/* Returns whether the file of @watch has been created, written, replaced
+ * or deleted since the last time, and forgets about it. */
+gboolean
+hd_file_watch_take_changed (HdFileWatch *watch)
+{
+  gboolean changed;
+
+  if (no_inotify)
+    return TRUE;
+
+  /* Whatever is in the directory now is new to us. */
+  if (watch->dir->wd < 0 && hd_file_watch_dir_start (watch->dir))
+    hd_file_watch_dir_changed (watch->dir, NULL);
+
+  changed = watch->changed;
+  watch->changed = FALSE;
+  return changed;
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Tells whether files have changed without looking at them.  The
+ * directories of the watched files are watched with inotify, so files
+ * which are created, written, replaced with rename() or deleted are all
+ * noticed, and hd_file_watch_take_changed() just needs to look at a flag.
+ * The inotify events are read in the main loop.
+ *
+ * If a directory doesn't exist when the first file in it is added,
+ * hd_file_watch_take_changed() tries to start watching it again until
+ * it appears.
+ */
+
+#ifndef __HD_FILE_WATCH_H__
+#define __HD_FILE_WATCH_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HdFileWatch HdFileWatch;
+
+HdFileWatch *hd_file_watch_add          (const gchar *fname);
+void         hd_file_watch_remove       (HdFileWatch *watch);
+gboolean     hd_file_watch_take_changed (HdFileWatch *watch);
+
+G_END_DECLS
+
+#endif /* __HD_FILE_WATCH_H__ */
@@ -0,0 +1,37 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef __HD_KEY_FRAME_H__
+#define __HD_KEY_FRAME_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Functions for loading and interpolating from a list of keyframes */
+typedef struct _HdKeyFrameList HdKeyFrameList;
+HdKeyFrameList *hd_key_frame_list_create(const char *keys);
+void hd_key_frame_list_free(HdKeyFrameList *k);
+float hd_key_frame_interpolate(HdKeyFrameList *k, float x);
+
+G_END_DECLS
+
+#endif /* __HD_KEY_FRAME_H__ */
@@ -0,0 +1,289 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-scheduler.h"
+#include "hd-trace.h"
+
+#include <clutter/clutter.h>
+
+/* Leave this much of a frame period for the next frame. */
+#define SLACK_MARGIN  2000 /* us */
+
+typedef struct
+{
+  guint           id;
+  HdScheduleKind  kind;
+  const gchar    *name;
+  GSourceFunc     func;
+  gpointer        data;
+  GDestroyNotify  notify;
+
+  /* In queues[kind], or NULL while running. */
+  GList          *link;
+  guint           removed : 1;
+} HdSchedulerJob;
+
+typedef struct
+{
+  GSource         source;
+  HdScheduleKind  kind;
+} HdSchedulerSource;
+
+/* Pre-paint jobs must run before Clutter timelines (D+30) and redraws,
+ * post-paint ones after redraws.  Background jobs are also below
+ * redraws, and limited to the slack of the frame. */
+static const gint priorities[HD_SCHEDULE_NUM_KINDS] =
+{
+  G_PRIORITY_DEFAULT + 20,
+  G_PRIORITY_DEFAULT_IDLE,
+  G_PRIORITY_DEFAULT_IDLE + 10,
+};
+
+static GQueue queues[HD_SCHEDULE_NUM_KINDS];
+static GSource *sources[HD_SCHEDULE_NUM_KINDS];
+
+/* id -> HdSchedulerJob, of the jobs which haven't been removed. */
+static GHashTable *jobs;
+static guint last_id;
+
+/* When the stage was last painted. */
+static gint64 last_paint;
+
+static gint64
+hd_scheduler_frame_period (void)
+{
+  return G_USEC_PER_SEC / MAX (clutter_get_default_frame_rate (), 1);
+}
+
+/* Returns until when background jobs may run, or 0 if we're too close
+ * to the next frame, in which case *@timeout is set to when we can
+ * consider animations to have stopped. */
+static gint64
+hd_scheduler_get_deadline (gint *timeout)
+{
+  gint64 now, period;
+
+  now = hd_trace_now ();
+  period = hd_scheduler_frame_period ();
+
+  /* Nothing has been painted in a while, don't hog the main loop
+   * for longer than a frame anyway. */
+  if (now - last_paint >= 2 * period)
+    return now + period;
+
+  if (now < last_paint + period - SLACK_MARGIN)
+    return last_paint + period - SLACK_MARGIN;
+
+  *timeout = (last_paint + 2 * period - now + 999) / 1000;
+  return 0;
+}
+
+static void
+hd_scheduler_painted (ClutterActor *stage)
+{
+  last_paint = hd_trace_now ();
+}
+
+static void
+hd_scheduler_job_free (HdSchedulerJob *job)
+{
+  if (job->notify)
+    job->notify (job->data);
+  g_slice_free (HdSchedulerJob, job);
+}
+
+static void
+hd_scheduler_run_job (HdSchedulerJob *job)
+{
+  GQueue *queue = &queues[job->kind];
+  gboolean again;
+
+  g_queue_delete_link (queue, job->link);
+  job->link = NULL;
+
+  hd_trace_begin (HD_TRACE_IDLE, job->name);
+  again = job->func (job->data);
+  hd_trace_end (HD_TRACE_IDLE, job->name);
+
+  if (job->removed)
+    /* hd_scheduler_remove()d while running. */
+    hd_scheduler_job_free (job);
+  else if (again)
+    {
+      g_queue_push_tail (queue, job);
+      job->link = queue->tail;
+    }
+  else
+    {
+      g_hash_table_remove (jobs, GUINT_TO_POINTER (job->id));
+      hd_scheduler_job_free (job);
+    }
+}
+
+static gboolean
+hd_scheduler_prepare (GSource *source, gint *timeout)
+{
+  HdScheduleKind kind = ((HdSchedulerSource *)source)->kind;
+
+  *timeout = -1;
+  if (g_queue_is_empty (&queues[kind]))
+    return FALSE;
+  return kind != HD_SCHEDULE_BACKGROUND
+    || hd_scheduler_get_deadline (timeout) != 0;
+}
+
+static gboolean
+hd_scheduler_check (GSource *source)
+{
+  gint timeout;
+
+  return hd_scheduler_prepare (source, &timeout);
+}
+
+static gboolean
+hd_scheduler_dispatch (GSource *source, GSourceFunc unused1,
+                       gpointer unused2)
+{
+  HdScheduleKind kind = ((HdSchedulerSource *)source)->kind;
+  gint64 deadline;
+  gint timeout;
+  guint n;
+
+  /* Jobs added or rescheduled meanwhile wait for the next dispatch,
+   * so that a post-paint job adding itself again really runs after
+   * the next frame. */
+  n = g_queue_get_length (&queues[kind]);
+
+  if (kind != HD_SCHEDULE_BACKGROUND)
+    {
+      while (n-- > 0 && !g_queue_is_empty (&queues[kind]))
+        hd_scheduler_run_job (g_queue_peek_head (&queues[kind]));
+      return TRUE;
+    }
+
+  /* We wouldn't have been dispatched without slack, but always make
+   * progress anyway. */
+  if (!(deadline = hd_scheduler_get_deadline (&timeout)))
+    deadline = hd_trace_now ();
+  do
+    {
+      if (g_queue_is_empty (&queues[kind]))
+        break;
+      hd_scheduler_run_job (g_queue_peek_head (&queues[kind]));
+    }
+  while (--n > 0 && hd_trace_now () < deadline);
+
+  return TRUE;
+}
+
+static GSourceFuncs hd_scheduler_funcs =
+{
+  hd_scheduler_prepare,
+  hd_scheduler_check,
+  hd_scheduler_dispatch,
+  NULL
+};
+
+static void
+hd_scheduler_init (void)
+{
+  HdScheduleKind kind;
+
+  jobs = g_hash_table_new (NULL, NULL);
+  for (kind = 0; kind < HD_SCHEDULE_NUM_KINDS; kind++)
+    {
+      g_queue_init (&queues[kind]);
+      sources[kind] = g_source_new (&hd_scheduler_funcs,
+                                    sizeof (HdSchedulerSource));
+      ((HdSchedulerSource *)sources[kind])->kind = kind;
+      g_source_set_priority (sources[kind], priorities[kind]);
+      g_source_attach (sources[kind], NULL);
+    }
+
+  g_signal_connect_after (clutter_stage_get_default (), "paint",
+                          G_CALLBACK (hd_scheduler_painted), NULL);
+}
+
+/* Schedules @func(@data) as a @kind of job, see hd-scheduler.h.
+ * Returns an id for hd_scheduler_remove(). */
+guint
+hd_scheduler_add (HdScheduleKind kind, const gchar *name,
+                  GSourceFunc func, gpointer data, GDestroyNotify notify)
+{
+  HdSchedulerJob *job;
+  GList *li;
+
+  g_return_val_if_fail (kind < HD_SCHEDULE_NUM_KINDS, 0);
+
+  if (!jobs)
+    hd_scheduler_init ();
+
+  /* Coalesce with a job waiting to do the same. */
+  for (li = queues[kind].head; li; li = li->next)
+    {
+      job = li->data;
+      if (job->func == func && job->data == data)
+        return job->id;
+    }
+
+  job = g_slice_new0 (HdSchedulerJob);
+  if (!++last_id)
+    last_id++;
+  job->id = last_id;
+  job->kind = kind;
+  job->name = name;
+  job->func = func;
+  job->data = data;
+  job->notify = notify;
+
+  g_queue_push_tail (&queues[kind], job);
+  job->link = queues[kind].tail;
+  g_hash_table_insert (jobs, GUINT_TO_POINTER (job->id), job);
+
+  return job->id;
+}
+
+/* Cancels a job, even the one which is running.  Returns whether
+ * there was such a job. */
+gboolean
+hd_scheduler_remove (guint id)
+{
+  HdSchedulerJob *job;
+
+  if (!jobs || !(job = g_hash_table_lookup (jobs, GUINT_TO_POINTER (id))))
+    return FALSE;
+  g_hash_table_remove (jobs, GUINT_TO_POINTER (id));
+
+  if (!job->link)
+    /* hd_scheduler_run_job() will free it. */
+    job->removed = TRUE;
+  else
+    {
+      g_queue_delete_link (&queues[job->kind], job->link);
+      hd_scheduler_job_free (job);
+    }
+
+  return TRUE;
+}
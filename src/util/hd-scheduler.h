@@ -0,0 +1,67 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Deferred work that's aware of the frames Clutter paints.  Instead of
+ * picking an idle priority for each callback, say when it's needed:
+ *
+ * HD_SCHEDULE_PRE_PAINT:   before the next frame is painted, but after
+ *                          the pending X events, so that e.g. many restack
+ *                          requests make a single restack.  Higher than
+ *                          Clutter timelines, so it's not starved by them.
+ * HD_SCHEDULE_POST_PAINT:  after the next frame, if one is coming, so that
+ *                          the frame isn't delayed by it.
+ * HD_SCHEDULE_BACKGROUND:  only in what's left of a frame period after a
+ *                          frame has been painted, or in slices of one
+ *                          frame period if nothing is animating.
+ *
+ * Adding a job that's already waiting with the same kind, function and
+ * data doesn't schedule it again, the existing one's id is returned.
+ * Like with g_idle_add(), @func is called again as long as it returns
+ * TRUE; background jobs take turns.  Dispatches are traced as @name.
+ */
+
+#ifndef __HD_SCHEDULER_H__
+#define __HD_SCHEDULER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  HD_SCHEDULE_PRE_PAINT,
+  HD_SCHEDULE_POST_PAINT,
+  HD_SCHEDULE_BACKGROUND,
+
+  HD_SCHEDULE_NUM_KINDS
+} HdScheduleKind;
+
+guint    hd_scheduler_add    (HdScheduleKind  kind,
+                              const gchar    *name,
+                              GSourceFunc     func,
+                              gpointer        data,
+                              GDestroyNotify  notify);
+gboolean hd_scheduler_remove (guint           id);
+
+G_END_DECLS
+
+#endif /* __HD_SCHEDULER_H__ */
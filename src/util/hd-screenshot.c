@@ -0,0 +1,135 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-screenshot.h"
+#include "hd-task.h"
+
+#include <glib/gstdio.h>
+#include <libhildondesktop/hd-pvr-texture.h>
+
+#include <errno.h>
+#include <unistd.h>
+
+typedef struct
+{
+  GdkPixbuf          *pixbuf;
+  gchar              *filename;
+  HdScreenshotFormat  format;
+  HdScreenshotFunc    done;
+  gpointer            data;
+
+  /* Set by the worker. */
+  gboolean            saved;
+} HdScreenshotSave;
+
+/* The filenames being saved right now.  Only touched in the main loop. */
+static GHashTable *saving;
+
+/* In a worker. */
+static void
+hd_screenshot_save_run (gpointer data)
+{
+  HdScreenshotSave *save = data;
+  GError *error = NULL;
+  gchar *tmp;
+
+  /* Only one of us writes @filename at a time, so the name of the
+   * temporary file needn't be unique. */
+  tmp = g_strconcat (save->filename, ".tmp", NULL);
+  if (save->format == HD_SCREENSHOT_PVR)
+    save->saved = hd_pvr_texture_save (tmp, save->pixbuf, NULL);
+  else
+    save->saved = gdk_pixbuf_save (save->pixbuf, tmp, "png", &error, NULL);
+
+  if (save->saved && g_rename (tmp, save->filename) != 0)
+    {
+      g_warning ("%s: couldn't rename %s: %s", __FUNCTION__, tmp,
+                 g_strerror (errno));
+      save->saved = FALSE;
+    }
+  else if (!save->saved)
+    g_warning ("%s: saving %s failed: %s", __FUNCTION__, save->filename,
+               error ? error->message : "unknown error");
+
+  if (!save->saved)
+    unlink (tmp);
+  if (error)
+    g_error_free (error);
+  g_free (tmp);
+}
+
+/* In the main loop. */
+static void
+hd_screenshot_save_done (gpointer data)
+{
+  HdScreenshotSave *save = data;
+
+  g_hash_table_remove (saving, save->filename);
+  if (save->done)
+    save->done (save->filename, save->saved, save->data);
+
+  g_object_unref (save->pixbuf);
+  g_free (save->filename);
+  g_slice_free (HdScreenshotSave, save);
+}
+
+/*
+ * Starts saving @pixbuf as @filename, and calls @done when finished.
+ * If @filename is being saved already, returns FALSE and doesn't call
+ * @done, so requests for the same file coalesce.
+ */
+gboolean
+hd_screenshot_save (GdkPixbuf *pixbuf, const gchar *filename,
+                    HdScreenshotFormat format,
+                    HdScreenshotFunc done, gpointer data)
+{
+  HdScreenshotSave *save;
+
+  if (hd_screenshot_is_saving (filename))
+    {
+      g_debug ("%s: %s is being saved already", __FUNCTION__, filename);
+      return FALSE;
+    }
+
+  if (!saving)
+    saving = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_hash_table_insert (saving, g_strdup (filename), GINT_TO_POINTER (1));
+
+  save = g_slice_new0 (HdScreenshotSave);
+  save->pixbuf = g_object_ref (pixbuf);
+  save->filename = g_strdup (filename);
+  save->format = format;
+  save->done = done;
+  save->data = data;
+  hd_task_submit (hd_screenshot_save_run, hd_screenshot_save_done, save);
+
+  return TRUE;
+}
+
+gboolean
+hd_screenshot_is_saving (const gchar *filename)
+{
+  return saving && g_hash_table_lookup (saving, filename) != NULL;
+}
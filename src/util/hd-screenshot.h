@@ -0,0 +1,55 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Saving screenshots without stopping the main loop.  The caller grabs
+ * the pixels, which has to be done in the main thread anyway, and the
+ * compression and writing happens in a worker (see hd-task.h).  The file
+ * is written under a temporary name and renamed into place, so nobody
+ * sees it half-written.
+ */
+
+#ifndef __HD_SCREENSHOT_H__
+#define __HD_SCREENSHOT_H__
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  HD_SCREENSHOT_PNG,
+  HD_SCREENSHOT_PVR
+} HdScreenshotFormat;
+
+/* Called in the main loop when @filename is saved or failed to. */
+typedef void (*HdScreenshotFunc) (const gchar *filename, gboolean saved,
+                                  gpointer data);
+
+gboolean hd_screenshot_save      (GdkPixbuf *pixbuf, const gchar *filename,
+                                  HdScreenshotFormat format,
+                                  HdScreenshotFunc done, gpointer data);
+gboolean hd_screenshot_is_saving (const gchar *filename);
+
+G_END_DECLS
+
+#endif /* __HD_SCREENSHOT_H__ */
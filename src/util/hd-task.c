@@ -0,0 +1,296 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-task.h"
+#include "hildon-desktop.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* At most this many worker threads, however many CPUs there are. */
+#define MAX_WORKERS       4
+
+/* How long the main loop may spend calling @done:s in one go. */
+#define COMPLETION_BUDGET 4000 /* us */
+
+typedef struct _HdTask HdTask;
+
+struct _HdTask
+{
+  HdTaskFunc  run, done;
+  gpointer    data;
+
+  /* In @completed. */
+  HdTask     *next;
+};
+
+/*
+ * Every worker has a queue of tasks.  hd_task_submit() hands them out
+ * round-robin; a worker takes the newest one of its own, and if it has
+ * none, it steals the oldest one of another worker.  The queues are
+ * only locked for a push or a pop, so they are hardly ever contended.
+ */
+typedef struct
+{
+  GMutex   lock;
+  GQueue   tasks;
+  guint    idx;
+} HdTaskWorker;
+
+static HdTaskWorker *workers;
+static guint nworkers, next_worker;
+
+/* Workers with nothing to do sleep on @sleep_cond until @queued,
+ * the number of tasks not taken by anyone yet, is positive. */
+static GMutex sleep_lock;
+static GCond sleep_cond;
+static volatile gint queued;
+
+/* Finished tasks are pushed onto @completed by the workers, without
+ * locking, and taken from there all at once by the main loop, which
+ * calls their @done:s in order from @completing. */
+static volatile gpointer completed;
+static GQueue completing;
+static GSource *completion_source;
+
+static gint64
+hd_task_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+/* Called in the workers, or in the main thread without them. */
+static void
+hd_task_complete (HdTask *task)
+{
+  HdTask *head;
+
+  do
+    {
+      head = g_atomic_pointer_get (&completed);
+      task->next = head;
+    }
+  while (!g_atomic_pointer_compare_and_exchange (&completed, head, task));
+
+  g_main_context_wakeup (NULL);
+}
+
+/* Moves everything from @completed to @completing, in the order
+ * the tasks finished. */
+static void
+hd_task_take_completed (void)
+{
+  HdTask *head, *task, *oldest;
+
+  do
+    head = g_atomic_pointer_get (&completed);
+  while (head && !g_atomic_pointer_compare_and_exchange (&completed,
+                                                         head, NULL));
+
+  /* @head is newest first, turn it around. */
+  oldest = NULL;
+  while (head)
+    {
+      task = head;
+      head = head->next;
+      task->next = oldest;
+      oldest = task;
+    }
+
+  for (task = oldest; task; task = task->next)
+    g_queue_push_tail (&completing, task);
+}
+
+static gboolean
+hd_task_completion_pending (void)
+{
+  return !g_queue_is_empty (&completing)
+    || g_atomic_pointer_get (&completed) != NULL;
+}
+
+static gboolean
+hd_task_completion_prepare (GSource *source, gint *timeout)
+{
+  *timeout = -1;
+  return hd_task_completion_pending ();
+}
+
+static gboolean
+hd_task_completion_check (GSource *source)
+{
+  return hd_task_completion_pending ();
+}
+
+static gboolean
+hd_task_completion_dispatch (GSource *source, GSourceFunc unused1,
+                             gpointer unused2)
+{
+  gint64 deadline;
+  HdTask *task;
+
+  hd_task_take_completed ();
+
+  /* Leave the rest for the next main loop iteration if we're
+   * out of time, but always make progress. */
+  deadline = hd_task_now () + COMPLETION_BUDGET;
+  while ((task = g_queue_pop_head (&completing)) != NULL)
+    {
+      if (task->done)
+        task->done (task->data);
+      g_slice_free (HdTask, task);
+
+      if (hd_task_now () >= deadline)
+        break;
+    }
+
+  return TRUE;
+}
+
+static GSourceFuncs hd_task_completion_funcs =
+{
+  hd_task_completion_prepare,
+  hd_task_completion_check,
+  hd_task_completion_dispatch,
+  NULL
+};
+
+/* Returns a task from our own queue or from someone else's. */
+static HdTask *
+hd_task_take (HdTaskWorker *self)
+{
+  HdTaskWorker *victim;
+  HdTask *task;
+  guint i;
+
+  for (i = 0; i < nworkers; i++)
+    {
+      victim = &workers[(self->idx + i) % nworkers];
+      g_mutex_lock (&victim->lock);
+      task = victim == self
+        ? g_queue_pop_tail (&victim->tasks)
+        : g_queue_pop_head (&victim->tasks);
+      g_mutex_unlock (&victim->lock);
+
+      if (task)
+        {
+          g_atomic_int_add (&queued, -1);
+          return task;
+        }
+    }
+
+  return NULL;
+}
+
+static gpointer
+hd_task_worker_func (gpointer data)
+{
+  HdTaskWorker *self = data;
+  HdTask *task;
+
+  for (;;)
+    {
+      g_mutex_lock (&sleep_lock);
+      while (g_atomic_int_get (&queued) <= 0)
+        g_cond_wait (&sleep_cond, &sleep_lock);
+      g_mutex_unlock (&sleep_lock);
+
+      /* Someone may have been faster. */
+      if (!(task = hd_task_take (self)))
+        continue;
+
+      task->run (task->data);
+      hd_task_complete (task);
+    }
+
+  return NULL;
+}
+
+static void
+hd_task_init (void)
+{
+  long ncpus;
+  guint i;
+
+  /* Below redraws, so that animations come first. */
+  completion_source = g_source_new (&hd_task_completion_funcs,
+                                    sizeof (GSource));
+  g_source_set_priority (completion_source, G_PRIORITY_DEFAULT_IDLE);
+  g_source_attach (completion_source, NULL);
+
+  if (hd_disable_threads ())
+    return;
+
+  ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+  nworkers = CLAMP (ncpus, 1, MAX_WORKERS);
+  workers = g_new0 (HdTaskWorker, nworkers);
+  for (i = 0; i < nworkers; i++)
+    {
+      workers[i].idx = i;
+      g_mutex_init (&workers[i].lock);
+      g_queue_init (&workers[i].tasks);
+      g_thread_new ("hd-task", hd_task_worker_func, &workers[i]);
+    }
+}
+
+/* Calls @run(@data) in a worker thread, then @done(@data), if not NULL,
+ * in the main loop.  Must be called in the main thread. */
+void
+hd_task_submit (HdTaskFunc run, HdTaskFunc done, gpointer data)
+{
+  HdTaskWorker *worker;
+  HdTask *task;
+
+  if (!completion_source)
+    hd_task_init ();
+
+  task = g_slice_new (HdTask);
+  task->run = run;
+  task->done = done;
+  task->data = data;
+  task->next = NULL;
+
+  /* @done is still up to the main loop, so that the caller sees
+   * the same order of things as with threads. */
+  if (hd_disable_threads ())
+    {
+      run (data);
+      hd_task_complete (task);
+      return;
+    }
+
+  worker = &workers[next_worker++ % nworkers];
+  g_mutex_lock (&worker->lock);
+  g_queue_push_tail (&worker->tasks, task);
+  g_mutex_unlock (&worker->lock);
+
+  g_mutex_lock (&sleep_lock);
+  g_atomic_int_inc (&queued);
+  g_cond_signal (&sleep_cond);
+  g_mutex_unlock (&sleep_lock);
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Background work off the main thread.  A task's @run function is called
+ * in one of a few worker threads and must not touch Clutter, GTK+ or
+ * anything else the main thread uses without locking.  When it returns,
+ * @done is called in the main loop, without the Clutter lock, since
+ * that's where Clutter is used anyway.  The main loop doesn't spend
+ * more than a few milliseconds at a time calling @done:s, so a burst of
+ * finished tasks doesn't make animations miss frames.
+ *
+ * With $HD_NOTHREADS (see hd_disable_threads()) @run is called right
+ * away by hd_task_submit(), but @done is left to the main loop all
+ * the same.
+ */
+
+#ifndef __HD_TASK_H__
+#define __HD_TASK_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef void (*HdTaskFunc) (gpointer data);
+
+void hd_task_submit (HdTaskFunc run, HdTaskFunc done, gpointer data);
+
+G_END_DECLS
+
+#endif /* __HD_TASK_H__ */
@@ -0,0 +1,151 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-trace.h"
+
+#include <time.h>
+
+#define TRACE_ENV_VAR  "HILDON_DESKTOP_TRACE"
+#define TRACE_SIZE     4096
+
+typedef struct
+{
+  gint64       ts;      /* Monotonic, in microseconds. */
+  gint64       dur;     /* Only for 'X' */
+  const gchar *name;
+  gint         arg;
+  guint8       cat;
+  gchar        ph;
+} HdTraceEvent;
+
+static const gchar *category_names[HD_TRACE_NUM_CATEGORIES] =
+  { "state", "rotation", "blanking", "idle", "restack", "layout" };
+
+gboolean hd_trace_enabled;
+
+static HdTraceEvent *trace;
+static guint trace_next;
+static gboolean trace_full;
+static const gchar *trace_file;
+
+void
+hd_trace_init (void)
+{
+  trace_file = g_getenv (TRACE_ENV_VAR);
+  if (!trace_file || !*trace_file)
+    return;
+
+  trace = g_new0 (HdTraceEvent, TRACE_SIZE);
+  hd_trace_enabled = TRUE;
+}
+
+gint64
+hd_trace_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+void
+hd_trace_event (HdTraceCategory cat, gchar ph, const gchar *name,
+                gint64 ts, gint64 dur, gint arg)
+{
+  HdTraceEvent *ev;
+
+  if (!trace)
+    return;
+
+  ev = &trace[trace_next];
+  ev->ts = ts;
+  ev->dur = dur;
+  ev->name = name;
+  ev->arg = arg;
+  ev->cat = cat;
+  ev->ph = ph;
+
+  if (++trace_next == TRACE_SIZE)
+    {
+      trace_next = 0;
+      trace_full = TRUE;
+    }
+}
+
+/* Writes the events in the Chrome trace event format. */
+gboolean
+hd_trace_dump (const gchar *filename)
+{
+  GString *json;
+  GError *error = NULL;
+  guint i, n, first;
+  gboolean ret;
+
+  if (!trace)
+    return FALSE;
+
+  n = trace_full ? TRACE_SIZE : trace_next;
+  first = trace_full ? trace_next : 0;
+
+  json = g_string_new ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (i = 0; i < n; i++)
+    {
+      const HdTraceEvent *ev = &trace[(first + i) % TRACE_SIZE];
+
+      g_string_append_printf (json,
+                "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+                "\"ts\":%lld,\"pid\":1,\"tid\":1",
+                i ? "," : "", ev->name, category_names[ev->cat], ev->ph,
+                (long long)ev->ts);
+      if (ev->ph == 'X')
+        g_string_append_printf (json, ",\"dur\":%lld", (long long)ev->dur);
+      else if (ev->ph == 'b' || ev->ph == 'e')
+        g_string_append_printf (json, ",\"id\":%u", ev->cat);
+      else if (ev->ph == 'i')
+        g_string_append (json, ",\"s\":\"g\"");
+      if (ev->arg)
+        g_string_append_printf (json, ",\"args\":{\"arg\":%d}", ev->arg);
+      g_string_append_c (json, '}');
+    }
+  g_string_append (json, "\n]}\n");
+
+  ret = g_file_set_contents (filename, json->str, json->len, &error);
+  if (!ret)
+    {
+      g_warning ("%s: %s", __FUNCTION__, error->message);
+      g_error_free (error);
+    }
+
+  g_string_free (json, TRUE);
+  return ret;
+}
+
+/* Writes the trace where $HILDON_DESKTOP_TRACE says, if tracing. */
+void
+hd_trace_save (void)
+{
+  if (hd_trace_enabled && hd_trace_dump (trace_file))
+    g_debug ("%s: trace written to %s", __FUNCTION__, trace_file);
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Event tracer for state changes, rotation phases, idles and restacks.
+ * Events go to a ring buffer with monotonic timestamps and can be written
+ * out in the Chrome trace event format (chrome://tracing, Perfetto).
+ *
+ * Tracing is off unless $HILDON_DESKTOP_TRACE names the file to write the
+ * trace to, which happens on SIGUSR1 and on exit.  When off, every macro
+ * below costs a single test.  Event names must be static strings, only
+ * the pointer is stored.
+ */
+
+#ifndef __HD_TRACE_H__
+#define __HD_TRACE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  HD_TRACE_STATE,       /* hd_render_manager_set_state() */
+  HD_TRACE_ROTATION,    /* Phases of hd_transition_rotating_fsm() */
+  HD_TRACE_BLANKING,    /* The screen is blank while rotating */
+  HD_TRACE_IDLE,        /* hd_scheduler_add() jobs */
+  HD_TRACE_RESTACK,     /* Restacking in the compositor */
+  HD_TRACE_LAYOUT,      /* Laying out the task navigator */
+
+  HD_TRACE_NUM_CATEGORIES
+} HdTraceCategory;
+
+extern gboolean hd_trace_enabled;
+
+void     hd_trace_init  (void);
+gint64   hd_trace_now   (void);
+void     hd_trace_event (HdTraceCategory cat, gchar ph, const gchar *name,
+                         gint64 ts, gint64 dur, gint arg);
+gboolean hd_trace_dump  (const gchar *filename);
+void     hd_trace_save  (void);
+
+/* Synchronous spans, which must nest properly. */
+#define hd_trace_begin(cat, name) G_STMT_START {                        \
+  if (G_UNLIKELY (hd_trace_enabled))                                    \
+    hd_trace_event ((cat), 'B', (name), hd_trace_now (), 0, 0);         \
+} G_STMT_END
+#define hd_trace_end(cat, name) G_STMT_START {                          \
+  if (G_UNLIKELY (hd_trace_enabled))                                    \
+    hd_trace_event ((cat), 'E', (name), hd_trace_now (), 0, 0);         \
+} G_STMT_END
+
+/* A span from @start (a hd_trace_now() value) to now, for functions
+ * with many exits. */
+#define hd_trace_complete(cat, name, start) G_STMT_START {              \
+  if (G_UNLIKELY (hd_trace_enabled))                                    \
+    {                                                                   \
+      gint64 __hd_trace_now = hd_trace_now ();                          \
+      hd_trace_event ((cat), 'X', (name), (start),                      \
+                      __hd_trace_now - (start), 0);                     \
+    }                                                                   \
+} G_STMT_END
+
+/* Spans which begin and end in different callbacks, one at a time per
+ * category. */
+#define hd_trace_async_begin(cat, name) G_STMT_START {                  \
+  if (G_UNLIKELY (hd_trace_enabled))                                    \
+    hd_trace_event ((cat), 'b', (name), hd_trace_now (), 0, 0);         \
+} G_STMT_END
+#define hd_trace_async_end(cat, name, arg) G_STMT_START {               \
+  if (G_UNLIKELY (hd_trace_enabled))                                    \
+    hd_trace_event ((cat), 'e', (name), hd_trace_now (), 0, (arg));     \
+} G_STMT_END
+
+#define hd_trace_instant(cat, name, arg) G_STMT_START {                 \
+  if (G_UNLIKELY (hd_trace_enabled))                                    \
+    hd_trace_event ((cat), 'i', (name), hd_trace_now (), 0, (arg));     \
+} G_STMT_END
+
+G_END_DECLS
+
+#endif /* __HD_TRACE_H__ */
@@ -48,6 +48,8 @@
 #include "hd-volume-profile.h"
 #include "hd-util.h"
 #include "hd-dbus.h"
+#include "hd-trace.h"
+#include "hd-scheduler.h"
 
 /* The master of puppets */
 #define TRANSITIONS_INI             "/usr/share/hildon-desktop/transitions.ini"
@@ -175,6 +177,10 @@ static struct
    * necessary we stop waiting for damages immedeately.
    */
   guint patience_requests;
+
+  /* The phase we last told the tracer about and the number of damages
+   * ignored while blanked. */
+  guint traced_phase, ignored_damages;
 } Orientation_change;
 
 /* The number of transitions in progress requesting for @fixup_visibilities.
@@ -1474,6 +1480,43 @@ patience (XClientMessageEvent *event, void *unused)
     }
 }
 
+/* Names of the phases of hd_transition_rotating_fsm() for the tracer. */
+static const gchar *rotating_fsm_phases[] =
+{
+  "IDLE", "TRANS_START", "FADE_OUT", "WAIT_FOR_ROOT_CONFIG",
+  "WAIT_FOR_DAMAGES", "RECOVER", "FADE_IN",
+};
+
+#define PHASE_IS_BLANK(phase) \
+  ((phase) == WAIT_FOR_ROOT_CONFIG || (phase) == WAIT_FOR_DAMAGES)
+
+/* Tell the tracer if the phase has changed since the last time.  Called
+ * at the end of each round of the fsm, nested rounds make it a no-op. */
+static void
+hd_transition_trace_phase(void)
+{
+  guint old = Orientation_change.traced_phase;
+  guint new = Orientation_change.phase;
+
+  if (old == new)
+    return;
+  Orientation_change.traced_phase = new;
+
+  if (old != IDLE)
+    hd_trace_async_end (HD_TRACE_ROTATION, rotating_fsm_phases[old], 0);
+  if (new != IDLE)
+    hd_trace_async_begin (HD_TRACE_ROTATION, rotating_fsm_phases[new]);
+
+  if (!PHASE_IS_BLANK(old) && PHASE_IS_BLANK(new))
+    {
+      Orientation_change.ignored_damages = 0;
+      hd_trace_async_begin (HD_TRACE_BLANKING, "blank");
+    }
+  else if (PHASE_IS_BLANK(old) && !PHASE_IS_BLANK(new))
+    hd_trace_async_end (HD_TRACE_BLANKING, "blank",
+                        Orientation_change.ignored_damages);
+}
+
 static gboolean
 hd_transition_rotating_fsm(void)
 {
@@ -1489,12 +1532,17 @@ hd_transition_rotating_fsm(void)
       case IDLE:
         Orientation_change.phase = TRANS_START;
         Orientation_change.direction = Orientation_change.new_direction;
-        /* Take a screenshot of the screen as we currently are... */
+        /* Take a screenshot of the screen as we currently are...
+         * It's only shown fading and rotating away, so it needn't be
+         * taken at full resolution.  Make sure what's covered is hidden
+         * so that it doesn't get rendered into the snapshot. */
+        hd_render_manager_set_visibilities();
         tidy_cached_group_changed(CLUTTER_ACTOR(hd_render_manager_get()));
         tidy_cached_group_set_render_cache(
           CLUTTER_ACTOR(hd_render_manager_get()), 1);
         tidy_cached_group_set_downsampling_factor(
-          CLUTTER_ACTOR(hd_render_manager_get()), 1);
+          CLUTTER_ACTOR(hd_render_manager_get()),
+          hd_transition_get_double("rotate", "snapshot_downsample", 2));
         /* Stop displaying the loading screenshot, which was displayed
          * as a small square just over the icon when launching phone.
          * However, leave it alone if it's already there fully grown. */
@@ -1530,7 +1578,9 @@ hd_transition_rotating_fsm(void)
          * influx of X events from resizing kills our animation as we don't
          * get to idle for a while. So only start the transition once we
          * got to idle at least once! */
-        g_idle_add((GSourceFunc)(hd_transition_rotating_fsm), NULL);
+        hd_scheduler_add(HD_SCHEDULE_POST_PAINT, "rotating_fsm",
+                         (GSourceFunc)hd_transition_rotating_fsm,
+                         NULL, NULL);
         break;
       case TRANS_START:
         if (Orientation_change.direction == Orientation_change.new_direction)
@@ -1678,7 +1728,9 @@ trans_start_error:
                  * then toast it.
                  */
                 Orientation_change.phase = RECOVER;
-                g_idle_add((GSourceFunc)(hd_transition_rotating_fsm), NULL);
+                hd_scheduler_add(HD_SCHEDULE_POST_PAINT, "rotating_fsm",
+                                 (GSourceFunc)hd_transition_rotating_fsm,
+                                 NULL, NULL);
               }
           }
         break;
@@ -1719,6 +1771,7 @@ trans_start_error:
         }
     }
 
+  hd_transition_trace_phase();
   return FALSE;
 }
 
@@ -1821,11 +1874,16 @@ gboolean
 hd_transition_rotate_ignore_damage()
 {
   if (Orientation_change.phase == WAIT_FOR_ROOT_CONFIG)
-    return TRUE;
+    {
+      Orientation_change.ignored_damages++;
+      return TRUE;
+    }
   if (Orientation_change.phase == WAIT_FOR_DAMAGES)
     {
       gint max;
 
+      Orientation_change.ignored_damages++;
+
       /*
        * Only postpone the timeout if we haven't postponed
        * it too long already. This stops us getting stuck
@@ -0,0 +1,68 @@
+/* Checks that hd-client-index finds the clients of a few hundred actors
+ * and forgets them when they're unregistered.  The index never looks
+ * inside the clients and actors, so any distinct pointers will do. */
+
+#include <glib.h>
+#include <stdio.h>
+
+#include "hd-client-index.h"
+
+#define N_CLIENTS 500
+
+int main (void)
+{
+  MBWindowManagerClient *clients[N_CLIENTS];
+  ClutterActor *actors[N_CLIENTS], *spare;
+  int i;
+
+  for (i = 0; i < N_CLIENTS; i++)
+    {
+      clients[i] = g_malloc (1);
+      actors[i] = g_malloc (1);
+    }
+
+  /* Nothing is known before anything is registered. */
+  g_assert (hd_client_index_lookup (actors[0]) == NULL);
+
+  for (i = 0; i < N_CLIENTS; i++)
+    hd_client_index_set (clients[i], actors[i]);
+  for (i = 0; i < N_CLIENTS; i++)
+    g_assert (hd_client_index_lookup (actors[i]) == clients[i]);
+
+  /* Unregister every other client. */
+  for (i = 0; i < N_CLIENTS; i += 2)
+    hd_client_index_remove (clients[i]);
+  for (i = 0; i < N_CLIENTS; i++)
+    g_assert (hd_client_index_lookup (actors[i])
+              == (i % 2 ? clients[i] : NULL));
+
+  /* Removing twice is harmless. */
+  hd_client_index_remove (clients[0]);
+  g_assert (hd_client_index_lookup (actors[1]) == clients[1]);
+
+  /* A client getting a new actor forgets the old one. */
+  spare = g_malloc (1);
+  hd_client_index_set (clients[1], spare);
+  g_assert (hd_client_index_lookup (spare) == clients[1]);
+  g_assert (hd_client_index_lookup (actors[1]) == NULL);
+
+  /* An actor taken over by another client belongs to that one, even
+   * after the previous owner is removed. */
+  hd_client_index_set (clients[0], actors[3]);
+  g_assert (hd_client_index_lookup (actors[3]) == clients[0]);
+  hd_client_index_remove (clients[3]);
+  g_assert (hd_client_index_lookup (actors[3]) == clients[0]);
+
+  /* Setting no actor is removing. */
+  hd_client_index_set (clients[0], NULL);
+  g_assert (hd_client_index_lookup (actors[3]) == NULL);
+
+  for (i = 0; i < N_CLIENTS; i++)
+    hd_client_index_remove (clients[i]);
+  for (i = 0; i < N_CLIENTS; i++)
+    g_assert (hd_client_index_lookup (actors[i]) == NULL);
+  g_assert (hd_client_index_lookup (spare) == NULL);
+
+  printf ("%s: ok\n", __FILE__);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/* Feeds made-up D-Bus messages to an hd-dbus-dispatch filter and checks
+ * that each signal reaches its own handler, and that anything else is
+ * turned away after a single look into the table. */
+
+#include <glib.h>
+#include <stdio.h>
+
+#include "hd-dbus-dispatch.h"
+
+#define IFACE_A "com.example.a"
+#define IFACE_B "com.example.b"
+
+static guint calls[4];
+
+static DBusHandlerResult handler0 (DBusMessage *msg, gpointer data)
+{
+  g_assert (data == calls);
+  calls[0]++;
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static DBusHandlerResult handler1 (DBusMessage *msg, gpointer data)
+{
+  calls[1]++;
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static DBusHandlerResult handler2 (DBusMessage *msg, gpointer data)
+{
+  calls[2]++;
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* Leaves the message for others, like the system bus handlers. */
+static DBusHandlerResult handler3 (DBusMessage *msg, gpointer data)
+{
+  calls[3]++;
+  return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static const HdDBusSignal signals[] =
+{
+  { NULL,      IFACE_A, "ping",  handler0 },
+  { NULL,      IFACE_A, "pong",  handler1 },
+  /* The same member on another interface is another signal. */
+  { "/b/path", IFACE_B, "ping",  handler2 },
+  { NULL,      IFACE_B, "other", handler3 },
+};
+
+static DBusHandlerResult send_signal (HdDBusDispatch *dispatch,
+                                      const char *iface, const char *member)
+{
+  DBusHandlerResult ret;
+  DBusMessage *msg;
+
+  msg = dbus_message_new_signal ("/some/path", iface, member);
+  ret = hd_dbus_dispatch_filter (NULL, msg, dispatch);
+  dbus_message_unref (msg);
+
+  return ret;
+}
+
+static void expect_calls (guint c0, guint c1, guint c2, guint c3)
+{
+  g_assert (calls[0] == c0 && calls[1] == c1
+            && calls[2] == c2 && calls[3] == c3);
+}
+
+int main (void)
+{
+  HdDBusDispatch *dispatch;
+  DBusMessage *msg;
+  guint lookups;
+
+  dispatch = hd_dbus_dispatch_new (signals, G_N_ELEMENTS (signals), calls);
+
+  g_assert (send_signal (dispatch, IFACE_A, "ping")
+            == DBUS_HANDLER_RESULT_HANDLED);
+  expect_calls (1, 0, 0, 0);
+  g_assert (send_signal (dispatch, IFACE_A, "pong")
+            == DBUS_HANDLER_RESULT_HANDLED);
+  expect_calls (1, 1, 0, 0);
+  g_assert (send_signal (dispatch, IFACE_B, "ping")
+            == DBUS_HANDLER_RESULT_HANDLED);
+  expect_calls (1, 1, 1, 0);
+  g_assert (send_signal (dispatch, IFACE_B, "other")
+            == DBUS_HANDLER_RESULT_NOT_YET_HANDLED);
+  expect_calls (1, 1, 1, 1);
+
+  /* Unknown signals reach nobody, with one lookup each. */
+  lookups = hd_dbus_dispatch_get_n_lookups (dispatch);
+  g_assert (send_signal (dispatch, IFACE_A, "other")
+            == DBUS_HANDLER_RESULT_NOT_YET_HANDLED);
+  g_assert (send_signal (dispatch, IFACE_B, "pong")
+            == DBUS_HANDLER_RESULT_NOT_YET_HANDLED);
+  g_assert (send_signal (dispatch, "org.freedesktop.DBus", "NameOwnerChanged")
+            == DBUS_HANDLER_RESULT_NOT_YET_HANDLED);
+  g_assert (hd_dbus_dispatch_get_n_lookups (dispatch) == lookups + 3);
+  expect_calls (1, 1, 1, 1);
+
+  /* Method calls aren't even looked up. */
+  lookups = hd_dbus_dispatch_get_n_lookups (dispatch);
+  msg = dbus_message_new_method_call ("com.example", "/a", IFACE_A, "ping");
+  g_assert (hd_dbus_dispatch_filter (NULL, msg, dispatch)
+            == DBUS_HANDLER_RESULT_NOT_YET_HANDLED);
+  dbus_message_unref (msg);
+  g_assert (hd_dbus_dispatch_get_n_lookups (dispatch) == lookups);
+  expect_calls (1, 1, 1, 1);
+
+  printf ("%s: ok\n", __FILE__);
+  return 0;
+}
@@ -0,0 +1,119 @@
+/* Watches a directory of screenshots like the task switcher does, changes
+ * a few of them in all the ways they can change, and checks that exactly
+ * those are reported changed, that is, only their thumbnails would be
+ * reloaded.  Before the main loop has read the inotify events nothing is
+ * reported changed, which shows that the files themselves aren't looked
+ * at when asking. */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#include "hd-file-watch.h"
+
+#define N_FILES 20
+#define SETTLE  100 /* ms */
+
+/* The last one doesn't exist at first. */
+static gchar *fnames[N_FILES + 1];
+static HdFileWatch *watches[N_FILES + 1];
+
+static void write_file (const gchar *fname)
+{
+  FILE *f;
+
+  g_assert ((f = fopen (fname, "w")) != NULL);
+  fputs ("screenshot", f);
+  fclose (f);
+}
+
+/* Lets the main loop read the inotify events. */
+static void settle (void)
+{
+  int i;
+
+  for (i = 0; i < SETTLE; i++)
+    {
+      while (g_main_context_iteration (NULL, FALSE))
+        ;
+      usleep (1000);
+    }
+}
+
+/* Returns a bitmap of which files were reported changed. */
+static guint32 take_changed (void)
+{
+  guint32 changed;
+  int i;
+
+  changed = 0;
+  for (i = 0; i <= N_FILES; i++)
+    if (hd_file_watch_take_changed (watches[i]))
+      changed |= 1 << i;
+
+  return changed;
+}
+
+int main (void)
+{
+  gchar dir[] = "/tmp/test-file-watch-XXXXXX";
+  gchar *tmp, *other;
+  int i;
+
+  g_assert (mkdtemp (dir) != NULL);
+  for (i = 0; i <= N_FILES; i++)
+    {
+      fnames[i] = g_strdup_printf ("%s/shot-%d.png", dir, i);
+      if (i < N_FILES)
+        write_file (fnames[i]);
+    }
+  for (i = 0; i <= N_FILES; i++)
+    watches[i] = hd_file_watch_add (fnames[i]);
+
+  /* Everything needs to be loaded first, then nothing. */
+  g_assert (take_changed () == (1 << (N_FILES + 1)) - 1);
+  settle ();
+  g_assert (take_changed () == 0);
+
+  /* Overwrite, replace, delete and create some, and write another
+   * file in the same directory. */
+  write_file (fnames[3]);
+  tmp = g_strdup_printf ("%s.tmp", fnames[7]);
+  write_file (tmp);
+  g_assert (rename (tmp, fnames[7]) == 0);
+  g_assert (unlink (fnames[11]) == 0);
+  write_file (fnames[N_FILES]);
+  other = g_strdup_printf ("%s/other.png", dir);
+  write_file (other);
+
+  /* Nothing is known until the events are read. */
+  g_assert (take_changed () == 0);
+
+  settle ();
+  g_assert (take_changed ()
+            == (1 << 3 | 1 << 7 | 1 << 11 | 1 << N_FILES));
+  g_assert (take_changed () == 0);
+
+  /* A watch added again starts out changed, the others keep working. */
+  hd_file_watch_remove (watches[3]);
+  watches[3] = hd_file_watch_add (fnames[3]);
+  g_assert (hd_file_watch_take_changed (watches[3]));
+  write_file (fnames[5]);
+  settle ();
+  g_assert (take_changed () == 1 << 5);
+
+  for (i = 0; i <= N_FILES; i++)
+    {
+      hd_file_watch_remove (watches[i]);
+      unlink (fnames[i]);
+      g_free (fnames[i]);
+    }
+  unlink (other);
+  rmdir (dir);
+  g_free (other);
+  g_free (tmp);
+
+  printf ("%s: ok\n", __FILE__);
+  return 0;
+}
@@ -0,0 +1,115 @@
+/* Flings a TidyKinetic with made-up frame times and checks that it ends
+ * up in the same place whether the frames come at a steady 60 Hz, with
+ * jitter or with lots of them dropped, and that it never leaves the
+ * skirt on the way. */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "tidy-kinetic.h"
+
+/* What the launcher uses, with a 200 px skirt at both ends. */
+static void init (TidyKinetic *k)
+{
+  k->decel_rate = 0.99;
+  k->bouncing_decel_rate = 0.7;
+  k->bounce_back_rate = (1 - 0.7) / (1 - pow (0.7, 30));
+  k->lowest = -200;
+  k->lower = 0;
+  k->upper = 800;
+  k->highest = 1000;
+}
+
+/* Returns the next frame time after @t, in 1/60 s. */
+typedef double (*NextFrame) (double t);
+
+static double steady (double t)
+{
+  return t + 1;
+}
+
+static double jittery (double t)
+{
+  return t + 0.5 + rand () / (double)RAND_MAX;
+}
+
+static double dropping (double t)
+{
+  /* Every now and then we're very late. */
+  return t + (rand () % 10 ? 1 : 1 + rand () % 20);
+}
+
+/* Runs until we rest and returns where, or aborts if it takes forever. */
+static double run (double value, double speed, NextFrame next)
+{
+  TidyKinetic k;
+  double t, x;
+  int frames;
+
+  init (&k);
+  tidy_kinetic_start (&k, value, speed);
+  for (t = frames = 0; tidy_kinetic_get_value (&k, t, &x); t = next (t))
+    {
+      g_assert (k.lowest <= x && x <= k.highest);
+      g_assert (++frames < 60 * 60);
+    }
+
+  return x;
+}
+
+static void check (double value, double speed)
+{
+  double want, got;
+  int i;
+
+  want = run (value, speed, steady);
+  for (i = 0; i < 20; i++)
+    {
+      got = run (value, speed, jittery);
+      g_assert (fabs (got - want) < 1e-6);
+      got = run (value, speed, dropping);
+      g_assert (fabs (got - want) < 1e-6);
+    }
+}
+
+int main (void)
+{
+  TidyKinetic k;
+  double x;
+
+  srand (1);
+
+  /* Stopping in the middle, at either end, and after bouncing. */
+  check (100, 3);
+  check (500, 30);
+  check (500, -30);
+  check (700, 60);
+  check (100, -60);
+
+  /* Dragged beyond an edge and let go. */
+  check (-150, 0);
+  check (950, 5);
+  check (-100, 40);
+
+  /* Where we end up. */
+  g_assert (fabs (run (100, 3, steady) - 400) < 1);
+  g_assert (run (700, 60, steady) == 800);
+  g_assert (run (100, -60, steady) == 0);
+  g_assert (run (-150, 0, steady) == 0);
+
+  /* A frame very late skips the whole motion. */
+  init (&k);
+  tidy_kinetic_start (&k, 500, 30);
+  g_assert (!tidy_kinetic_get_value (&k, 1e6, &x));
+  g_assert (x == run (500, 30, steady));
+
+  /* The distance and the speed are inverses. */
+  init (&k);
+  g_assert (fabs (tidy_kinetic_get_speed (&k,
+                    tidy_kinetic_get_distance (&k, 7)) - 7) < 1e-9);
+
+  printf ("%s: ok\n", __FILE__);
+  return 0;
+}
@@ -0,0 +1,163 @@
+/* Starts the launch helper, grows big like the compositor does, then
+ * launches trivial commands through the helper.  Checks that exit
+ * statuses and environments get through, and that a program which
+ * can't be executed is reported.  Then it times how long
+ * hd_launch_helper_spawn() blocks the main thread, and g_spawn_async()
+ * for comparison.  The former must stay under a bound, given in
+ * milliseconds on the command line. */
+
+#include <glib.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "hd-launch-helper.h"
+
+#define DEFAULT_BOUND 10  /* ms */
+#define BIG           (256 * 1024 * 1024)
+#define ROUNDS        50
+
+typedef struct
+{
+  GPid pid;
+  gint status;
+  gboolean done;
+} Child;
+
+static guint running;
+
+static gint64 now_us (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void spawned (GPid pid, gint status, Child *child)
+{
+  child->pid = pid;
+  if (!pid)
+    {
+      child->status = status;
+      child->done = TRUE;
+    }
+}
+
+static void exited (GPid pid, gint status, Child *child)
+{
+  g_assert (pid == child->pid);
+  child->status = status;
+  child->done = TRUE;
+}
+
+static void exited_quietly (GPid pid, gint status, gpointer unused)
+{
+  g_assert (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+  running--;
+}
+
+/* Returns the wait status of @cmd, or the errno if it couldn't be run. */
+static gint run (const gchar *cmd, gchar **envp, GPid *pidp)
+{
+  gchar *argv[] = { "/bin/sh", "-c", (gchar *)cmd, NULL };
+  Child child = { 0, 0, FALSE };
+
+  g_assert (hd_launch_helper_spawn (argv, envp,
+                                    (HdLaunchHelperFunc)spawned,
+                                    (HdLaunchHelperFunc)exited, &child));
+  while (!child.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  if (pidp)
+    *pidp = child.pid;
+  return child.status;
+}
+
+int main (int argc, char **argv)
+{
+  gchar *envp[] = { "HD_TEST=given", NULL };
+  gchar *truth[] = { "/bin/true", NULL };
+  gchar *nothing[] = { "/nonexistent/program", NULL };
+  gint64 t, worst, spawn_worst;
+  Child child = { 0, 0, FALSE };
+  gchar *big;
+  GPid pid;
+  gint status, bound, i;
+
+  bound = argc > 1 ? atoi (argv[1]) : DEFAULT_BOUND;
+
+  g_assert (!hd_launch_helper_is_running ());
+  g_assert (hd_launch_helper_start (NULL, NULL));
+  g_assert (hd_launch_helper_is_running ());
+
+  /* Only now become big. */
+  big = g_malloc (BIG);
+  memset (big, 1, BIG);
+
+  /* Exit statuses, pids and signals. */
+  status = run ("exit 3", NULL, &pid);
+  g_assert (pid > 0 && WIFEXITED (status) && WEXITSTATUS (status) == 3);
+  status = run ("kill -TERM $$", NULL, NULL);
+  g_assert (WIFSIGNALED (status) && WTERMSIG (status) == SIGTERM);
+
+  /* The environment is given or ours, and it's ours at the time. */
+  status = run ("test \"$HD_TEST\" = given", envp, NULL);
+  g_assert (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+  g_setenv ("HD_TEST", "ours", TRUE);
+  status = run ("test \"$HD_TEST\" = ours", NULL, NULL);
+  g_assert (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+
+  /* Programs which can't be executed aren't started. */
+  g_assert (hd_launch_helper_spawn (nothing, NULL,
+                                    (HdLaunchHelperFunc)spawned,
+                                    (HdLaunchHelperFunc)exited, &child));
+  while (!child.done)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert (!child.pid && child.status == ENOENT);
+
+  /* How long are we blocked with and without the helper? */
+  worst = 0;
+  for (i = 0; i < ROUNDS; i++)
+    {
+      t = now_us ();
+      g_assert (hd_launch_helper_spawn (truth, NULL, NULL,
+                                        exited_quietly, NULL));
+      t = now_us () - t;
+      if (t > worst)
+        worst = t;
+      running++;
+    }
+  while (running)
+    g_main_context_iteration (NULL, TRUE);
+
+  spawn_worst = 0;
+  for (i = 0; i < ROUNDS; i++)
+    {
+      t = now_us ();
+      g_assert (g_spawn_async (NULL, truth, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+                               NULL, NULL, &pid, NULL));
+      t = now_us () - t;
+      if (t > spawn_worst)
+        spawn_worst = t;
+      waitpid (pid, NULL, 0);
+    }
+
+  printf ("%d launches with %d MB: %.2f ms worst with the helper, "
+          "%.2f ms with g_spawn_async()\n", ROUNDS, BIG / (1024 * 1024),
+          worst / 1000.0, spawn_worst / 1000.0);
+  g_free (big);
+
+  if (worst > bound * 1000)
+    {
+      fprintf (stderr, "the helper blocked us for more than %d ms\n", bound);
+      return 1;
+    }
+
+  printf ("%s: ok\n", __FILE__);
+  return 0;
+}
@@ -0,0 +1,205 @@
+/* Runs every kind of launcher grid transition over a screenful of tiles
+ * and checks that hd-launcher-grid-motion, which works out most of it
+ * before the transition starts, puts the tiles where the launcher used
+ * to when it did everything every frame.  old_tile_state() is the
+ * latter, as it was in hd_launcher_grid_transition(). */
+
+#include <glib.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "hd-launcher-grid-motion.h"
+
+#define COLUMNS    5
+#define ROWS       4
+#define N_FRAMES   60
+#define DEPTH      100
+#define CENTRE_X   800
+#define CENTRE_Y   424
+
+typedef enum
+{
+  IN, IN_SUB, OUT, OUT_BACK, LAUNCH, OUT_SUB, BACK, FORWARD, N_TRANSITIONS
+} Transition;
+
+static HdKeyFrameList *keyframes, *keyframes_label, *keyframes_icon;
+
+static void
+old_tile_state (Transition trans_type, gboolean sequenced,
+                float x, float y, float cx, float cy, float amount,
+                HdLauncherGridTileState *state)
+{
+  float d, dx, dy;
+  float order_diff;
+  float order_amt;
+  gint transition_depth = DEPTH;
+
+  state->depth = 0;
+  state->opacity = state->icon_opacity = state->label_opacity = -1;
+
+  dx = x - cx;
+  dy = y - cy;
+  d = sqrt(dx*dx + dy*dy) / 1000.0f;
+  if (d>1) d=1;
+
+  order_diff = (x + y) / (800 + 480);
+  if (order_diff>1) order_diff = 1;
+  order_amt = amount*2 - order_diff;
+  if (order_amt<0) order_amt = 0;
+  if (order_amt>1) order_amt = 1;
+
+  switch (trans_type)
+    {
+      case IN:
+      case IN_SUB:
+        {
+          float label_amt, icon_amt;
+
+          if (sequenced)
+            {
+              label_amt = hd_key_frame_interpolate(keyframes_label, order_amt);
+              icon_amt = hd_key_frame_interpolate(keyframes_icon, order_amt);
+              if (label_amt<0) label_amt=0;
+              if (label_amt>1) label_amt=1;
+              if (icon_amt<0) icon_amt = 0;
+              if (icon_amt>1) icon_amt = 1;
+              state->depth = transition_depth *
+                (1 - hd_key_frame_interpolate(keyframes, order_amt));
+            }
+          else
+            {
+              state->depth = transition_depth * (1 - amount);
+              label_amt = amount;
+              icon_amt = amount;
+            }
+          state->opacity = 255;
+          state->icon_opacity = (int)(icon_amt*255);
+          state->label_opacity = (int)(label_amt*255);
+          break;
+        }
+      case OUT:
+      case OUT_SUB:
+        state->depth = transition_depth*amount;
+        state->opacity = 255 - (int)(amount*255);
+        break;
+      case LAUNCH:
+        {
+          float tile_amt = amount*2 - d;
+          if (tile_amt<0) tile_amt = 0;
+          if (tile_amt>1) tile_amt = 1;
+          state->depth = -transition_depth*tile_amt;
+          state->opacity = 255 - (int)(amount*255);
+          break;
+        }
+      case BACK:
+        state->depth = -transition_depth*amount;
+        state->opacity = 255 - (int)(amount*255);
+        break;
+      case FORWARD:
+        state->depth = -transition_depth*(1-amount);
+        state->opacity = (int)(amount*255);
+        break;
+      case OUT_BACK:
+      case N_TRANSITIONS:
+        break;
+    }
+}
+
+/* What hd_launcher_grid_transition_begin() makes of them. */
+static HdLauncherGridMotionType
+motion_type (Transition trans_type, gboolean sequenced)
+{
+  switch (trans_type)
+    {
+      case IN:
+      case IN_SUB:
+        return sequenced ? HD_LAUNCHER_GRID_MOTION_IN_SEQUENCED
+                         : HD_LAUNCHER_GRID_MOTION_IN;
+      case OUT:
+      case OUT_SUB:
+        return HD_LAUNCHER_GRID_MOTION_OUT;
+      case LAUNCH:
+        return HD_LAUNCHER_GRID_MOTION_LAUNCH;
+      case BACK:
+        return HD_LAUNCHER_GRID_MOTION_BACK;
+      case FORWARD:
+        return HD_LAUNCHER_GRID_MOTION_FORWARD;
+      default:
+        return HD_LAUNCHER_GRID_MOTION_NONE;
+    }
+}
+
+static guint
+check (Transition trans_type, gboolean sequenced)
+{
+  HdLauncherGridMotion motion;
+  HdLauncherGridMotionTile tiles[COLUMNS * ROWS];
+  HdLauncherGridTileState old, new;
+  float cx, cy;
+  guint i, frame, n = 0;
+
+  /* Only launching moves away from somewhere else than the corner. */
+  cx = trans_type == LAUNCH ? CENTRE_X : 0;
+  cy = trans_type == LAUNCH ? CENTRE_Y : 0;
+
+  motion.type = motion_type (trans_type, sequenced);
+  motion.depth = DEPTH;
+  motion.keyframes = keyframes;
+  motion.keyframes_label = keyframes_label;
+  motion.keyframes_icon = keyframes_icon;
+
+  for (i = 0; i < COLUMNS * ROWS; i++)
+    hd_launcher_grid_motion_prepare_tile (&tiles[i],
+                                          18 + (i % COLUMNS) * 158,
+                                          60 + (i / COLUMNS) * 126,
+                                          cx, cy);
+
+  for (frame = 0; frame <= N_FRAMES; frame++)
+    for (i = 0; i < COLUMNS * ROWS; i++)
+      {
+        float amount = frame / (float)N_FRAMES;
+
+        old_tile_state (trans_type, sequenced,
+                        18 + (i % COLUMNS) * 158, 60 + (i / COLUMNS) * 126,
+                        cx, cy, amount, &old);
+        hd_launcher_grid_motion_tile (&motion, &tiles[i], amount, &new);
+
+        if (motion.type == HD_LAUNCHER_GRID_MOTION_NONE)
+          {
+            /* The tiles are left alone. */
+            g_assert (new.opacity < 0);
+            continue;
+          }
+
+        g_assert (fabs (old.depth - new.depth) < 1e-3);
+        g_assert (old.opacity == new.opacity);
+        g_assert (old.icon_opacity == new.icon_opacity);
+        g_assert (old.label_opacity == new.label_opacity);
+        n++;
+      }
+
+  return n;
+}
+
+int main (void)
+{
+  Transition t;
+  guint n = 0;
+
+  keyframes = hd_key_frame_list_create ("0,0.4,0.9,1.1,1");
+  keyframes_label = hd_key_frame_list_create ("0,0,0.2,1");
+  keyframes_icon = hd_key_frame_list_create ("-0.5,0.5,1.5");
+
+  for (t = 0; t < N_TRANSITIONS; t++)
+    {
+      n += check (t, FALSE);
+      n += check (t, TRUE);
+    }
+
+  hd_key_frame_list_free (keyframes);
+  hd_key_frame_list_free (keyframes_label);
+  hd_key_frame_list_free (keyframes_icon);
+
+  printf ("%s: ok, %u tile states compared\n", __FILE__, n);
+  return 0;
+}
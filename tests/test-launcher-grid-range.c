@@ -0,0 +1,104 @@
+/* Scrolls a launcher grid of a thousand apps from the top to the bottom
+ * and back, with hd-launcher-grid-range deciding which rows to load,
+ * and checks that what's on the screen is always loaded, that hardly
+ * anything else is, and that every row is unloaded as many times as
+ * it's loaded.  The sizes are about those of the landscape launcher. */
+
+#include <glib.h>
+#include <stdio.h>
+
+#include "hd-launcher-grid-range.h"
+
+#define N_APPS      1000
+#define COLUMNS     5
+#define N_ROWS      ((N_APPS + COLUMNS - 1) / COLUMNS)
+#define FIRST_ROW_Y 60
+#define ROW_PITCH   126
+#define VIEW_HEIGHT 480
+#define MARGIN      1
+#define KEEP        1
+
+/* What can be partly on the screen at once, plus the margins
+ * and what's kept on both sides. */
+#define MAX_LIVE_ROWS (VIEW_HEIGHT / ROW_PITCH + 2 + 2 * (MARGIN + KEEP))
+#define MAX_LIVE_TILES (MAX_LIVE_ROWS * COLUMNS)
+
+static gboolean loaded[N_ROWS];
+static guint n_loaded, n_loads, n_unloads;
+
+static void
+set_row_live (guint row, gboolean live, gpointer data)
+{
+  g_assert (row < N_ROWS);
+  g_assert (loaded[row] != live);
+
+  loaded[row] = live;
+  if (live)
+    {
+      n_loaded++;
+      n_loads++;
+    }
+  else
+    {
+      n_loaded--;
+      n_unloads++;
+    }
+}
+
+static void
+scroll_to (HdLauncherGridRange *live, gint y)
+{
+  HdLauncherGridRange wanted;
+  gint row;
+
+  hd_launcher_grid_range_for_view (&wanted, N_ROWS, FIRST_ROW_Y, ROW_PITCH,
+                                   y, VIEW_HEIGHT, MARGIN);
+  hd_launcher_grid_range_update (live, &wanted, KEEP, set_row_live, NULL);
+
+  /* Everything on the screen is loaded... */
+  for (row = 0; row < N_ROWS; row++)
+    {
+      gint top = FIRST_ROW_Y + row * ROW_PITCH;
+
+      if (top < y + VIEW_HEIGHT && top + ROW_PITCH > y)
+        g_assert (loaded[row]);
+    }
+
+  /* ...and not much more. */
+  g_assert (n_loaded == live->last - live->first);
+  g_assert (n_loaded * COLUMNS <= MAX_LIVE_TILES);
+}
+
+int main (void)
+{
+  HdLauncherGridRange live = { 0, 0 }, none = { 0, 0 };
+  gint bottom, y, i;
+  guint loads;
+
+  bottom = FIRST_ROW_Y + N_ROWS * ROW_PITCH - VIEW_HEIGHT;
+
+  /* Slowly down, overshooting at both ends. */
+  for (y = -100; y <= bottom + 100; y += 7)
+    scroll_to (&live, y);
+  /* Back up in big jumps. */
+  for (y = bottom; y >= 0; y -= 1000)
+    scroll_to (&live, y);
+  scroll_to (&live, 0);
+
+  /* Wiggling across a row boundary doesn't reload anything. */
+  scroll_to (&live, 10 * ROW_PITCH);
+  loads = n_loads;
+  for (i = 0; i < 100; i++)
+    scroll_to (&live, 10 * ROW_PITCH + (i % 2 ? 20 : -20));
+  g_assert (n_loads == loads);
+
+  /* Every load has its unload. */
+  hd_launcher_grid_range_update (&live, &none, KEEP, set_row_live, NULL);
+  g_assert (n_loaded == 0);
+  g_assert (n_loads == n_unloads);
+  g_assert (live.first == live.last);
+
+  printf ("%s: ok, %u rows loaded while scrolling through %d\n",
+          __FILE__, n_loads, N_ROWS);
+  return 0;
+}
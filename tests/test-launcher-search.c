@@ -0,0 +1,387 @@
+/* Writes a few thousand synthetic .desktop files, indexes them like the
+ * launcher tree does, and types the names and programs of some of them
+ * one character at a time, checking after every keystroke that the
+ * results are exactly what a brute force search finds, in the same order.
+ * Then it renames, removes, adds and hands over items like reloading the
+ * tree does, and types again.  The slowest keystroke must take less than
+ * a bound, given in milliseconds on the command line. */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "hd-launcher-search.h"
+
+#define N_ITEMS       3000
+#define N_NEW         50
+#define N_TYPED       200
+#define REPEATS       3
+#define DEFAULT_BOUND 5 /* ms */
+
+typedef struct
+{
+  gchar *name, *exec;
+
+  /* What the index should find them by. */
+  gchar *name_key, *exec_key, *collate_key;
+} Item;
+
+static const gchar *syllables[] =
+{
+  "ca", "fé", "Me", "ra", "ton", "il", "ler", "Ö", "st", "gi", "nu",
+  "x", "pho", "ne", "Bo", "ed", "it", "ma", "ps", "Ča", "lc", " ",
+};
+
+static GRand *rnd;
+static GPtrArray *live;
+
+static gint64 now_us (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static gchar *fold (const gchar *str)
+{
+  gchar *normal, *folded;
+
+  normal = g_utf8_normalize (str, -1, G_NORMALIZE_ALL);
+  folded = g_utf8_casefold (normal, -1);
+  g_free (normal);
+  return folded;
+}
+
+static gchar *random_name (gint i)
+{
+  gchar *name, *tmp;
+  gint n;
+
+  name = g_strdup (syllables[g_rand_int_range (rnd, 0, 10)]);
+  for (n = g_rand_int_range (rnd, 1, 5); n > 0; n--)
+    {
+      tmp = name;
+      name = g_strdup_printf ("%s%s", name,
+                 syllables[g_rand_int_range (rnd, 0, G_N_ELEMENTS (syllables))]);
+      g_free (tmp);
+    }
+
+  /* Some namesakes. */
+  if (i % 10)
+    {
+      tmp = name;
+      name = g_strdup_printf ("%s %d", name, i);
+      g_free (tmp);
+    }
+
+  return name;
+}
+
+/* Writes a .desktop file for item @i in @dir and loads it back. */
+static Item *new_item (const gchar *dir, gint i, const gchar *name)
+{
+  gchar *fname, *contents, *exec;
+  GKeyFile *key_file;
+  Item *item;
+
+  /* Some are D-Bus services without an Exec. */
+  exec = i % 7 ? g_strdup_printf ("Exec=/usr/bin/%s-%d %%U\n",
+                                  syllables[i % 10], i)
+               : g_strdup ("");
+  contents = g_strdup_printf ("[Desktop Entry]\nType=Application\n"
+                              "Name=%s\n%sIcon=icon-%d\n", name, exec, i);
+  fname = g_strdup_printf ("%s/item-%d.desktop", dir, i);
+  g_assert (g_file_set_contents (fname, contents, -1, NULL));
+
+  item = g_new0 (Item, 1);
+  key_file = g_key_file_new ();
+  g_assert (g_key_file_load_from_file (key_file, fname, 0, NULL));
+  item->name = g_key_file_get_locale_string (key_file, "Desktop Entry",
+                                             "Name", NULL, NULL);
+  item->exec = g_key_file_get_string (key_file, "Desktop Entry",
+                                      "Exec", NULL);
+  g_key_file_free (key_file);
+  unlink (fname);
+
+  item->name_key = fold (item->name);
+  item->collate_key = g_utf8_collate_key (item->name_key, -1);
+  if (item->exec)
+    {
+      gchar *prog, *base;
+
+      prog = g_strndup (item->exec, strcspn (item->exec, " "));
+      base = g_path_get_basename (prog);
+      item->exec_key = fold (base);
+      g_free (base);
+      g_free (prog);
+    }
+
+  g_free (fname);
+  g_free (contents);
+  g_free (exec);
+  return item;
+}
+
+static void free_item (Item *item)
+{
+  g_free (item->name);
+  g_free (item->exec);
+  g_free (item->name_key);
+  g_free (item->exec_key);
+  g_free (item->collate_key);
+  g_free (item);
+}
+
+static gboolean has_prefix (const Item *item, const gchar *key)
+{
+  return g_str_has_prefix (item->name_key, key)
+    || (item->exec_key && g_str_has_prefix (item->exec_key, key));
+}
+
+static gint cmp_items (gconstpointer a, gconstpointer b, gpointer key)
+{
+  const Item *ia = *(const Item **)a, *ib = *(const Item **)b;
+  gint cmp;
+
+  if (has_prefix (ia, key) != has_prefix (ib, key))
+    return has_prefix (ia, key) ? -1 : 1;
+  if ((cmp = strcmp (ia->collate_key, ib->collate_key)) != 0)
+    return cmp;
+  return ia < ib ? -1 : ia > ib;
+}
+
+/* What should be found for @text. */
+static GPtrArray *brute_force (const gchar *text)
+{
+  GPtrArray *found;
+  gchar *key;
+  guint i;
+
+  found = g_ptr_array_new ();
+  key = fold (text);
+  for (i = 0; i < live->len; i++)
+    {
+      Item *item = g_ptr_array_index (live, i);
+
+      if (strstr (item->name_key, key)
+          || (item->exec_key && strstr (item->exec_key, key)))
+        g_ptr_array_add (found, item);
+    }
+  g_ptr_array_sort_with_data (found, cmp_items, key);
+  g_free (key);
+
+  return found;
+}
+
+/* Types @text into @search and returns the slowest keystroke in us. */
+static gint64 type (HdLauncherSearch *search, const gchar *text,
+                    guint *nqueries)
+{
+  const gchar *end;
+  gint64 t, best, worst;
+
+  worst = 0;
+  for (end = g_utf8_next_char (text); ; end = g_utf8_next_char (end))
+    {
+      gchar *typed = g_strndup (text, end - text);
+      GPtrArray *found, *expected;
+      guint i;
+
+      /* The best of a few, so being preempted doesn't count. */
+      best = G_MAXINT64;
+      for (i = 0; i < REPEATS; i++)
+        {
+          t = now_us ();
+          found = hd_launcher_search_query (search, typed);
+          t = now_us () - t;
+          if (t < best)
+            best = t;
+          if (i < REPEATS - 1)
+            g_ptr_array_free (found, TRUE);
+        }
+      if (best > worst)
+        worst = best;
+      (*nqueries)++;
+
+      expected = brute_force (typed);
+      if (found->len != expected->len)
+        {
+          fprintf (stderr, "'%s': %u found, %u expected\n",
+                   typed, found->len, expected->len);
+          exit (1);
+        }
+      for (i = 0; i < found->len; i++)
+        g_assert (g_ptr_array_index (found, i)
+                  == g_ptr_array_index (expected, i));
+      /* Typing what we're typing finds at least that. */
+      g_assert (found->len > 0);
+
+      g_ptr_array_free (found, TRUE);
+      g_ptr_array_free (expected, TRUE);
+      g_free (typed);
+      if (!*end)
+        break;
+    }
+
+  return worst;
+}
+
+static gint64 type_some (HdLauncherSearch *search, guint *nqueries)
+{
+  gint64 t, worst;
+  gint i;
+
+  worst = 0;
+  for (i = 0; i < N_TYPED; i++)
+    {
+      Item *item = g_ptr_array_index (live,
+                              g_rand_int_range (rnd, 0, live->len));
+      gchar *text;
+
+      /* Type the program name now and then. */
+      if (i % 4 == 3 && item->exec)
+        {
+          text = item->exec + strlen ("/usr/bin/");
+          text = g_strndup (text, strcspn (text, " "));
+        }
+      else
+        text = g_strdup (item->name);
+
+      if ((t = type (search, text, nqueries)) > worst)
+        worst = t;
+      g_free (text);
+    }
+
+  return worst;
+}
+
+int main (int argc, char **argv)
+{
+  gchar dir[] = "/tmp/test-launcher-search-XXXXXX";
+  HdLauncherSearch *search;
+  GPtrArray *found, *old;
+  gint64 t, worst;
+  guint nqueries, i;
+  gint bound;
+
+  bound = argc > 1 ? atoi (argv[1]) : DEFAULT_BOUND;
+  rnd = g_rand_new_with_seed (050);
+  g_assert (mkdtemp (dir) != NULL);
+
+  live = g_ptr_array_new ();
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      gchar *name = random_name (i);
+      g_ptr_array_add (live, new_item (dir, i, name));
+      g_free (name);
+    }
+
+  search = hd_launcher_search_new ();
+  t = now_us ();
+  for (i = 0; i < live->len; i++)
+    {
+      Item *item = g_ptr_array_index (live, i);
+      hd_launcher_search_add (search, item, item->name, item->exec);
+    }
+  t = now_us () - t;
+  printf ("indexed %u items in %.1f ms\n", live->len, t / 1000.0);
+  g_assert (hd_launcher_search_size (search) == N_ITEMS);
+
+  /* Nothing, or nothing typed, finds nothing. */
+  found = hd_launcher_search_query (search, "");
+  g_assert (found->len == 0);
+  g_ptr_array_free (found, TRUE);
+  found = hd_launcher_search_query (search, "qqqq");
+  g_assert (found->len == 0);
+  g_ptr_array_free (found, TRUE);
+
+  /* Case and accents are what they are in the names, or not. */
+  nqueries = 0;
+  type (search, "FÉ", &nqueries);
+  type (search, "cA", &nqueries);
+
+  worst = type_some (search, &nqueries);
+
+  /* Reload: every tenth is renamed, every twentieth goes, and some come.
+   * The new items are made first so only the index is timed. */
+  old = live;
+  live = g_ptr_array_new ();
+  for (i = 0; i < old->len; i++)
+    {
+      Item *item = g_ptr_array_index (old, i);
+      gchar *name;
+
+      name = i % 10 == 2 ? g_strdup_printf ("%s Pro", item->name)
+                         : g_strdup (item->name);
+      g_ptr_array_add (live, i % 20 == 1 ? NULL : new_item (dir, i, name));
+      g_free (name);
+    }
+  for (i = 0; i < N_NEW; i++)
+    {
+      gchar *name = random_name (N_ITEMS + i);
+      g_ptr_array_add (live, new_item (dir, N_ITEMS + i, name));
+      g_free (name);
+    }
+
+  t = now_us ();
+  for (i = 0; i < live->len; i++)
+    {
+      Item *item = i < old->len ? g_ptr_array_index (old, i) : NULL;
+      Item *copy = g_ptr_array_index (live, i);
+
+      if (copy)
+        hd_launcher_search_update (search, item, copy,
+                                   copy->name, copy->exec);
+      else
+        hd_launcher_search_remove (search, item);
+    }
+  t = now_us () - t;
+
+  for (i = 0; i < live->len; )
+    if (!g_ptr_array_index (live, i))
+      g_ptr_array_remove_index_fast (live, i);
+    else
+      i++;
+  printf ("reloaded %u items in %.1f ms\n", live->len, t / 1000.0);
+  g_assert (hd_launcher_search_size (search) == live->len);
+  g_ptr_array_foreach (old, (GFunc)free_item, NULL);
+  g_ptr_array_free (old, TRUE);
+
+  type (search, "pro", &nqueries);
+  t = type_some (search, &nqueries);
+  if (t > worst)
+    worst = t;
+
+  /* Most go, which drops them from the index for real. */
+  for (i = live->len; i-- > 0; )
+    if (i % 3)
+      {
+        hd_launcher_search_remove (search, g_ptr_array_index (live, i));
+        free_item (g_ptr_array_remove_index_fast (live, i));
+      }
+  g_assert (hd_launcher_search_size (search) == live->len);
+  t = type_some (search, &nqueries);
+  if (t > worst)
+    worst = t;
+
+  printf ("%u keystrokes: %.2f ms worst\n", nqueries, worst / 1000.0);
+
+  hd_launcher_search_free (search);
+  g_ptr_array_foreach (live, (GFunc)free_item, NULL);
+  g_ptr_array_free (live, TRUE);
+  g_rand_free (rnd);
+  rmdir (dir);
+
+  if (worst > bound * 1000)
+    {
+      fprintf (stderr, "a keystroke took more than %d ms\n", bound);
+      return 1;
+    }
+
+  printf ("%s: ok\n", __FILE__);
+  return 0;
+}
@@ -0,0 +1,185 @@
+/* Maps a lot of windows, then activates random ones of them and measures
+ * how long it takes until the WM reports them as active.  Every round
+ * restacks the whole stack.  To see how much of that is spent in the
+ * compositor, run hildon-desktop with $HILDON_DESKTOP_TRACE set and look
+ * at the hd_render_manager_restack spans in the trace. */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <sys/time.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+
+#define DEFAULT_WINDOWS 120
+#define ROUNDS          200
+#define TIMEOUT         2000 /* ms */
+
+static double now_ms (void)
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void set_window_type (Display *dpy, Window w)
+{
+  Atom w_type, normal;
+
+  w_type = XInternAtom (dpy, "_NET_WM_WINDOW_TYPE", False);
+  normal = XInternAtom (dpy, "_NET_WM_WINDOW_TYPE_NORMAL", False);
+
+  XChangeProperty (dpy, w, w_type,
+                   XA_ATOM, 32, PropModeReplace,
+                   (unsigned char *) &normal, 1);
+}
+
+static void set_no_transitions (Display *dpy, Window w)
+{
+  Atom no_trans;
+  int one = 1;
+
+  no_trans = XInternAtom (dpy, "_HILDON_WM_ACTION_NO_TRANSITIONS", False);
+
+  XChangeProperty (dpy, w, no_trans,
+                   XA_CARDINAL, 32, PropModeReplace,
+                   (unsigned char *)&one, 1);
+}
+
+static void activate_window (Display *dpy, Window w)
+{
+  XClientMessageEvent xclient;
+
+  memset (&xclient, 0, sizeof (xclient));
+  xclient.type = ClientMessage;
+  xclient.window = w;
+  xclient.message_type = XInternAtom (dpy, "_NET_ACTIVE_WINDOW", False);
+  xclient.format = 32;
+  xclient.data.l[0] = 1; /* requestor type; we're an app */
+  xclient.data.l[1] = CurrentTime;
+
+  XSendEvent (dpy, DefaultRootWindow (dpy), False,
+              SubstructureRedirectMask | SubstructureNotifyMask,
+              (XEvent *)&xclient);
+}
+
+static Window get_active_window (Display *dpy)
+{
+  Atom type;
+  int format;
+  unsigned long n, left;
+  unsigned char *data = NULL;
+  Window w = None;
+
+  if (XGetWindowProperty (dpy, DefaultRootWindow (dpy),
+                          XInternAtom (dpy, "_NET_ACTIVE_WINDOW", False),
+                          0, 1, False, XA_WINDOW, &type, &format,
+                          &n, &left, &data) == Success && data)
+    {
+      if (n == 1)
+        w = *(Window *)data;
+      XFree (data);
+    }
+
+  return w;
+}
+
+/* Returns FALSE if @w didn't become active in time. */
+static int wait_active (Display *dpy, Window w)
+{
+  double start = now_ms ();
+  XEvent ev;
+
+  while (get_active_window (dpy) != w)
+    {
+      while (XPending (dpy))
+        XNextEvent (dpy, &ev);
+      if (now_ms () - start > TIMEOUT)
+        return 0;
+      usleep (100);
+    }
+
+  return 1;
+}
+
+static Window new_window (Display *dpy, int i)
+{
+  char name[32];
+  Window w;
+
+  w = XCreateSimpleWindow (dpy, DefaultRootWindow (dpy),
+                           0, 0, 800, 424, 0,
+                           BlackPixel (dpy, DefaultScreen (dpy)),
+                           WhitePixel (dpy, DefaultScreen (dpy)));
+  sprintf (name, "restack %d", i);
+  XStoreName (dpy, w, name);
+  set_window_type (dpy, w);
+  set_no_transitions (dpy, w);
+  XMapWindow (dpy, w);
+
+  return w;
+}
+
+int main (int argc, char **argv)
+{
+  Display *dpy;
+  Window *wins;
+  double t, total, worst;
+  int nwins, i, done;
+
+  nwins = argc > 1 ? atoi (argv[1]) : DEFAULT_WINDOWS;
+  if (nwins < 2)
+    nwins = 2;
+
+  if (!(dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "couldn't open display\n");
+      return 1;
+    }
+  XSelectInput (dpy, DefaultRootWindow (dpy), PropertyChangeMask);
+
+  printf ("mapping %d windows\n", nwins);
+  wins = calloc (nwins, sizeof (*wins));
+  for (i = 0; i < nwins; i++)
+    wins[i] = new_window (dpy, i);
+  XSync (dpy, False);
+  if (!wait_active (dpy, wins[nwins - 1]))
+    fprintf (stderr, "the last window never became active\n");
+
+  total = worst = 0;
+  srand (1);
+  for (done = i = 0; i < ROUNDS; i++)
+    {
+      Window w;
+
+      /* Never the one which is active already. */
+      do
+        w = wins[rand () % nwins];
+      while (w == get_active_window (dpy));
+
+      t = now_ms ();
+      activate_window (dpy, w);
+      XFlush (dpy);
+      if (!wait_active (dpy, w))
+        {
+          fprintf (stderr, "window %lx didn't become active\n", w);
+          continue;
+        }
+      t = now_ms () - t;
+
+      total += t;
+      if (t > worst)
+        worst = t;
+      done++;
+    }
+
+  if (done)
+    printf ("%d restacks of %d windows: %.2f ms average, %.2f ms worst\n",
+            done, nwins, total / done, worst);
+
+  XCloseDisplay (dpy);
+  return 0;
+}
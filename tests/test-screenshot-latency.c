@@ -0,0 +1,123 @@
+/* Grabs the screen and saves it with hd-screenshot over and over, and
+ * checks that the main loop keeps running meanwhile: the longest time
+ * between two ticks of a short timeout must stay under a bound, given
+ * in milliseconds on the command line.  Run it under Xvfb, or any X
+ * server with a big screen.  Also checks that saves of the same file
+ * coalesce and that no half-written files are left behind. */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "hd-screenshot.h"
+
+#define DEFAULT_BOUND 50  /* ms */
+#define TICK          5   /* ms */
+#define GRAB_INTERVAL 40  /* ms */
+#define ROUNDS        50
+
+static GMainLoop *loop;
+static gchar *dir;
+static gint64 last_tick, worst_gap;
+static guint rounds, in_flight, saved, coalesced;
+
+static gint64 now_ms (void)
+{
+  GTimeVal tv;
+
+  g_get_current_time (&tv);
+  return (gint64)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static gboolean tick (gpointer unused)
+{
+  gint64 now = now_ms ();
+
+  if (last_tick && now - last_tick > worst_gap)
+    worst_gap = now - last_tick;
+  last_tick = now;
+  return TRUE;
+}
+
+static void done (const gchar *filename, gboolean ok, gpointer unused)
+{
+  g_assert (ok);
+  g_assert (g_file_test (filename, G_FILE_TEST_EXISTS));
+  g_assert (!hd_screenshot_is_saving (filename));
+  saved++;
+  if (!--in_flight && rounds >= ROUNDS)
+    g_main_loop_quit (loop);
+}
+
+static gboolean grab (gpointer unused)
+{
+  GdkWindow *root;
+  GdkPixbuf *pixbuf;
+  gchar *fname;
+  int width, height, i;
+
+  root = gdk_get_default_root_window ();
+  gdk_drawable_get_size (root, &width, &height);
+  pixbuf = gdk_pixbuf_get_from_drawable (NULL, root,
+                                         gdk_drawable_get_colormap (root),
+                                         0, 0, 0, 0, width, height);
+  g_assert (pixbuf);
+
+  /* Every second round asks for the same file twice in a row;
+   * the second one must be turned away. */
+  fname = g_strdup_printf ("%s/shot-%u.png", dir, rounds % 4);
+  for (i = 0; i < (rounds % 2 ? 2 : 1); i++)
+    if (hd_screenshot_save (pixbuf, fname, HD_SCREENSHOT_PNG, done, NULL))
+      in_flight++;
+    else
+      coalesced++;
+  g_free (fname);
+  g_object_unref (pixbuf);
+
+  return ++rounds < ROUNDS;
+}
+
+int main (int argc, char **argv)
+{
+  GDir *d;
+  const gchar *name;
+  gint64 bound;
+
+  gtk_init (&argc, &argv);
+  bound = argc > 1 ? atoi (argv[1]) : DEFAULT_BOUND;
+
+  dir = g_strdup ("/tmp/test-screenshot-XXXXXX");
+  g_assert (mkdtemp (dir));
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add (TICK, tick, NULL);
+  g_timeout_add (GRAB_INTERVAL, grab, NULL);
+  g_main_loop_run (loop);
+
+  printf ("%u screenshots saved, %u coalesced, "
+          "longest main loop stall %d ms (bound %d ms)\n",
+          saved, coalesced, (int)worst_gap, (int)bound);
+  g_assert (coalesced >= ROUNDS / 2);
+  g_assert (saved + coalesced == ROUNDS + ROUNDS / 2);
+
+  /* Only the finished files are left. */
+  d = g_dir_open (dir, 0, NULL);
+  while ((name = g_dir_read_name (d)) != NULL)
+    {
+      gchar *path = g_build_filename (dir, name, NULL);
+
+      g_assert (g_str_has_suffix (name, ".png"));
+      g_unlink (path);
+      g_free (path);
+    }
+  g_dir_close (d);
+  g_rmdir (dir);
+
+  if (worst_gap > bound)
+    {
+      fprintf (stderr, "the main loop was blocked for too long\n");
+      return 1;
+    }
+  return 0;
+}
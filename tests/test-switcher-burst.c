@@ -0,0 +1,257 @@
+/* Maps a burst of windows, then destroys them all, and counts how many
+ * times the task switcher laid itself out meanwhile and how many
+ * thumbnails it moved.  Run hildon-desktop with $HILDON_DESKTOP_TRACE set,
+ * not in the task switcher, and this test with the same $HILDON_DESKTOP_TRACE
+ * and the pid of hildon-desktop on the command line; it makes it write the
+ * trace with SIGUSR1 and reads the task_navigator_layout events from it.
+ * Laying out once per window coming or going, or moving every thumbnail
+ * every time, is a failure. */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#define DEFAULT_WINDOWS 50
+#define TIMEOUT         5000 /* ms */
+#define SETTLE          200  /* ms */
+
+/* In the same clock as hd_trace_now(). */
+static long long now_us (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void set_window_type (Display *dpy, Window w)
+{
+  Atom w_type, normal;
+
+  w_type = XInternAtom (dpy, "_NET_WM_WINDOW_TYPE", False);
+  normal = XInternAtom (dpy, "_NET_WM_WINDOW_TYPE_NORMAL", False);
+
+  XChangeProperty (dpy, w, w_type,
+                   XA_ATOM, 32, PropModeReplace,
+                   (unsigned char *) &normal, 1);
+}
+
+static void set_no_transitions (Display *dpy, Window w)
+{
+  Atom no_trans;
+  int one = 1;
+
+  no_trans = XInternAtom (dpy, "_HILDON_WM_ACTION_NO_TRANSITIONS", False);
+
+  XChangeProperty (dpy, w, no_trans,
+                   XA_CARDINAL, 32, PropModeReplace,
+                   (unsigned char *)&one, 1);
+}
+
+static Window new_window (Display *dpy, int i)
+{
+  char name[32];
+  Window w;
+
+  w = XCreateSimpleWindow (dpy, DefaultRootWindow (dpy),
+                           0, 0, 800, 424, 0,
+                           BlackPixel (dpy, DefaultScreen (dpy)),
+                           WhitePixel (dpy, DefaultScreen (dpy)));
+  sprintf (name, "burst %d", i);
+  XStoreName (dpy, w, name);
+  set_window_type (dpy, w);
+  set_no_transitions (dpy, w);
+  XMapWindow (dpy, w);
+
+  return w;
+}
+
+/* Returns the number of windows the WM manages. */
+static unsigned long count_clients (Display *dpy)
+{
+  Atom type;
+  int format;
+  unsigned long n = 0, left;
+  unsigned char *data = NULL;
+
+  if (XGetWindowProperty (dpy, DefaultRootWindow (dpy),
+                          XInternAtom (dpy, "_NET_CLIENT_LIST", False),
+                          0, 1024, False, XA_WINDOW, &type, &format,
+                          &n, &left, &data) == Success && data)
+    XFree (data);
+
+  return n;
+}
+
+/* Returns 0 if the WM didn't get to manage @n windows in time. */
+static int wait_clients (Display *dpy, unsigned long n)
+{
+  long long start = now_us ();
+  XEvent ev;
+
+  while (count_clients (dpy) != n)
+    {
+      while (XPending (dpy))
+        XNextEvent (dpy, &ev);
+      if (now_us () - start > TIMEOUT * 1000LL)
+        return 0;
+      usleep (1000);
+    }
+
+  return 1;
+}
+
+/* Makes @pid write its trace to @fname and returns its contents. */
+static char *get_trace (pid_t pid, const char *fname)
+{
+  long long start;
+  struct stat sbuf;
+  char *json;
+  FILE *f;
+
+  /* The trace is written to a temporary file and renamed,
+   * so once it's there it's complete. */
+  unlink (fname);
+  if (kill (pid, SIGUSR1) < 0)
+    {
+      perror ("kill");
+      return NULL;
+    }
+
+  start = now_us ();
+  while (stat (fname, &sbuf) < 0)
+    {
+      if (now_us () - start > TIMEOUT * 1000LL)
+        {
+          fprintf (stderr, "%s didn't appear\n", fname);
+          return NULL;
+        }
+      usleep (10000);
+    }
+
+  if (!(f = fopen (fname, "r")))
+    {
+      perror (fname);
+      return NULL;
+    }
+  json = calloc (1, sbuf.st_size + 1);
+  fread (json, 1, sbuf.st_size, f);
+  fclose (f);
+
+  return json;
+}
+
+/* Counts the task_navigator_layout events since @since in @json
+ * and the moves they report. */
+static void count_layouts (const char *json, long long since,
+                           int *passes, int *moves)
+{
+  const char *ev, *end, *p;
+  long long ts;
+
+  *passes = *moves = 0;
+  for (ev = json; (ev = strstr (ev, "{\"name\":\"task_navigator_layout\""));
+       ev = end)
+    {
+      if (!(end = strchr (ev, '\n')))
+        end = ev + strlen (ev);
+
+      if (!(p = strstr (ev, "\"ts\":")) || p > end)
+        continue;
+      ts = atoll (p + strlen ("\"ts\":"));
+      if (ts < since)
+        continue;
+
+      (*passes)++;
+      /* No "args" means no moves. */
+      if ((p = strstr (ev, "\"arg\":")) && p < end)
+        *moves += atoi (p + strlen ("\"arg\":"));
+    }
+}
+
+int main (int argc, char **argv)
+{
+  Display *dpy;
+  Window *wins;
+  const char *fname;
+  char *json;
+  long long start;
+  unsigned long nclients;
+  int nwins, i, passes, moves, failed;
+  pid_t pid;
+
+  if (argc < 2 || !(fname = getenv ("HILDON_DESKTOP_TRACE")))
+    {
+      fprintf (stderr, "usage: HILDON_DESKTOP_TRACE=<trace file> "
+               "%s <hildon-desktop pid> [windows]\n", argv[0]);
+      return 1;
+    }
+  pid = atoi (argv[1]);
+  nwins = argc > 2 ? atoi (argv[2]) : DEFAULT_WINDOWS;
+  if (nwins < 2)
+    nwins = 2;
+
+  if (!(dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "couldn't open display\n");
+      return 1;
+    }
+  XSelectInput (dpy, DefaultRootWindow (dpy), PropertyChangeMask);
+  nclients = count_clients (dpy);
+
+  start = now_us ();
+  printf ("mapping %d windows\n", nwins);
+  wins = calloc (nwins, sizeof (*wins));
+  for (i = 0; i < nwins; i++)
+    wins[i] = new_window (dpy, i);
+  XSync (dpy, False);
+  if (!wait_clients (dpy, nclients + nwins))
+    fprintf (stderr, "not all windows were managed\n");
+
+  /* Newest first, the way they're stacked. */
+  printf ("destroying them\n");
+  for (i = nwins - 1; i >= 0; i--)
+    XDestroyWindow (dpy, wins[i]);
+  XSync (dpy, False);
+  if (!wait_clients (dpy, nclients))
+    fprintf (stderr, "not all windows were unmanaged\n");
+
+  /* Let the last layout happen. */
+  usleep (SETTLE * 1000);
+
+  if (!(json = get_trace (pid, fname)))
+    return 1;
+  count_layouts (json, start, &passes, &moves);
+  free (json);
+
+  printf ("%d windows came and went: %d layouts, %d thumbnails moved\n",
+          nwins, passes, moves);
+
+  failed = 0;
+  if (!passes)
+    {
+      fprintf (stderr, "no layouts traced, is hildon-desktop tracing?\n");
+      failed = 1;
+    }
+  if (passes >= nwins)
+    {
+      fprintf (stderr, "the layouts weren't batched\n");
+      failed = 1;
+    }
+  if (moves > 4 * nwins)
+    {
+      fprintf (stderr, "thumbnails were moved needlessly\n");
+      failed = 1;
+    }
+
+  XCloseDisplay (dpy);
+  return failed;
+}